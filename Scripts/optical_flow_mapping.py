@@ -44,6 +44,20 @@ def load_optical_flow(optical_flow_image_path: str, use_cuda: bool) -> torch.Ten
     return flow
 
 
+def load_occlusion_mask(occlusion_mask_path: str, use_cuda: bool) -> torch.Tensor:
+    """
+    Loads an occlusion mask from an .exr or .png image and returns it as a tensor with shape (1, h, w),
+    containing ones for consistent pixels and zeros for occluded ones.
+    """
+    mask_image = cv2.imread(occlusion_mask_path, cv2.IMREAD_ANYCOLOR | cv2.IMREAD_ANYDEPTH)
+    if mask_image.ndim == 3:
+        mask_image = mask_image[:, :, 0]
+    mask = torch.Tensor((mask_image > 0.5 * mask_image.max()).astype(np.float32)).unsqueeze(0)
+    if use_cuda:
+        mask = mask.cuda()
+    return mask
+
+
 def map_optical_flow(base_image: torch.Tensor, optical_flow: torch.Tensor) -> torch.Tensor:
     """
     Moves pixels in the base image according to the optical flow.
@@ -110,6 +124,12 @@ if __name__ == '__main__':
         'output_image_path',
         type=str,
         help='Path to the output image')
+    parser.add_argument(
+        '--occlusion_mask_path',
+        '-m',
+        type=str,
+        default=None,
+        help='Path to the occlusion mask of the optical flow image, occluded pixels are set to black')
     parser.add_argument(
         '--use_cuda',
         '-c',
@@ -126,5 +146,9 @@ if __name__ == '__main__':
     # Generate the mapped image
     mapped_image = map_optical_flow(base_image, flow)
 
+    # Pixels that were not visible in the base image cannot be mapped
+    if args.occlusion_mask_path is not None:
+        mapped_image = mapped_image * load_occlusion_mask(args.occlusion_mask_path, args.use_cuda)
+
     # Store tensor as image
     store_image(args.output_image_path, mapped_image)
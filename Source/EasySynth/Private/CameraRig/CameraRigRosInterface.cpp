@@ -217,6 +217,26 @@ bool FCameraRigRosInterface::ExportCameraRig(
 	return true;
 }
 
+FCameraRigData::FCameraData FCameraRigRosInterface::GetCameraData(UCameraComponent* Camera, const FIntPoint& SensorSize)
+{
+	FCameraRigData::FCameraData CameraData;
+	CameraData.CameraName = FPathUtils::GetCameraName(Camera);
+	CameraData.SensorSize = SensorSize;
+
+	// Calculate intrinsics
+	CameraData.FocalLength = SensorSize.X / UKismetMathLibrary::DegTan(Camera->FieldOfView / 2.0f) / 2.0f;
+	CameraData.PrincipalPointX = SensorSize.X / 2.0f;
+	CameraData.PrincipalPointY = SensorSize.Y / 2.0f;
+
+	// Prepare transform
+	CameraData.Transform = Camera->GetRelativeTransform();
+	// Remove the scaling that makes no impact on camera functionality,
+	// but my be used to scale the camera placeholder mesh as user desires
+	CameraData.Transform.SetScale3D(FVector(1.0f, 1.0f, 1.0f));
+
+	return CameraData;
+}
+
 void FCameraRigRosInterface::AddCamera(
 	const int CameraId,
 	UCameraComponent* Camera,
@@ -224,25 +244,18 @@ void FCameraRigRosInterface::AddCamera(
 	FRosJsonContent& RosJsonContent)
 {
 	FRosJsonCamera RosJsonCamera;
+	const FCameraRigData::FCameraData CameraData = GetCameraData(Camera, SensorSize);
 
 	// Add intrinsics
-	const double FocalLength = SensorSize.X / UKismetMathLibrary::DegTan(Camera->FieldOfView / 2.0f) / 2.0f;
-	const double PrincipalPointX = SensorSize.X / 2.0f;
-	const double PrincipalPointY = SensorSize.Y / 2.0f;
 	RosJsonCamera.intrinsics.Init(0, 9);
-	RosJsonCamera.intrinsics[0] = FocalLength;
-	RosJsonCamera.intrinsics[2] = PrincipalPointX;
-	RosJsonCamera.intrinsics[4] = FocalLength;
-	RosJsonCamera.intrinsics[5] = PrincipalPointY;
+	RosJsonCamera.intrinsics[0] = CameraData.FocalLength;
+	RosJsonCamera.intrinsics[2] = CameraData.PrincipalPointX;
+	RosJsonCamera.intrinsics[4] = CameraData.FocalLength;
+	RosJsonCamera.intrinsics[5] = CameraData.PrincipalPointY;
 	RosJsonCamera.intrinsics[8] = 1.0f;
 
-	// Prepare transform
-	FTransform Transform = Camera->GetRelativeTransform();
-	// Remove the scaling that makes no impact on camera functionality,
-	// but my be used to scale the camera placeholder mesh as user desires
-	Transform.SetScale3D(FVector(1.0f, 1.0f, 1.0f));
-
 	// Add translation
+	const FTransform& Transform = CameraData.Transform;
 	const FVector Translation = Transform.GetTranslation();
 	RosJsonCamera.translation.Add(Translation.X);
 	RosJsonCamera.translation.Add(Translation.Y);
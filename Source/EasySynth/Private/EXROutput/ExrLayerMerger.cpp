@@ -0,0 +1,258 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "EXROutput/ExrLayerMerger.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "ImagePixelData.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "EasySynth.h"
+
+#if WITH_UNREALEXR
+THIRD_PARTY_INCLUDES_START
+#include "OpenEXR/ImfStringAttribute.h"
+THIRD_PARTY_INCLUDES_END
+#endif // WITH_UNREALEXR
+
+
+#if WITH_UNREALEXR
+
+/** Reads an EXR file already loaded into memory */
+class FExrMemStreamInLocal : public Imf::IStream
+{
+public:
+	FExrMemStreamInLocal(const TArray64<uint8>& InData)
+		: Imf::IStream("")
+		, Data(InData)
+		, Pos(0)
+	{
+	}
+
+	virtual bool read(char c[/*n*/], int InN) override
+	{
+		if (Pos + InN > Data.Num())
+		{
+#if WITH_EDITOR
+			throw IEX_NAMESPACE::InputExc("Unexpected end of file.");
+#else
+			FMemory::Memzero(c, InN);
+			return false;
+#endif
+		}
+
+		FMemory::Memcpy(c, Data.GetData() + Pos, InN);
+		Pos += InN;
+		return Pos < Data.Num();
+	}
+
+	virtual uint64_t tellg() override
+	{
+		return Pos;
+	}
+
+	virtual void seekg(uint64_t InPos) override
+	{
+		Pos = InPos;
+	}
+
+private:
+	const TArray64<uint8>& Data;
+	int64 Pos;
+};
+
+/** Reads the RGBA channels of the unnamed layer into the interleaved pixel type */
+template <typename PixelType>
+static TUniquePtr<FImagePixelData> ReadRGBA(Imf::InputFile& InFile, const Imf::PixelType InChannelType)
+{
+	const Imath::Box2i& DataWindow = InFile.header().dataWindow();
+	const FIntPoint Size(DataWindow.max.x - DataWindow.min.x + 1, DataWindow.max.y - DataWindow.min.y + 1);
+
+	TArray64<PixelType> Pixels;
+	Pixels.SetNumUninitialized(int64(Size.X) * Size.Y);
+
+	// Slice base pointers are relative to the data window origin
+	char* Base = reinterpret_cast<char*>(Pixels.GetData()) -
+		(DataWindow.min.x + int64(DataWindow.min.y) * Size.X) * sizeof(PixelType);
+	const int32 ComponentWidth = sizeof(PixelType) / 4;
+	const char* ChannelNames[] = { "R", "G", "B", "A" };
+
+	Imf::FrameBuffer FrameBuffer;
+	for (int32 Channel = 0; Channel < 4; Channel++)
+	{
+		const double FillValue = (Channel == 3 ? 1.0 : 0.0);
+		FrameBuffer.insert(ChannelNames[Channel], Imf::Slice(
+			InChannelType,
+			Base + Channel * ComponentWidth,
+			sizeof(PixelType),
+			int64(Size.X) * sizeof(PixelType),
+			1,
+			1,
+			FillValue));
+	}
+
+	InFile.setFrameBuffer(FrameBuffer);
+	InFile.readPixels(DataWindow.min.y, DataWindow.max.y);
+
+	return MakeUnique<TImagePixelData<PixelType>>(Size, MoveTemp(Pixels));
+}
+
+#endif // WITH_UNREALEXR
+
+FExrLayerMerger::FExrLayerMerger(const UMoviePipelineImageSequenceOutput_EXRLocal* ExrSetting) :
+	Compression(ExrSetting->Compression),
+	TileSize(ExrSetting->bTiled ? FMath::Max(ExrSetting->TileSize, 1) : 0),
+	bWriteMipLevels(ExrSetting->bTiled && ExrSetting->bMipLevels)
+{}
+
+bool FExrLayerMerger::MergeTargets(const FString& CameraDir, const TArray<FString>& TargetNames) const
+{
+	if (TargetNames.Num() == 0)
+	{
+		return true;
+	}
+
+	// All targets render the same frames, so the first one defines the frame files
+	TArray<FString> FrameFileNames;
+	IFileManager::Get().FindFiles(FrameFileNames, *(CameraDir / TargetNames[0]), TEXT("exr"));
+	FrameFileNames.Sort();
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Frames are independent, each one is read, merged and written on its own worker
+	std::atomic<int32> FailedFrames(0);
+	ParallelFor(FrameFileNames.Num(), [&](const int32 Index)
+	{
+		if (!MergeFrame(CameraDir, TargetNames, FrameFileNames[Index]))
+		{
+			FailedFrames++;
+		}
+	});
+
+	if (FailedFrames > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to merge %d of %d frames inside %s"),
+			*FString(__FUNCTION__), FailedFrames.load(), FrameFileNames.Num(), *CameraDir)
+		return false;
+	}
+
+	// Only the merged files are kept
+	for (const FString& TargetName : TargetNames)
+	{
+		const bool bRequireExists = false;
+		const bool bTree = true;
+		IFileManager::Get().DeleteDirectory(*(CameraDir / TargetName), bRequireExists, bTree);
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Merged %d frames of %d targets in %.2f s"),
+		*FString(__FUNCTION__), FrameFileNames.Num(), TargetNames.Num(), FPlatformTime::Seconds() - StartTime)
+
+	return true;
+}
+
+bool FExrLayerMerger::MergeFrame(
+	const FString& CameraDir,
+	const TArray<FString>& TargetNames,
+	const FString& FrameFileName) const
+{
+#if WITH_UNREALEXR
+	FEXRImageWriteTaskLocal MergedImageTask;
+	MergedImageTask.Filename = CameraDir / FrameFileName;
+	MergedImageTask.Compression = Compression;
+	MergedImageTask.TileSize = TileSize;
+	MergedImageTask.bWriteMipLevels = bWriteMipLevels;
+
+	for (const FString& TargetName : TargetNames)
+	{
+		// Frame metadata is the same for all targets, so it is taken from the first one
+		const FString TargetFilePath = CameraDir / TargetName / FrameFileName;
+		TUniquePtr<FImagePixelData> Layer = ReadImage(
+			TargetFilePath, MergedImageTask.Layers.Num() == 0 ? &MergedImageTask.FileMetadata : nullptr);
+		if (!Layer.IsValid())
+		{
+			return false;
+		}
+
+		if (MergedImageTask.Layers.Num() == 0)
+		{
+			MergedImageTask.Width = Layer->GetSize().X;
+			MergedImageTask.Height = Layer->GetSize().Y;
+		}
+		else if (Layer->GetSize() != FIntPoint(MergedImageTask.Width, MergedImageTask.Height))
+		{
+			UE_LOG(LogEasySynth, Error, TEXT("%s: Resolution of %s does not match the other targets"),
+				*FString(__FUNCTION__), *TargetFilePath)
+			return false;
+		}
+
+		MergedImageTask.LayerNames.Add(Layer.Get(), TargetName);
+		MergedImageTask.Layers.Add(MoveTemp(Layer));
+	}
+
+	return MergedImageTask.RunTask();
+#else
+	UE_LOG(LogEasySynth, Error, TEXT("%s: EXR support is not available"), *FString(__FUNCTION__))
+	return false;
+#endif // WITH_UNREALEXR
+}
+
+TUniquePtr<FImagePixelData> FExrLayerMerger::ReadImage(
+	const FString& FilePath,
+	TMap<FString, FStringFormatArg>* OutStringAttributes)
+{
+#if WITH_UNREALEXR
+	TArray64<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not load %s"), *FString(__FUNCTION__), *FilePath)
+		return nullptr;
+	}
+
+	TUniquePtr<FImagePixelData> Image;
+#if WITH_EDITOR
+	try
+#endif
+	{
+		FExrMemStreamInLocal InputStream(FileData);
+		Imf::InputFile InputFile(InputStream);
+
+		if (OutStringAttributes != nullptr)
+		{
+			for (Imf::Header::ConstIterator It = InputFile.header().begin(); It != InputFile.header().end(); ++It)
+			{
+				// Type names are compared since the module is built without RTTI
+				if (FCStringAnsi::Strcmp(It.attribute().typeName(), Imf::StringAttribute::staticTypeName()) == 0)
+				{
+					const Imf::StringAttribute& StringAttribute = static_cast<const Imf::StringAttribute&>(It.attribute());
+					OutStringAttributes->Add(UTF8_TO_TCHAR(It.name()), UTF8_TO_TCHAR(StringAttribute.value().c_str()));
+				}
+			}
+		}
+
+		// Keep the precision the file was written with
+		const Imf::Channel* RedChannel = InputFile.header().channels().findChannel("R");
+		if (RedChannel != nullptr && RedChannel->type == Imf::FLOAT)
+		{
+			Image = ReadRGBA<FLinearColor>(InputFile, Imf::FLOAT);
+		}
+		else
+		{
+			Image = ReadRGBA<FFloat16Color>(InputFile, Imf::HALF);
+		}
+	}
+#if WITH_EDITOR
+	catch (const IEX_NAMESPACE::BaseExc& Exception)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not read %s: %s"),
+			*FString(__FUNCTION__), *FilePath, UTF8_TO_TCHAR(Exception.what()))
+		return nullptr;
+	}
+#endif
+
+	return Image;
+#else
+	UE_LOG(LogEasySynth, Error, TEXT("%s: EXR support is not available"), *FString(__FUNCTION__))
+	return nullptr;
+#endif // WITH_UNREALEXR
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "EXROutput/MoviePipelineEXROutputLocal.h"
+
+
+/**
+ * Combines per target EXR frames of a camera into a single multi-layer EXR per frame
+ * Settings are copied on construction, so that merging can run on worker threads
+*/
+class FExrLayerMerger
+{
+public:
+	explicit FExrLayerMerger(const UMoviePipelineImageSequenceOutput_EXRLocal* ExrSetting);
+
+	/**
+	 * Merges same named frames from each target directory inside the camera directory
+	 * into one file per frame, with the channels of each target stored as the layer named after it.
+	 * Target directories are removed once all of their frames are merged.
+	*/
+	bool MergeTargets(const FString& CameraDir, const TArray<FString>& TargetNames) const;
+
+	/**
+	 * Reads the unnamed RGBA layer of an EXR file in the precision it was written with,
+	 * optionally also returning its string attributes, returns nullptr on failure
+	*/
+	static TUniquePtr<FImagePixelData> ReadImage(
+		const FString& FilePath,
+		TMap<FString, FStringFormatArg>* OutStringAttributes = nullptr);
+
+private:
+	/** Merges a single frame, returns false if any of the target files could not be read or the result written */
+	bool MergeFrame(const FString& CameraDir, const TArray<FString>& TargetNames, const FString& FrameFileName) const;
+
+	/** Compression of merged files */
+	EEXRCompressionFormatLocal Compression;
+
+	/** Tile size of merged files, zero if they are written as scanlines */
+	int32 TileSize;
+
+	/** Whether tiled merged files also contain mip levels */
+	bool bWriteMipLevels;
+};
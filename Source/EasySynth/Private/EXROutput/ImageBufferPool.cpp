@@ -0,0 +1,114 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "EXROutput/ImageBufferPool.h"
+
+#include "Misc/ScopeLock.h"
+
+#include "EasySynth.h"
+
+
+const int32 FImageBufferPool::NumBuckets = 64;
+const int64 FImageBufferPool::MaxPooledBytes = 2048ll * 1024 * 1024;
+
+FImageBufferPool& FImageBufferPool::Get()
+{
+	static FImageBufferPool ImageBufferPool;
+	return ImageBufferPool;
+}
+
+FImageBufferPool::FImageBufferPool() :
+	PooledBytes(0),
+	PeakPooledBytes(0),
+	NumRequests(0),
+	NumHits(0)
+{
+	Buckets.SetNum(NumBuckets);
+}
+
+TArray64<uint8> FImageBufferPool::Acquire(const int64 MinCapacity)
+{
+	const int32 BucketIndex = AcquireBucketIndex(MinCapacity);
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		NumRequests++;
+
+		// Buffers of the next bucket are accepted too, to reuse slightly larger images
+		for (int32 i = BucketIndex; i < FMath::Min(BucketIndex + 2, NumBuckets); i++)
+		{
+			if (Buckets[i].Num() > 0)
+			{
+				TArray64<uint8> Buffer = Buckets[i].Pop(false);
+				PooledBytes -= Buffer.Max();
+				NumHits++;
+				return Buffer;
+			}
+		}
+	}
+
+	// Allocate a new buffer rounded up to the bucket size, so it can be returned to the same bucket
+	TArray64<uint8> Buffer;
+	Buffer.Reserve(BucketIndex < NumBuckets - 1 ? (1ll << BucketIndex) : MinCapacity);
+	return Buffer;
+}
+
+void FImageBufferPool::Release(TArray64<uint8>&& Buffer)
+{
+	const int64 Capacity = Buffer.Max();
+	if (Capacity == 0)
+	{
+		return;
+	}
+	Buffer.Reset();
+
+	FScopeLock ScopeLock(&Lock);
+	if (PooledBytes + Capacity > MaxPooledBytes)
+	{
+		// The pool is full, let the buffer be freed
+		return;
+	}
+
+	Buckets[ReleaseBucketIndex(Capacity)].Add(MoveTemp(Buffer));
+	PooledBytes += Capacity;
+	PeakPooledBytes = FMath::Max(PeakPooledBytes, PooledBytes);
+}
+
+void FImageBufferPool::Trim()
+{
+	FScopeLock ScopeLock(&Lock);
+	for (TArray<TArray64<uint8>>& Bucket : Buckets)
+	{
+		Bucket.Empty();
+	}
+	PooledBytes = 0;
+}
+
+void FImageBufferPool::LogStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	const double HitRate = NumRequests > 0 ? 100.0 * NumHits / NumRequests : 0.0;
+	UE_LOG(LogEasySynth, Log, TEXT("%s: %lld requests, %.1f%% hit rate, %.1f MiB peak pooled memory, %.1f MiB currently pooled"),
+		*FString(__FUNCTION__),
+		NumRequests,
+		HitRate,
+		PeakPooledBytes / (1024.0 * 1024.0),
+		PooledBytes / (1024.0 * 1024.0))
+}
+
+void FImageBufferPool::ResetStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	NumRequests = 0;
+	NumHits = 0;
+	PeakPooledBytes = PooledBytes;
+}
+
+int32 FImageBufferPool::AcquireBucketIndex(const int64 Capacity)
+{
+	return Capacity <= 1 ? 0 : FMath::Min(64 - static_cast<int32>(FMath::CountLeadingZeros64(Capacity - 1)), NumBuckets - 1);
+}
+
+int32 FImageBufferPool::ReleaseBucketIndex(const int64 Capacity)
+{
+	return FMath::Min(63 - static_cast<int32>(FMath::CountLeadingZeros64(Capacity)), NumBuckets - 1);
+}
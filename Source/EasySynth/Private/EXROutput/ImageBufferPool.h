@@ -0,0 +1,66 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Thread-safe pool of byte buffers used by the image write tasks,
+ * buffers are kept in power of two size buckets and recycled across frames
+ * to avoid allocating and freeing a full resolution buffer for every written image
+*/
+class FImageBufferPool
+{
+public:
+	/** Returns the pool shared by all image write tasks */
+	static FImageBufferPool& Get();
+
+	/** Returns an empty buffer with the capacity of at least MinCapacity bytes */
+	TArray64<uint8> Acquire(const int64 MinCapacity);
+
+	/** Returns the buffer to the pool, the buffer is freed if the pool is already full */
+	void Release(TArray64<uint8>&& Buffer);
+
+	/** Frees all pooled buffers */
+	void Trim();
+
+	/** Logs the pool hit rate and memory usage */
+	void LogStats();
+
+	/** Resets the collected metrics */
+	void ResetStats();
+
+private:
+	FImageBufferPool();
+
+	/** Returns the smallest bucket whose buffers can hold the requested capacity */
+	static int32 AcquireBucketIndex(const int64 Capacity);
+
+	/** Returns the largest bucket the buffer with the received capacity can be stored into */
+	static int32 ReleaseBucketIndex(const int64 Capacity);
+
+	/** Guards all pool members, as buffers are acquired and released from image write threads */
+	FCriticalSection Lock;
+
+	/** Pooled buffers, bucket i holds buffers with the capacity of at least 2^i bytes */
+	TArray<TArray<TArray64<uint8>>> Buckets;
+
+	/** Total capacity of the currently pooled buffers */
+	int64 PooledBytes;
+
+	/** The largest value the PooledBytes reached */
+	int64 PeakPooledBytes;
+
+	/** Number of acquire requests */
+	int64 NumRequests;
+
+	/** Number of acquire requests served by a pooled buffer */
+	int64 NumHits;
+
+	/** Number of bucket indices, covers all 64-bit sizes */
+	static const int32 NumBuckets;
+
+	/** Upper limit of the memory kept inside the pool */
+	static const int64 MaxPooledBytes;
+};
@@ -0,0 +1,58 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "EXROutput/ImageOutputUtils.h"
+
+#include "Misc/Paths.h"
+#include "MoviePipeline.h"
+#include "MoviePipelineOutputBase.h"
+#include "MoviePipelineOutputSetting.h"
+#include "MoviePipelinePrimaryConfig.h"
+#include "MoviePipelineUtils.h"
+
+
+bool FImageOutputUtils::IsSoleImageOutput(UMoviePipelineOutputBase* Output)
+{
+	check(Output)
+
+	UMoviePipelinePrimaryConfig* PrimaryConfig = Output->GetPipeline()->GetPipelinePrimaryConfig();
+	if (PrimaryConfig == nullptr)
+	{
+		return false;
+	}
+
+	// Every enabled output receives the same merged frame, so the data can only be taken when no other output reads it
+	const TArray<UMoviePipelineSetting*> OutputSettings =
+		PrimaryConfig->FindSettingsByClass(UMoviePipelineOutputBase::StaticClass());
+	return OutputSettings.Num() == 1 && OutputSettings[0] == Output;
+}
+
+FString FImageOutputUtils::ResolveFrameFilePath(
+	UMoviePipelineOutputBase* Output,
+	const FMoviePipelineFrameOutputState& FrameOutputState,
+	const TCHAR* Extension)
+{
+	check(Output)
+
+	UMoviePipelineOutputSetting* OutputSettings =
+		Output->GetPipeline()->GetPipelinePrimaryConfig()->FindSetting<UMoviePipelineOutputSetting>();
+	check(OutputSettings);
+
+	FString FileNameFormatString = OutputSettings->OutputDirectory.Path / OutputSettings->FileNameFormat;
+	const bool bIncludeRenderPass = false;
+	const bool bTestFrameNumber = true;
+	UE::MoviePipeline::ValidateOutputFormatString(FileNameFormatString, bIncludeRenderPass, bTestFrameNumber);
+
+	TMap<FString, FString> FormatOverrides;
+	FormatOverrides.Add(TEXT("render_pass"), TEXT(""));
+	FormatOverrides.Add(TEXT("ext"), Extension);
+
+	FString FinalFilePath;
+	FMoviePipelineFormatArgs FinalFormatArgs;
+	Output->GetPipeline()->ResolveFilenameFormatArguments(
+		FileNameFormatString, FormatOverrides, FinalFilePath, FinalFormatArgs, &FrameOutputState);
+	if (FPaths::IsRelative(FinalFilePath))
+	{
+		FinalFilePath = FPaths::ConvertRelativePathToFull(FinalFilePath);
+	}
+	return FinalFilePath;
+}
@@ -0,0 +1,28 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UMoviePipelineOutputBase;
+struct FMoviePipelineFrameOutputState;
+
+
+/**
+ * Helpers shared by the plugin specific movie pipeline image outputs
+*/
+class FImageOutputUtils
+{
+public:
+	/**
+	 * Checks whether the output is the only enabled output of its pipeline,
+	 * in which case it may take ownership of the merged frame pixel data instead of copying it
+	*/
+	static bool IsSoleImageOutput(UMoviePipelineOutputBase* Output);
+
+	/** Resolves the full path of a single pass frame file the same way as the engine image sequence outputs */
+	static FString ResolveFrameFilePath(
+		UMoviePipelineOutputBase* Output,
+		const FMoviePipelineFrameOutputState& FrameOutputState,
+		const TCHAR* Extension);
+};
@@ -9,6 +9,7 @@
 #include "Misc/Paths.h"
 #include "HAL/PlatformTime.h"
 #include "Math/Float16.h"
+#include "Misc/StringBuilder.h"
 #include "MovieRenderPipelineCoreModule.h"
 #include "MoviePipelineOutputSetting.h"
 #include "ImageWriteQueue.h"
@@ -19,6 +20,10 @@
 #include "Modules/ModuleManager.h"
 #include "MoviePipelineUtils.h"
 
+#include "EXROutput/ImageBufferPool.h"
+#include "EXROutput/ImageOutputUtils.h"
+#include "RendererTargets/FrameMetadata.h"
+
 THIRD_PARTY_INCLUDES_START
 #include "OpenEXR/ImfChannelList.h"
 THIRD_PARTY_INCLUDES_END
@@ -45,10 +50,7 @@ public:
 			Data.AddUninitialized(DestPost - Data.Num());
 		}
 
-		for (int64 i = 0; i < SrcN; ++i)
-		{
-			Data[Pos + i] = c[i];
-		}
+		FMemory::Memcpy(Data.GetData() + Pos, c, SrcN);
 		Pos += SrcN;
 	}
 
@@ -156,11 +158,25 @@ bool FEXRImageWriteTaskLocal::WriteToDisk()
 			FileMetadata.Add("dwaCompressionLevel", CompressionLevel);
 		}
 
+		// Tiled files are split into square tiles, optionally with box filtered mip levels,
+		// so that readers can decode only the regions they need
+		if (TileSize > 0)
+		{
+			Header.setTileDescription(Imf::TileDescription(
+				TileSize,
+				TileSize,
+				bWriteMipLevels ? Imf::LevelMode::MIPMAP_LEVELS : Imf::LevelMode::ONE_LEVEL,
+				Imf::LevelRoundingMode::ROUND_DOWN));
+		}
+
 		// Insert our key-value pair metadata (if any, can be an arbitrary set of key/value pairs)
 		AddFileMetadata(Header);
 
 		FExrMemStreamOutLocal OutputFile;
 
+		// Total size of all layers, used to reserve the output buffer once instead of per layer
+		int64 TotalBytesWritten = 0;
+
 		{
 			// The FrameBuffer stores all the channels of the resulting image.
 			Imf::FrameBuffer FrameBuffer;
@@ -196,10 +212,10 @@ bool FEXRImageWriteTaskLocal::WriteToDisk()
 					QuantizedData.Add(MoveTemp(QuantizedPixelData));
 
 					// Add an entry in the LayerNames table if needed since it matches by Layer pointer but that has changed.
-					FString LayerName = LayerNames.FindOrAdd(Layer.Get());
-					if (LayerName.Len() > 0)
+					const FString* LayerName = LayerNames.Find(Layer.Get());
+					if (LayerName != nullptr && LayerName->Len() > 0)
 					{
-						LayerNames.Add(QuantizedData.Last().Get(), LayerName);
+						LayerNames.Add(QuantizedData.Last().Get(), *LayerName);
 					}
 
 					BytesWritten = CompressRaw<Imf::HALF>(Header, FrameBuffer, QuantizedData.Last().Get());
@@ -215,28 +231,37 @@ bool FEXRImageWriteTaskLocal::WriteToDisk()
 					checkNoEntry();
 				}
 
-				// Reserve enough space in the output file for the whole layer so we don't keep reallocating.
-				OutputFile.Data.Reserve(BytesWritten);
+				TotalBytesWritten += BytesWritten;
 			}
 
-			// This scope ensures that IMF::Outputfile creates a complete file by closing the file when it goes out of scope.
-			// To complete the file, EXR seeks back into the file and writes the scanline offsets when the file is closed,
-			// which moves the tellp location. So file length is stored in advance for later use. The output file needs to be
-			// created after the header information is filled.
-			Imf::OutputFile ImfFile(OutputFile, Header, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
-#if WITH_EDITOR
-			try
-#endif
+			// Take a pooled buffer large enough for all layers so we don't keep reallocating.
+			OutputFile.Data = FImageBufferPool::Get().Acquire(TotalBytesWritten);
+
+			if (TileSize > 0)
 			{
-				ImfFile.setFrameBuffer(FrameBuffer);
-				ImfFile.writePixels(Height);
+				WriteTiles(OutputFile, Header, FrameBuffer);
 			}
-#if WITH_EDITOR
-			catch (const IEX_NAMESPACE::BaseExc& Exception)
+			else
 			{
-				UE_LOG(LogMovieRenderPipelineIO, Error, TEXT("Caught exception: %s"), Exception.message().c_str());
-			}
+				// This scope ensures that IMF::Outputfile creates a complete file by closing the file when it goes out of scope.
+				// To complete the file, EXR seeks back into the file and writes the scanline offsets when the file is closed,
+				// which moves the tellp location. So file length is stored in advance for later use. The output file needs to be
+				// created after the header information is filled.
+				Imf::OutputFile ImfFile(OutputFile, Header, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+#if WITH_EDITOR
+				try
+#endif
+				{
+					ImfFile.setFrameBuffer(FrameBuffer);
+					ImfFile.writePixels(Height);
+				}
+#if WITH_EDITOR
+				catch (const IEX_NAMESPACE::BaseExc& Exception)
+				{
+					UE_LOG(LogMovieRenderPipelineIO, Error, TEXT("Caught exception: %s"), Exception.message().c_str());
+				}
 #endif
+			}
 		}
 
 		// Now that the scope has closed for the Imf::OutputFile, now we can write the data to disk.
@@ -244,6 +269,9 @@ bool FEXRImageWriteTaskLocal::WriteToDisk()
 		{
 			bSuccess = FFileHelper::SaveArrayToFile(OutputFile.Data, *Filename);
 		}
+
+		// Return the output buffer to be reused by the following frames
+		FImageBufferPool::Get().Release(MoveTemp(OutputFile.Data));
 	}
 
 	if (!bSuccess)
@@ -254,48 +282,131 @@ bool FEXRImageWriteTaskLocal::WriteToDisk()
 	return bSuccess;
 }
 
-static FString GetChannelName(const FString& InLayerName, const int32 InChannelIndex, const ERGBFormat InFormat)
+/** Returns the precomputed table of ANSI channel names for the pixel layout, avoiding per-frame string building */
+static const char* const* GetChannelNames(const int32 InChannelIndex, const ERGBFormat InFormat)
 {
 	const int32 MaxChannels = 4;
-	static const char* RGBAChannelNames[] = { "R", "G", "B", "A" };
-	static const char* BGRAChannelNames[] = { "B", "G", "R", "A" };
-	static const char* GrayChannelNames[] = { "G" };
+	static const char* const RGBAChannelNames[] = { "R", "G", "B", "A" };
+	static const char* const BGRAChannelNames[] = { "B", "G", "R", "A" };
+	static const char* const GrayChannelNames[] = { "G" };
 	check(InChannelIndex < MaxChannels);
 
-	const char** ChannelNames = BGRAChannelNames;
-
 	switch (InFormat)
 	{
 		case ERGBFormat::RGBA:
 		case ERGBFormat::RGBAF:
-		{
-			ChannelNames = RGBAChannelNames;
-		}
-		break;
+			return RGBAChannelNames;
 		case ERGBFormat::BGRA:
-		{
-			ChannelNames = BGRAChannelNames;
-		}
-		break;
+			return BGRAChannelNames;
 		case ERGBFormat::Gray:
 		case ERGBFormat::GrayF:
-		{
 			check(InChannelIndex < UE_ARRAY_COUNT(GrayChannelNames));
-			ChannelNames = GrayChannelNames;
-		}
-		break;
+			return GrayChannelNames;
 		default:
 			checkNoEntry();
 	}
 
-	if (InLayerName.Len() > 0)
+	return BGRAChannelNames;
+}
+
+/** Reads a single sample from the slice as a float */
+static float ReadSliceSample(const Imf::Slice& InSlice, const int64 InX, const int64 InY)
+{
+	const char* SamplePtr = InSlice.base + InX * InSlice.xStride + InY * InSlice.yStride;
+	return InSlice.type == Imf::FLOAT ?
+		*reinterpret_cast<const float*>(SamplePtr) :
+		static_cast<float>(*reinterpret_cast<const FFloat16*>(SamplePtr));
+}
+
+/** Box filters the slice into a planar buffer of the next mip level, sized as the level with the rounded down size */
+static void DownsampleSlice(
+	const Imf::Slice& InSlice,
+	const int32 InWidth,
+	const int32 InHeight,
+	uint8* OutData,
+	const int32 OutWidth,
+	const int32 OutHeight)
+{
+	for (int32 Y = 0; Y < OutHeight; Y++)
+	{
+		const int32 Y0 = FMath::Min(2 * Y, InHeight - 1);
+		const int32 Y1 = FMath::Min(2 * Y + 1, InHeight - 1);
+		for (int32 X = 0; X < OutWidth; X++)
+		{
+			const int32 X0 = FMath::Min(2 * X, InWidth - 1);
+			const int32 X1 = FMath::Min(2 * X + 1, InWidth - 1);
+			const float Value = 0.25f * (
+				ReadSliceSample(InSlice, X0, Y0) + ReadSliceSample(InSlice, X1, Y0) +
+				ReadSliceSample(InSlice, X0, Y1) + ReadSliceSample(InSlice, X1, Y1));
+
+			const int64 Index = int64(Y) * OutWidth + X;
+			if (InSlice.type == Imf::FLOAT)
+			{
+				reinterpret_cast<float*>(OutData)[Index] = Value;
+			}
+			else
+			{
+				reinterpret_cast<FFloat16*>(OutData)[Index] = FFloat16(Value);
+			}
+		}
+	}
+}
+
+void FEXRImageWriteTaskLocal::WriteTiles(Imf::OStream& InStream, Imf::Header& InHeader, const Imf::FrameBuffer& InFrameBuffer)
+{
+	// Same as with scanline files, the scope closes the file so that the tile offsets get written
+	Imf::TiledOutputFile ImfFile(InStream, InHeader, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+#if WITH_EDITOR
+	try
+#endif
 	{
-		return FString::Printf(TEXT("%s.%s"), *InLayerName, ChannelNames[InChannelIndex]);
+		ImfFile.setFrameBuffer(InFrameBuffer);
+		ImfFile.writeTiles(0, ImfFile.numXTiles(0) - 1, 0, ImfFile.numYTiles(0) - 1, 0);
+
+		// Every following mip level is created by box filtering the previous one into planar buffers
+		Imf::FrameBuffer LevelFrameBuffer = InFrameBuffer;
+		TArray<TArray64<uint8>> LevelData;
+		int32 LevelWidth = Width;
+		int32 LevelHeight = Height;
+		for (int32 Level = 1; Level < ImfFile.numLevels(); Level++)
+		{
+			const int32 NextLevelWidth = ImfFile.levelWidth(Level);
+			const int32 NextLevelHeight = ImfFile.levelHeight(Level);
+
+			Imf::FrameBuffer NextLevelFrameBuffer;
+			TArray<TArray64<uint8>> NextLevelData;
+			for (Imf::FrameBuffer::ConstIterator It = LevelFrameBuffer.begin(); It != LevelFrameBuffer.end(); ++It)
+			{
+				const Imf::Slice& Slice = It.slice();
+				const int32 ComponentWidth = (Slice.type == Imf::FLOAT ? 4 : 2);
+
+				TArray64<uint8>& ChannelData = NextLevelData.AddDefaulted_GetRef();
+				ChannelData.SetNumUninitialized(int64(NextLevelWidth) * NextLevelHeight * ComponentWidth);
+				DownsampleSlice(Slice, LevelWidth, LevelHeight, ChannelData.GetData(), NextLevelWidth, NextLevelHeight);
+
+				NextLevelFrameBuffer.insert(It.name(), Imf::Slice(
+					Slice.type,
+					reinterpret_cast<char*>(ChannelData.GetData()),
+					ComponentWidth,
+					int64(NextLevelWidth) * ComponentWidth));
+			}
+
+			ImfFile.setFrameBuffer(NextLevelFrameBuffer);
+			ImfFile.writeTiles(0, ImfFile.numXTiles(Level) - 1, 0, ImfFile.numYTiles(Level) - 1, Level);
+
+			// Moving the arrays keeps the channel allocations referenced by the frame buffer
+			LevelFrameBuffer = NextLevelFrameBuffer;
+			LevelData = MoveTemp(NextLevelData);
+			LevelWidth = NextLevelWidth;
+			LevelHeight = NextLevelHeight;
+		}
 	}
-	else
+#if WITH_EDITOR
+	catch (const IEX_NAMESPACE::BaseExc& Exception)
 	{
-		return FString(ChannelNames[InChannelIndex]);
+		UE_LOG(LogMovieRenderPipelineIO, Error, TEXT("Caught exception: %s"), Exception.message().c_str());
 	}
+#endif
 }
 
 static int32 GetComponentWidth(const EImagePixelType InPixelType)
@@ -319,19 +430,29 @@ int64 FEXRImageWriteTaskLocal::CompressRaw(Imf::Header& InHeader, Imf::FrameBuff
 	InLayer->GetRawData(RawDataPtr, RawDataSize);
 
 	// Look up our layer name (if any).
-	FString& LayerName = LayerNames.FindOrAdd(InLayer);
+	const FString* LayerName = LayerNames.Find(InLayer);
 	int32 NumChannels = InLayer->GetNumChannels();
 	int32 ComponentWidth = GetComponentWidth(InLayer->GetType());
 
+	// Convert the layer prefix once per layer, channel names are then assembled on the stack
+	TAnsiStringBuilder<256> ChannelName;
+	int32 PrefixLength = 0;
+	if (LayerName != nullptr && LayerName->Len() > 0)
+	{
+		ChannelName << StringCast<ANSICHAR>(**LayerName).Get() << '.';
+		PrefixLength = ChannelName.Len();
+	}
+
 	for (int32 Channel = 0; Channel < NumChannels; Channel++)
 	{
-		FString ChannelName = GetChannelName(LayerName, Channel, InLayer->GetPixelLayout());
+		ChannelName.RemoveSuffix(ChannelName.Len() - PrefixLength);
+		ChannelName << GetChannelNames(Channel, InLayer->GetPixelLayout())[Channel];
 
 		// Insert the channel into the header with the right datatype.
-		InHeader.channels().insert(TCHAR_TO_ANSI(*ChannelName), Imf::Channel(OutputFormat));
+		InHeader.channels().insert(*ChannelName, Imf::Channel(OutputFormat));
 
 		// Now insert the data for this channel. Unreal stores them interleaved.
-		InFrameBuffer.insert(TCHAR_TO_ANSI(*ChannelName),	// Name
+		InFrameBuffer.insert(*ChannelName,					// Name
 			Imf::Slice(OutputFormat,						// Type
 			(char*)RawDataPtr + (ComponentWidth * Channel), // Data Start (offset by component to match interleave)
 				ComponentWidth * NumChannels,				// xStride
@@ -407,6 +528,9 @@ void UMoviePipelineImageSequenceOutput_EXRLocal::OnReceiveImageDataImpl(FMoviePi
 		Resolutions.AddUnique(RenderPassData.Value->GetSize());
 	}
 
+	// When no other output consumes the merged frame, pixel data is moved into the write tasks instead of being copied
+	const bool bTakeOwnership = FImageOutputUtils::IsSoleImageOutput(this);
+
 	// Then submit multiple write tasks. Layers that don't match the current resolution will be skipped until the correct iteration of the loop.
 	for (int32 Index = 0; Index < Resolutions.Num(); Index++)
 	{
@@ -471,6 +595,8 @@ void UMoviePipelineImageSequenceOutput_EXRLocal::OnReceiveImageDataImpl(FMoviePi
 		TUniquePtr<FEXRImageWriteTaskLocal> MultiLayerImageTask = MakeUnique<FEXRImageWriteTaskLocal>();
 		MultiLayerImageTask->Filename = FinalFilePath;
 		MultiLayerImageTask->Compression = Compression;
+		MultiLayerImageTask->TileSize = bTiled ? FMath::Max(TileSize, 1) : 0;
+		MultiLayerImageTask->bWriteMipLevels = bTiled && bMipLevels;
 		// MultiLayerImageTask->CompressionLevel is intentionally skipped because it doesn't seem to make any practical difference
 		// so we don't expose it to the user because that will just cause confusion where the setting doesn't seem to do anything.
 
@@ -482,6 +608,17 @@ void UMoviePipelineImageSequenceOutput_EXRLocal::OnReceiveImageDataImpl(FMoviePi
 		{
 			NewFileMetdataMap.Add(Metadata.Key, Metadata.Value);
 		}
+
+		// Embed the camera pose and intrinsics so the frame can be consumed on its own
+		const int32 FrameIndex = InMergedOutputFrame->FrameOutputState.OutputFrameNumber;
+		if (FrameCameraPoses.IsValidIndex(FrameIndex) && FrameTimestamps.IsValidIndex(FrameIndex))
+		{
+			for (const TPair<FString, FString>& Metadata :
+				FFrameMetadata::FrameValues(FrameCameraPoses[FrameIndex], FrameTimestamps[FrameIndex], CameraIntrinsics))
+			{
+				NewFileMetdataMap.Add(Metadata.Key, Metadata.Value);
+			}
+		}
 		MultiLayerImageTask->FileMetadata = NewFileMetdataMap;
 
 		int32 LayerIndex = 0;
@@ -489,21 +626,25 @@ void UMoviePipelineImageSequenceOutput_EXRLocal::OnReceiveImageDataImpl(FMoviePi
 		int32 ShotIndex = 0;
 		for (TPair<FMoviePipelinePassIdentifier, TUniquePtr<FImagePixelData>>& RenderPassData : InMergedOutputFrame->ImageOutputData)
 		{
-			if (RenderPassData.Value->GetSize() != Resolutions[Index])
+			if (!RenderPassData.Value.IsValid() || RenderPassData.Value->GetSize() != Resolutions[Index])
 			{
 				// If this layer isn't for this resolution, don't add it to the multilayer task, a second task will be created soon.
+				// Layers already moved into a previous task are skipped as well.
 				continue;
 			}
 
-			// No quantization required, just copy the data as we will move it into the image write task.
-			TUniquePtr<FImagePixelData> PixelData = RenderPassData.Value->CopyImageData();
+			// No quantization required, so the data is transferred into the image write task as is.
+			// It is only copied if other outputs still need to read the merged frame.
+			TUniquePtr<FImagePixelData> PixelData = bTakeOwnership ?
+				MoveTemp(RenderPassData.Value) :
+				RenderPassData.Value->CopyImageData();
 
 			// If there is more than one layer, then we will prefix the layer. The first layer is not prefixed (and gets inserted as RGBA)
 			// as most programs that handle EXRs expect the main image data to be in an unnamed layer.
 			if (LayerIndex == 0)
 			{
 				// Only check the main image pass for transparent output since that's generally considered the 'preview'.
-				FImagePixelDataPayload* Payload = RenderPassData.Value->GetPayload<FImagePixelDataPayload>();
+				FImagePixelDataPayload* Payload = PixelData->GetPayload<FImagePixelDataPayload>();
 				bRequiresTransparentOutput = Payload->bRequireTransparentOutput;
 				ShotIndex = Payload->SampleState.OutputState.ShotIndex;
 				MultiLayerImageTask->OverscanPercentage = Payload->SampleState.OverscanPercentage;
@@ -17,6 +17,8 @@ THIRD_PARTY_INCLUDES_START
 #include "OpenEXR/ImfOutputFile.h"
 #include "OpenEXR/ImfRgbaFile.h"
 #include "OpenEXR/ImfStdIO.h"
+#include "OpenEXR/ImfTileDescription.h"
+#include "OpenEXR/ImfTiledOutputFile.h"
 THIRD_PARTY_INCLUDES_END
 #endif // WITH_UNREALEXR
 
@@ -74,11 +76,19 @@ public:
 	/** Overscan info used to create apropriate dataWindow for EXR output. Goes from 0.0 to 1.0. */
 	float OverscanPercentage;
 
+	/** Width and height of tiles in pixels, scanline files are written if zero */
+	int32 TileSize;
+
+	/** Whether tiled files should also contain mip levels */
+	bool bWriteMipLevels;
+
 	FEXRImageWriteTaskLocal()
 		: bOverwriteFile(true)
 		, Compression(EEXRCompressionFormatLocal::PIZ)
 		, CompressionLevel(45)
 		, OverscanPercentage(0.0f)
+		, TileSize(0)
+		, bWriteMipLevels(false)
 	{}
 
 public:
@@ -107,6 +117,9 @@ private:
 	*/
 	void AddFileMetadata(Imf::Header& InHeader);
 
+	/** Writes the frame buffer as a tiled file, followed by its mip levels if requested */
+	void WriteTiles(Imf::OStream& InStream, Imf::Header& InHeader, const Imf::FrameBuffer& InFrameBuffer);
+
 	template <Imf::PixelType OutputFormat>
 	int64 CompressRaw(Imf::Header& InHeader, Imf::FrameBuffer& InFrameBuffer, FImagePixelData* InLayer);
 };
@@ -126,6 +139,9 @@ public:
 		OutputFormat = EImageFormat::EXR;
 		Compression = EEXRCompressionFormatLocal::PIZ;
 		bMultilayer = true;
+		bTiled = false;
+		TileSize = 64;
+		bMipLevels = false;
 	}
 
 	virtual void OnReceiveImageDataImpl(FMoviePipelineMergerOutputFrame* InMergedOutputFrame) override;
@@ -142,4 +158,41 @@ public:
 	*/
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EXR")
 	bool bMultilayer;
+
+	/**
+	* Should the files be written as tiles instead of scanlines? Tiled files allow decoding only the needed image regions.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EXR")
+	bool bTiled;
+
+	/**
+	* Width and height of a single tile in pixels
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EXR", meta = (EditCondition = "bTiled", ClampMin = "1"))
+	int32 TileSize;
+
+	/**
+	* Should tiled files also contain box filtered mip levels?
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EXR", meta = (EditCondition = "bTiled"))
+	bool bMipLevels;
+
+	/**
+	* Camera pose for each output frame, written into the file headers together with the timestamp and intrinsics.
+	* No frame metadata is written if empty.
+	*/
+	UPROPERTY()
+	TArray<FTransform> FrameCameraPoses;
+
+	/**
+	* Timestamp of each output frame
+	*/
+	UPROPERTY()
+	TArray<double> FrameTimestamps;
+
+	/**
+	* Camera intrinsics packed as (fx, fy, cx, cy)
+	*/
+	UPROPERTY()
+	FVector4 CameraIntrinsics;
 };
@@ -0,0 +1,516 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "OpticalFlow/DepthOpticalFlow.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "IImageWrapperModule.h"
+#include "ImagePixelData.h"
+#include "Math/VectorRegister.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "EasySynth.h"
+#include "EXROutput/ExrLayerMerger.h"
+#include "RendererTargets/FrameMetadata.h"
+
+
+const float FDepthOpticalFlow::ConsistencyRelativeTolerance = 0.01f;
+const float FDepthOpticalFlow::ConsistencyAbsoluteTolerance = 0.5f;
+
+FDepthOpticalFlow::FDepthOpticalFlow(
+	const TArray<FTransform>& FramePoses,
+	const FVector4& CameraIntrinsics,
+	const float DepthRangeMeters,
+	const float FlowScale,
+	const EImageFormat FlowImageFormat,
+	const UMoviePipelineImageSequenceOutput_EXRLocal* ExrSetting) :
+	CameraPoses(FramePoses),
+	Intrinsics(CameraIntrinsics),
+	DepthRange(DepthRangeMeters * 100.0f),
+	OpticalFlowScale(FlowScale),
+	ImageFormat(FlowImageFormat),
+	ExrCompression(EEXRCompressionFormatLocal::PIZ),
+	ExrTileSize(0),
+	bExrMipLevels(false)
+{
+	if (ExrSetting != nullptr)
+	{
+		ExrCompression = ExrSetting->Compression;
+		ExrTileSize = ExrSetting->bTiled ? FMath::Max(ExrSetting->TileSize, 1) : 0;
+		bExrMipLevels = ExrSetting->bTiled && ExrSetting->bMipLevels;
+	}
+
+	// Image wrappers are created from worker threads, where modules cannot be loaded
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+}
+
+bool FDepthOpticalFlow::GenerateFlowImages(
+	const FString& DepthDir,
+	const FString& FlowDir,
+	const FString& BackwardFlowDir,
+	const FString& OcclusionMaskDir) const
+{
+	TArray<FString> FrameFileNames;
+	IFileManager::Get().FindFiles(FrameFileNames, *DepthDir, TEXT("exr"));
+	FrameFileNames.Sort();
+
+	if (FrameFileNames.Num() != CameraPoses.Num())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Found %d depth frames inside %s, but got %d camera poses"),
+			*FString(__FUNCTION__), FrameFileNames.Num(), *DepthDir, CameraPoses.Num())
+		return false;
+	}
+
+	const bool bBackwardFlow = !BackwardFlowDir.IsEmpty();
+	const bool bOcclusionMasks = !OcclusionMaskDir.IsEmpty();
+	IFileManager::Get().MakeDirectory(*FlowDir, true);
+	if (bBackwardFlow)
+	{
+		IFileManager::Get().MakeDirectory(*BackwardFlowDir, true);
+	}
+	if (bOcclusionMasks)
+	{
+		IFileManager::Get().MakeDirectory(*OcclusionMaskDir, true);
+	}
+
+	const TCHAR* Extension =
+		ImageFormat == EImageFormat::EXR ? TEXT("exr") : (ImageFormat == EImageFormat::PNG ? TEXT("png") : TEXT("jpeg"));
+	const TCHAR* MaskExtension = ImageFormat == EImageFormat::EXR ? TEXT("exr") : TEXT("png");
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Each frame only needs its own and the previous depth, and the neighboring camera poses, so frames are independent
+	std::atomic<int32> FailedFrames(0);
+	ParallelFor(FrameFileNames.Num(), [&](const int32 Index)
+	{
+		TArray64<float> Depth;
+		FIntPoint Size;
+		TMap<FString, FStringFormatArg> Metadata;
+		if (!ReadDepth(DepthDir / FrameFileNames[Index], DepthRange, Depth, Size, Metadata))
+		{
+			FailedFrames++;
+			return;
+		}
+		const FString BaseFileName = FPaths::GetBaseFilename(FrameFileNames[Index]);
+
+		// The first frame has no previous pose, so there is no movement to describe
+		TArray64<FVector2f> Flow;
+		if (Index == 0)
+		{
+			Flow.SetNumZeroed(int64(Size.X) * Size.Y);
+		}
+		else
+		{
+			ComputeFlow(Depth, Size, CameraPoses[Index], CameraPoses[Index - 1], Flow);
+		}
+
+		if (!WriteFlowImage(FlowDir / BaseFileName + TEXT(".") + Extension, Flow, Size, Metadata))
+		{
+			FailedFrames++;
+			return;
+		}
+
+		// Backward flow spans from where the pixel content is in the next frame, so the last frame has none
+		if (bBackwardFlow)
+		{
+			TArray64<FVector2f> BackwardFlow;
+			if (Index == FrameFileNames.Num() - 1)
+			{
+				BackwardFlow.SetNumZeroed(int64(Size.X) * Size.Y);
+			}
+			else
+			{
+				ComputeFlow(Depth, Size, CameraPoses[Index], CameraPoses[Index + 1], BackwardFlow);
+			}
+
+			if (!WriteFlowImage(BackwardFlowDir / BaseFileName + TEXT(".") + Extension, BackwardFlow, Size, Metadata))
+			{
+				FailedFrames++;
+				return;
+			}
+		}
+
+		// The consistency check needs the backward flow of the previous frame, which is cheaper to recompute
+		// from the previous depth than to wait for the worker processing that frame
+		if (bOcclusionMasks)
+		{
+			TArray64<uint8> Mask;
+			if (Index == 0)
+			{
+				Mask.SetNumZeroed(int64(Size.X) * Size.Y);
+			}
+			else
+			{
+				TArray64<float> PreviousDepth;
+				FIntPoint PreviousSize;
+				TMap<FString, FStringFormatArg> PreviousMetadata;
+				if (!ReadDepth(
+						DepthDir / FrameFileNames[Index - 1], DepthRange, PreviousDepth, PreviousSize, PreviousMetadata) ||
+					PreviousSize != Size)
+				{
+					FailedFrames++;
+					return;
+				}
+
+				TArray64<FVector2f> PreviousBackwardFlow;
+				ComputeFlow(PreviousDepth, Size, CameraPoses[Index - 1], CameraPoses[Index], PreviousBackwardFlow);
+				ComputeOcclusionMask(Flow, PreviousBackwardFlow, Size, Mask);
+			}
+
+			if (!WriteMaskImage(OcclusionMaskDir / BaseFileName + TEXT(".") + MaskExtension, Mask, Size, Metadata))
+			{
+				FailedFrames++;
+			}
+		}
+	});
+
+	if (FailedFrames > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to generate %d of %d flow frames inside %s"),
+			*FString(__FUNCTION__), FailedFrames.load(), FrameFileNames.Num(), *FlowDir)
+		return false;
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Generated %d flow frames from depth in %.2f s"),
+		*FString(__FUNCTION__), FrameFileNames.Num(), FPlatformTime::Seconds() - StartTime)
+
+	return true;
+}
+
+void FDepthOpticalFlow::ComputeFlow(
+	const TArray64<float>& Depth,
+	const FIntPoint Size,
+	const FTransform& FramePose,
+	const FTransform& TargetPose,
+	TArray64<FVector2f>& OutFlow) const
+{
+	check(Depth.Num() == int64(Size.X) * Size.Y)
+	OutFlow.SetNumUninitialized(Depth.Num());
+
+	// Takes row vectors from the frame camera space into the target camera space
+	const FMatrix44f Relative((FramePose * TargetPose.Inverse()).ToMatrixNoScale());
+
+	// Camera space point of a pixel is its depth multiplied by the ray (1, (u - cx) / fx, (cy - v) / fy),
+	// so the target space point is depth multiplied by the transformed ray, plus the translation
+	// Pixels without depth are infinitely far away, where only the ray direction matters
+	const float InvFx = 1.0f / Intrinsics.X;
+	const float InvFy = 1.0f / Intrinsics.Y;
+	const VectorRegister4Float Fx = VectorSetFloat1(Intrinsics.X);
+	const VectorRegister4Float Fy = VectorSetFloat1(Intrinsics.Y);
+	const VectorRegister4Float Cx = VectorSetFloat1(Intrinsics.Z);
+	const VectorRegister4Float Cy = VectorSetFloat1(Intrinsics.W);
+	const VectorRegister4Float VInvFx = VectorSetFloat1(InvFx);
+	const VectorRegister4Float InvWidth = VectorSetFloat1(1.0f / Size.X);
+	const VectorRegister4Float InvHeight = VectorSetFloat1(1.0f / Size.Y);
+	const VectorRegister4Float Range = VectorSetFloat1(DepthRange);
+	const VectorRegister4Float MinForward = VectorSetFloat1(UE_KINDA_SMALL_NUMBER);
+	const VectorRegister4Float LaneOffsets = MakeVectorRegisterFloat(0.5f, 1.5f, 2.5f, 3.5f);
+	const VectorRegister4Float Rx1 = VectorSetFloat1(Relative.M[1][0]);
+	const VectorRegister4Float Ry1 = VectorSetFloat1(Relative.M[1][1]);
+	const VectorRegister4Float Rz1 = VectorSetFloat1(Relative.M[1][2]);
+	const VectorRegister4Float Tx = VectorSetFloat1(Relative.M[3][0]);
+	const VectorRegister4Float Ty = VectorSetFloat1(Relative.M[3][1]);
+	const VectorRegister4Float Tz = VectorSetFloat1(Relative.M[3][2]);
+
+	ParallelFor(Size.Y, [&](const int32 Y)
+	{
+		const float V = Y + 0.5f;
+		const float RayZ = (Intrinsics.W - V) * InvFy;
+		const VectorRegister4Float VV = VectorSetFloat1(V);
+
+		// Part of the transformed ray that is constant along the row
+		const VectorRegister4Float RowX = VectorSetFloat1(Relative.M[0][0] + RayZ * Relative.M[2][0]);
+		const VectorRegister4Float RowY = VectorSetFloat1(Relative.M[0][1] + RayZ * Relative.M[2][1]);
+		const VectorRegister4Float RowZ = VectorSetFloat1(Relative.M[0][2] + RayZ * Relative.M[2][2]);
+
+		const float* DepthRow = Depth.GetData() + int64(Y) * Size.X;
+		FVector2f* FlowRow = OutFlow.GetData() + int64(Y) * Size.X;
+
+		for (int32 X = 0; X < Size.X; X += 4)
+		{
+			// The row tail is padded with infinite depth
+			const int32 Lanes = FMath::Min(4, Size.X - X);
+			alignas(16) float DepthLanes[4] = { DepthRange, DepthRange, DepthRange, DepthRange };
+			FMemory::Memcpy(DepthLanes, DepthRow + X, Lanes * sizeof(float));
+
+			const VectorRegister4Float D = VectorLoadAligned(DepthLanes);
+			const VectorRegister4Float Infinite = VectorCompareGE(D, Range);
+			const VectorRegister4Float Scale = VectorSelect(Infinite, VectorOne(), D);
+
+			const VectorRegister4Float U = VectorAdd(VectorSetFloat1(float(X)), LaneOffsets);
+			const VectorRegister4Float RayY = VectorMultiply(VectorSubtract(U, Cx), VInvFx);
+
+			const VectorRegister4Float Qx = VectorMultiplyAdd(
+				Scale, VectorMultiplyAdd(RayY, Rx1, RowX), VectorSelect(Infinite, VectorZero(), Tx));
+			const VectorRegister4Float Qy = VectorMultiplyAdd(
+				Scale, VectorMultiplyAdd(RayY, Ry1, RowY), VectorSelect(Infinite, VectorZero(), Ty));
+			const VectorRegister4Float Qz = VectorMultiplyAdd(
+				Scale, VectorMultiplyAdd(RayY, Rz1, RowZ), VectorSelect(Infinite, VectorZero(), Tz));
+
+			// Points behind the target camera have no valid projection
+			const VectorRegister4Float InFront = VectorCompareGT(Qx, MinForward);
+			const VectorRegister4Float InvQx = VectorDivide(VectorOne(), VectorSelect(InFront, Qx, VectorOne()));
+			const VectorRegister4Float TargetU = VectorMultiplyAdd(VectorMultiply(Qy, InvQx), Fx, Cx);
+			const VectorRegister4Float TargetV = VectorSubtract(Cy, VectorMultiply(VectorMultiply(Qz, InvQx), Fy));
+
+			const VectorRegister4Float FlowX =
+				VectorSelect(InFront, VectorMultiply(VectorSubtract(U, TargetU), InvWidth), VectorZero());
+			const VectorRegister4Float FlowY =
+				VectorSelect(InFront, VectorMultiply(VectorSubtract(VV, TargetV), InvHeight), VectorZero());
+
+			alignas(16) float FlowXLanes[4];
+			alignas(16) float FlowYLanes[4];
+			VectorStoreAligned(FlowX, FlowXLanes);
+			VectorStoreAligned(FlowY, FlowYLanes);
+			for (int32 Lane = 0; Lane < Lanes; Lane++)
+			{
+				FlowRow[X + Lane] = FVector2f(FlowXLanes[Lane], FlowYLanes[Lane]);
+			}
+		}
+	});
+}
+
+void FDepthOpticalFlow::ComputeOcclusionMask(
+	const TArray64<FVector2f>& Flow,
+	const TArray64<FVector2f>& PreviousBackwardFlow,
+	const FIntPoint Size,
+	TArray64<uint8>& OutMask)
+{
+	check(Flow.Num() == int64(Size.X) * Size.Y && PreviousBackwardFlow.Num() == Flow.Num())
+	OutMask.SetNumUninitialized(Flow.Num());
+
+	// Flows are compared in pixels, so the tolerances do not depend on the image aspect ratio
+	const VectorRegister4Float Width = VectorSetFloat1(float(Size.X));
+	const VectorRegister4Float Height = VectorSetFloat1(float(Size.Y));
+	const VectorRegister4Float RelativeTolerance = VectorSetFloat1(ConsistencyRelativeTolerance);
+	const VectorRegister4Float AbsoluteTolerance = VectorSetFloat1(ConsistencyAbsoluteTolerance);
+
+	ParallelFor(Size.Y, [&](const int32 Y)
+	{
+		const FVector2f* FlowRow = Flow.GetData() + int64(Y) * Size.X;
+		uint8* MaskRow = OutMask.GetData() + int64(Y) * Size.X;
+
+		for (int32 X = 0; X < Size.X; X += 4)
+		{
+			const int32 Lanes = FMath::Min(4, Size.X - X);
+			alignas(16) float Lane[4][4] = {};
+			bool bInside[4] = { false, false, false, false };
+
+			// Gathering the bilinearly sampled backward flow is scalar, the check itself is vectorized
+			for (int32 L = 0; L < Lanes; L++)
+			{
+				const FVector2f& F = FlowRow[X + L];
+				const float SourceX = X + L - F.X * Size.X;
+				const float SourceY = Y - F.Y * Size.Y;
+				Lane[0][L] = F.X;
+				Lane[1][L] = F.Y;
+
+				bInside[L] = SourceX >= -0.5f && SourceX <= Size.X - 0.5f && SourceY >= -0.5f && SourceY <= Size.Y - 0.5f;
+				if (!bInside[L])
+				{
+					continue;
+				}
+
+				const float ClampedX = FMath::Clamp(SourceX, 0.0f, Size.X - 1.0f);
+				const float ClampedY = FMath::Clamp(SourceY, 0.0f, Size.Y - 1.0f);
+				const int32 X0 = FMath::Min(int32(ClampedX), FMath::Max(Size.X - 2, 0));
+				const int32 Y0 = FMath::Min(int32(ClampedY), FMath::Max(Size.Y - 2, 0));
+				const int32 X1 = FMath::Min(X0 + 1, Size.X - 1);
+				const int32 Y1 = FMath::Min(Y0 + 1, Size.Y - 1);
+				const float Tx = ClampedX - X0;
+				const float Ty = ClampedY - Y0;
+
+				const FVector2f* Backward = PreviousBackwardFlow.GetData();
+				const FVector2f Top = FMath::Lerp(
+					Backward[int64(Y0) * Size.X + X0], Backward[int64(Y0) * Size.X + X1], Tx);
+				const FVector2f Bottom = FMath::Lerp(
+					Backward[int64(Y1) * Size.X + X0], Backward[int64(Y1) * Size.X + X1], Tx);
+				const FVector2f B = FMath::Lerp(Top, Bottom, Ty);
+				Lane[2][L] = B.X;
+				Lane[3][L] = B.Y;
+			}
+
+			const VectorRegister4Float Fx = VectorMultiply(VectorLoadAligned(Lane[0]), Width);
+			const VectorRegister4Float Fy = VectorMultiply(VectorLoadAligned(Lane[1]), Height);
+			const VectorRegister4Float Bx = VectorMultiply(VectorLoadAligned(Lane[2]), Width);
+			const VectorRegister4Float By = VectorMultiply(VectorLoadAligned(Lane[3]), Height);
+
+			// Forward flow points back to the previous frame, where the backward flow should point forward again
+			const VectorRegister4Float Sx = VectorAdd(Fx, Bx);
+			const VectorRegister4Float Sy = VectorAdd(Fy, By);
+			const VectorRegister4Float Difference = VectorMultiplyAdd(Sx, Sx, VectorMultiply(Sy, Sy));
+			const VectorRegister4Float Lengths = VectorAdd(
+				VectorMultiplyAdd(Fx, Fx, VectorMultiply(Fy, Fy)),
+				VectorMultiplyAdd(Bx, Bx, VectorMultiply(By, By)));
+			const int32 Consistent = VectorMaskBits(
+				VectorCompareLT(Difference, VectorMultiplyAdd(Lengths, RelativeTolerance, AbsoluteTolerance)));
+
+			for (int32 L = 0; L < Lanes; L++)
+			{
+				MaskRow[X + L] = (bInside[L] && (Consistent & (1 << L))) ? 255 : 0;
+			}
+		}
+	});
+}
+
+bool FDepthOpticalFlow::ReadDepth(
+	const FString& FilePath,
+	const float DepthRange,
+	TArray64<float>& OutDepth,
+	FIntPoint& OutSize,
+	TMap<FString, FStringFormatArg>& OutMetadata)
+{
+	TUniquePtr<FImagePixelData> Image = FExrLayerMerger::ReadImage(FilePath, &OutMetadata);
+	if (!Image.IsValid())
+	{
+		return false;
+	}
+
+	const void* RawData = nullptr;
+	int64 RawSize = 0;
+	Image->GetRawData(RawData, RawSize);
+	OutSize = Image->GetSize();
+	OutDepth.SetNumUninitialized(int64(OutSize.X) * OutSize.Y);
+
+	// Depth images store the depth normalized to the depth range inside all color channels
+	if (Image->GetType() == EImagePixelType::Float32)
+	{
+		const FLinearColor* Pixels = static_cast<const FLinearColor*>(RawData);
+		for (int64 i = 0; i < OutDepth.Num(); i++)
+		{
+			OutDepth[i] = Pixels[i].R * DepthRange;
+		}
+	}
+	else
+	{
+		const FFloat16Color* Pixels = static_cast<const FFloat16Color*>(RawData);
+		for (int64 i = 0; i < OutDepth.Num(); i++)
+		{
+			OutDepth[i] = Pixels[i].R.GetFloat() * DepthRange;
+		}
+	}
+
+	return true;
+}
+
+FLinearColor FDepthOpticalFlow::EncodeFlow(const FVector2f& Flow, const float Scale)
+{
+	// Hue holds the angle in degrees and saturation the scaled length, clipped as in the rendered images
+	float Angle = FMath::RadiansToDegrees(FMath::Atan2(Flow.Y, Flow.X));
+	if (Angle < 0.0f)
+	{
+		Angle += 360.0f;
+	}
+	const float Saturation = FMath::Min(Flow.Size() * Scale, 1.0f);
+	return FLinearColor(Angle, Saturation, 1.0f).HSVToLinearRGB();
+}
+
+bool FDepthOpticalFlow::WriteFlowImage(
+	const FString& FilePath,
+	const TArray64<FVector2f>& Flow,
+	const FIntPoint Size,
+	const TMap<FString, FStringFormatArg>& Metadata) const
+{
+	if (ImageFormat == EImageFormat::EXR)
+	{
+		TArray64<FFloat16Color> Pixels;
+		Pixels.SetNumUninitialized(Flow.Num());
+		for (int64 i = 0; i < Flow.Num(); i++)
+		{
+			Pixels[i] = FFloat16Color(EncodeFlow(Flow[i], OpticalFlowScale));
+		}
+		return WriteExrImage(FilePath, MoveTemp(Pixels), Size, Metadata);
+	}
+
+	// 8-bit images are sRGB encoded, the same as the rendered ones
+	TArray64<FColor> Pixels;
+	Pixels.SetNumUninitialized(Flow.Num());
+	for (int64 i = 0; i < Flow.Num(); i++)
+	{
+		Pixels[i] = EncodeFlow(Flow[i], OpticalFlowScale).ToFColor(true);
+	}
+	return WriteCompressedImage(
+		FilePath, Pixels.GetData(), Pixels.Num() * sizeof(FColor), Size, ImageFormat, ERGBFormat::BGRA, Metadata);
+}
+
+bool FDepthOpticalFlow::WriteMaskImage(
+	const FString& FilePath,
+	const TArray64<uint8>& Mask,
+	const FIntPoint Size,
+	const TMap<FString, FStringFormatArg>& Metadata) const
+{
+	// EXR masks can be combined with the other EXR targets
+	if (ImageFormat == EImageFormat::EXR)
+	{
+		TArray64<FFloat16Color> Pixels;
+		Pixels.SetNumUninitialized(Mask.Num());
+		for (int64 i = 0; i < Mask.Num(); i++)
+		{
+			Pixels[i] = FFloat16Color(Mask[i] > 0 ? FLinearColor::White : FLinearColor::Black);
+		}
+		return WriteExrImage(FilePath, MoveTemp(Pixels), Size, Metadata);
+	}
+
+	// Lossy compression would blur mask edges, so masks are never written as JPEG
+	return WriteCompressedImage(
+		FilePath, Mask.GetData(), Mask.Num(), Size, EImageFormat::PNG, ERGBFormat::Gray, Metadata);
+}
+
+bool FDepthOpticalFlow::WriteExrImage(
+	const FString& FilePath,
+	TArray64<FFloat16Color>&& Pixels,
+	const FIntPoint Size,
+	const TMap<FString, FStringFormatArg>& Metadata) const
+{
+#if WITH_UNREALEXR
+	FEXRImageWriteTaskLocal ImageTask;
+	ImageTask.Filename = FilePath;
+	ImageTask.Compression = ExrCompression;
+	ImageTask.Width = Size.X;
+	ImageTask.Height = Size.Y;
+	ImageTask.TileSize = ExrTileSize;
+	ImageTask.bWriteMipLevels = bExrMipLevels;
+	ImageTask.FileMetadata = Metadata;
+	ImageTask.Layers.Add(MakeUnique<TImagePixelData<FFloat16Color>>(Size, MoveTemp(Pixels)));
+	return ImageTask.RunTask();
+#else
+	UE_LOG(LogEasySynth, Error, TEXT("%s: EXR support is not available"), *FString(__FUNCTION__))
+	return false;
+#endif // WITH_UNREALEXR
+}
+
+bool FDepthOpticalFlow::WriteCompressedImage(
+	const FString& FilePath,
+	const void* RawData,
+	const int64 RawSize,
+	const FIntPoint Size,
+	const EImageFormat Format,
+	const ERGBFormat RGBFormat,
+	const TMap<FString, FStringFormatArg>& Metadata)
+{
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>("ImageWrapper");
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(Format);
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(RawData, RawSize, Size.X, Size.Y, RGBFormat, 8))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not encode %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	// Frame metadata read from the depth image is embedded while writing, the same as into EXR headers
+	TArray64<uint8> FileData = ImageWrapper->GetCompressed();
+	const TArray<TPair<FString, FString>> FrameValues = FFrameMetadata::FrameValuesFromAttributes(Metadata);
+	if (Format == EImageFormat::PNG && FrameValues.Num() > 0 &&
+		!FFrameMetadata::InsertPngTextChunks(FileData, FrameValues))
+	{
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(FileData, *FilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not write %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	return true;
+}
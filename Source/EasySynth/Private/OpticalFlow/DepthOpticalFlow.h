@@ -0,0 +1,137 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IImageWrapper.h"
+
+#include "EXROutput/MoviePipelineEXROutputLocal.h"
+
+
+/**
+ * Derives camera induced optical flow of static scenes from rendered depth images and camera poses,
+ * producing the same images as the optical flow target without rendering it
+ * Settings are copied on construction, so the generation can run on worker threads
+*/
+class FDepthOpticalFlow
+{
+public:
+	FDepthOpticalFlow(
+		const TArray<FTransform>& FramePoses,
+		const FVector4& CameraIntrinsics,
+		const float DepthRangeMeters,
+		const float FlowScale,
+		const EImageFormat FlowImageFormat,
+		const UMoviePipelineImageSequenceOutput_EXRLocal* ExrSetting);
+
+	/**
+	 * Generates a flow image for each EXR depth frame inside the depth directory,
+	 * frames are matched with camera poses in the order of their file names
+	 * If the directories are provided, backward flow toward the next frame and occlusion masks
+	 * from the forward-backward consistency check are generated as well
+	*/
+	bool GenerateFlowImages(
+		const FString& DepthDir,
+		const FString& FlowDir,
+		const FString& BackwardFlowDir = FString(),
+		const FString& OcclusionMaskDir = FString()) const;
+
+	/**
+	 * Computes the flow of each pixel from the target camera pose to the frame camera pose,
+	 * in image coordinates scaled to a 1.0 x 1.0 square, by reprojecting frame depth into the target camera
+	 * Pixels that fall behind the target camera get zero flow
+	*/
+	void ComputeFlow(
+		const TArray64<float>& Depth,
+		const FIntPoint Size,
+		const FTransform& FramePose,
+		const FTransform& TargetPose,
+		TArray64<FVector2f>& OutFlow) const;
+
+	/**
+	 * Marks pixels whose forward flow is not undone by the backward flow of the previous frame at the position
+	 * the forward flow points to, which are the pixels occluded or outside of the image in the previous frame
+	 * Consistent pixels are set to 255 and occluded ones to 0
+	*/
+	static void ComputeOcclusionMask(
+		const TArray64<FVector2f>& Flow,
+		const TArray64<FVector2f>& PreviousBackwardFlow,
+		const FIntPoint Size,
+		TArray64<uint8>& OutMask);
+
+	/**
+	 * Reads the depth channel of an EXR depth image in centimeters, given the depth range in centimeters
+	 * Pixels at or beyond the depth range are infinitely far away
+	*/
+	static bool ReadDepth(
+		const FString& FilePath,
+		const float DepthRange,
+		TArray64<float>& OutDepth,
+		FIntPoint& OutSize,
+		TMap<FString, FStringFormatArg>& OutMetadata);
+
+	/** Encodes flow using the HSV color wheel, the same way as the optical flow post process material */
+	static FLinearColor EncodeFlow(const FVector2f& Flow, const float Scale);
+
+private:
+	/** Writes encoded flow in the requested image format */
+	bool WriteFlowImage(
+		const FString& FilePath,
+		const TArray64<FVector2f>& Flow,
+		const FIntPoint Size,
+		const TMap<FString, FStringFormatArg>& Metadata) const;
+
+	/** Writes a mask as an EXR image if flow is written as EXR, otherwise as a grayscale PNG image */
+	bool WriteMaskImage(
+		const FString& FilePath,
+		const TArray64<uint8>& Mask,
+		const FIntPoint Size,
+		const TMap<FString, FStringFormatArg>& Metadata) const;
+
+	/** Writes an EXR image with the selected compression and tiling */
+	bool WriteExrImage(
+		const FString& FilePath,
+		TArray64<FFloat16Color>&& Pixels,
+		const FIntPoint Size,
+		const TMap<FString, FStringFormatArg>& Metadata) const;
+
+	/** Compresses raw pixels with the image wrapper and writes them, PNG images also get the frame metadata */
+	static bool WriteCompressedImage(
+		const FString& FilePath,
+		const void* RawData,
+		const int64 RawSize,
+		const FIntPoint Size,
+		const EImageFormat Format,
+		const ERGBFormat RGBFormat,
+		const TMap<FString, FStringFormatArg>& Metadata);
+
+	/** Relative tolerance of the consistency check, compared to the squared lengths of both flows */
+	static const float ConsistencyRelativeTolerance;
+
+	/** Absolute tolerance of the consistency check in squared pixels */
+	static const float ConsistencyAbsoluteTolerance;
+
+	/** Camera pose of each frame */
+	TArray<FTransform> CameraPoses;
+
+	/** Camera intrinsics packed as (fx, fy, cx, cy) */
+	FVector4f Intrinsics;
+
+	/** Depth range in centimeters, the range of depth image values [0, 1] is mapped to */
+	float DepthRange;
+
+	/** Scaling coefficient for increasing the saturation of flow images */
+	float OpticalFlowScale;
+
+	/** Format of the generated flow images */
+	EImageFormat ImageFormat;
+
+	/** Compression of EXR flow images */
+	EEXRCompressionFormatLocal ExrCompression;
+
+	/** Tile size of EXR flow images, zero writes scanline files */
+	int32 ExrTileSize;
+
+	/** Whether tiled EXR flow images contain mip levels */
+	bool bExrMipLevels;
+};
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "OpticalFlow/FlowValidationCommandlet.h"
+
+#include "Misc/Parse.h"
+
+#include "EasySynth.h"
+#include "OpticalFlow/FlowValidator.h"
+
+
+UFlowValidationCommandlet::UFlowValidationCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UFlowValidationCommandlet::Main(const FString& Params)
+{
+	FString ImageDir;
+	FString FlowDir;
+	FString OutputDir;
+	FString MaskDir;
+	float OpticalFlowScale = 1.0f;
+	if (!FParse::Value(*Params, TEXT("ImageDir="), ImageDir) ||
+		!FParse::Value(*Params, TEXT("FlowDir="), FlowDir) ||
+		!FParse::Value(*Params, TEXT("OutputDir="), OutputDir))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Expected -ImageDir=<dir> -FlowDir=<dir> -OutputDir=<dir> arguments"),
+			*FString(__FUNCTION__))
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("MaskDir="), MaskDir);
+	FParse::Value(*Params, TEXT("OpticalFlowScale="), OpticalFlowScale);
+	const bool bWriteWarpedImages = FParse::Param(*Params, TEXT("WriteWarped"));
+
+	if (OpticalFlowScale <= 0.0f)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Optical flow scale has to be positive"), *FString(__FUNCTION__))
+		return 1;
+	}
+
+	const FFlowValidator FlowValidator(OpticalFlowScale);
+	return FlowValidator.ValidateDirectories(ImageDir, FlowDir, MaskDir, OutputDir, bWriteWarpedImages) ? 0 : 1;
+}
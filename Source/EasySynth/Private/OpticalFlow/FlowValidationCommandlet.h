@@ -0,0 +1,27 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "FlowValidationCommandlet.generated.h"
+
+
+/**
+ * Batch warps color images with optical flow images of a rendering output and reports photometric errors,
+ * runs without the editor UI, e.g. on nodes without a GPU:
+ * UnrealEditor-Cmd <Project>.uproject -run=FlowValidation -ImageDir=<dir> -FlowDir=<dir> -OutputDir=<dir>
+ *     [-MaskDir=<dir>] [-OpticalFlowScale=<scale>] [-WriteWarped] -nullrhi
+*/
+UCLASS()
+class UFlowValidationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFlowValidationCommandlet();
+
+	/** Runs the validation, returns a non-zero code on failure */
+	virtual int32 Main(const FString& Params) override;
+};
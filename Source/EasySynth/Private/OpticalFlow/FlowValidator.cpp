@@ -0,0 +1,387 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "OpticalFlow/FlowValidator.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "ImagePixelData.h"
+#include "Math/VectorRegister.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "EasySynth.h"
+#include "EXROutput/ExrLayerMerger.h"
+#include "PathUtils.h"
+
+
+FFlowValidator::FFlowValidator(const float FlowScale) :
+	OpticalFlowScale(FlowScale)
+{
+	// Image wrappers are created from worker threads, where modules cannot be loaded
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+}
+
+bool FFlowValidator::ValidateDirectories(
+	const FString& ImageDir,
+	const FString& FlowDir,
+	const FString& MaskDir,
+	const FString& OutputDir,
+	const bool bWriteWarpedImages) const
+{
+	const TArray<FString> ImageFiles = FindImageFiles(ImageDir);
+	const TArray<FString> FlowFiles = FindImageFiles(FlowDir);
+	const TArray<FString> MaskFiles = MaskDir.IsEmpty() ? TArray<FString>() : FindImageFiles(MaskDir);
+	if (ImageFiles.Num() != FlowFiles.Num() || (!MaskDir.IsEmpty() && MaskFiles.Num() != FlowFiles.Num()))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Found %d color, %d flow and %d mask images, expected matching counts"),
+			*FString(__FUNCTION__), ImageFiles.Num(), FlowFiles.Num(), MaskFiles.Num())
+		return false;
+	}
+	if (ImageFiles.Num() < 2)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: At least two frames are needed inside %s"), *FString(__FUNCTION__), *ImageDir)
+		return false;
+	}
+
+	IFileManager::Get().MakeDirectory(*OutputDir, true);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Flow of the first frame has no previous image to be applied to
+	TArray<FFrameStats> FrameStats;
+	FrameStats.SetNum(ImageFiles.Num() - 1);
+	std::atomic<int32> FailedFrames(0);
+	ParallelFor(FrameStats.Num(), [&](const int32 Index)
+	{
+		const int32 Frame = Index + 1;
+		const FString WarpedImagePath = bWriteWarpedImages ?
+			OutputDir / FPaths::GetBaseFilename(ImageFiles[Frame]) + TEXT(".png") : FString();
+		if (!ValidateFrame(
+			ImageDir / ImageFiles[Frame - 1],
+			ImageDir / ImageFiles[Frame],
+			FlowDir / FlowFiles[Frame],
+			MaskDir.IsEmpty() ? FString() : MaskDir / MaskFiles[Frame],
+			WarpedImagePath,
+			FrameStats[Index]))
+		{
+			FailedFrames++;
+		}
+	});
+
+	if (FailedFrames > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to validate %d of %d frames"),
+			*FString(__FUNCTION__), FailedFrames.load(), FrameStats.Num())
+		return false;
+	}
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("frame,valid_pixels,mean_absolute_error,rmse,psnr"));
+	double PsnrSum = 0.0;
+	for (const FFrameStats& Stats : FrameStats)
+	{
+		Lines.Add(FString::Printf(TEXT("%s,%lld,%.6f,%.6f,%.3f"),
+			*Stats.FrameName, Stats.ValidPixels, Stats.MeanAbsoluteError, Stats.RootMeanSquareError, Stats.Psnr));
+		PsnrSum += Stats.Psnr;
+	}
+
+	const FString StatsFilePath = FPathUtils::FlowValidationFilePath(OutputDir);
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *StatsFilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *StatsFilePath)
+		return false;
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Validated %d frames in %.2f s, mean PSNR %.2f dB"),
+		*FString(__FUNCTION__), FrameStats.Num(), FPlatformTime::Seconds() - StartTime, PsnrSum / FrameStats.Num())
+
+	return true;
+}
+
+bool FFlowValidator::ValidateFrame(
+	const FString& PreviousImagePath,
+	const FString& ImagePath,
+	const FString& FlowPath,
+	const FString& MaskPath,
+	const FString& WarpedImagePath,
+	FFrameStats& OutStats) const
+{
+	// Color images are compared as stored, while flow colors are decoded from linear values
+	TArray64<FLinearColor> PreviousImage, Image, FlowImage;
+	FIntPoint PreviousSize, Size, FlowSize;
+	bool bHdr = false;
+	bool bFlowHdr = false;
+	if (!ReadImage(PreviousImagePath, false, PreviousImage, PreviousSize, bHdr) ||
+		!ReadImage(ImagePath, false, Image, Size, bHdr) ||
+		!ReadImage(FlowPath, true, FlowImage, FlowSize, bFlowHdr))
+	{
+		return false;
+	}
+	if (PreviousSize != Size || FlowSize != Size)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Image sizes of the frame %s do not match"), *FString(__FUNCTION__), *ImagePath)
+		return false;
+	}
+
+	TArray64<FLinearColor> Warped;
+	TArray64<bool> Valid;
+	WarpImage(PreviousImage, DecodeFlow(FlowImage), Size, Warped, Valid);
+
+	if (!MaskPath.IsEmpty())
+	{
+		TArray64<FLinearColor> Mask;
+		FIntPoint MaskSize;
+		bool bMaskHdr = false;
+		if (!ReadImage(MaskPath, false, Mask, MaskSize, bMaskHdr) || MaskSize != Size)
+		{
+			return false;
+		}
+		for (int64 i = 0; i < Valid.Num(); i++)
+		{
+			Valid[i] = Valid[i] && Mask[i].R > 0.5f;
+		}
+	}
+
+	OutStats = CompareImages(Warped, Image, Valid, Size);
+	OutStats.FrameName = FPaths::GetCleanFilename(ImagePath);
+
+	if (WarpedImagePath.IsEmpty())
+	{
+		return true;
+	}
+
+	// HDR images are sRGB encoded for preview, others keep their encoded values
+	TArray64<FColor> Pixels;
+	Pixels.SetNumUninitialized(Warped.Num());
+	for (int64 i = 0; i < Warped.Num(); i++)
+	{
+		Pixels[i] = Valid[i] ? Warped[i].ToFColor(bHdr) : FColor::Black;
+	}
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>("ImageWrapper");
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() ||
+		!ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), Size.X, Size.Y, ERGBFormat::BGRA, 8))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to encode %s"), *FString(__FUNCTION__), *WarpedImagePath)
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(), *WarpedImagePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *WarpedImagePath)
+		return false;
+	}
+
+	return true;
+}
+
+TArray64<FVector2f> FFlowValidator::DecodeFlow(const TArray64<FLinearColor>& FlowImage) const
+{
+	// Hue holds the flow angle in degrees and saturation its length multiplied by the flow scale
+	TArray64<FVector2f> Flow;
+	Flow.SetNumUninitialized(FlowImage.Num());
+	for (int64 i = 0; i < FlowImage.Num(); i++)
+	{
+		const FLinearColor HSV = FlowImage[i].LinearRGBToHSV();
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(HSV.R));
+		Flow[i] = FVector2f(Cos, Sin) * (HSV.G / OpticalFlowScale);
+	}
+	return Flow;
+}
+
+void FFlowValidator::WarpImage(
+	const TArray64<FLinearColor>& PreviousImage,
+	const TArray64<FVector2f>& Flow,
+	const FIntPoint Size,
+	TArray64<FLinearColor>& OutWarped,
+	TArray64<bool>& OutValid)
+{
+	check(PreviousImage.Num() == int64(Size.X) * Size.Y && Flow.Num() == PreviousImage.Num())
+	OutWarped.SetNumUninitialized(PreviousImage.Num());
+	OutValid.SetNumUninitialized(PreviousImage.Num());
+
+	const FLinearColor* Source = PreviousImage.GetData();
+	ParallelFor(Size.Y, [&](const int32 Y)
+	{
+		for (int32 X = 0; X < Size.X; X++)
+		{
+			const int64 Index = int64(Y) * Size.X + X;
+
+			// Flow spans from the previous to the current position, pixel centers are at half coordinates
+			const float SourceX = X - Flow[Index].X * Size.X;
+			const float SourceY = Y - Flow[Index].Y * Size.Y;
+			if (SourceX < -0.5f || SourceX > Size.X - 0.5f || SourceY < -0.5f || SourceY > Size.Y - 0.5f)
+			{
+				OutWarped[Index] = FLinearColor::Black;
+				OutValid[Index] = false;
+				continue;
+			}
+
+			const float ClampedX = FMath::Clamp(SourceX, 0.0f, Size.X - 1.0f);
+			const float ClampedY = FMath::Clamp(SourceY, 0.0f, Size.Y - 1.0f);
+			const int32 X0 = FMath::Min(int32(ClampedX), FMath::Max(Size.X - 2, 0));
+			const int32 Y0 = FMath::Min(int32(ClampedY), FMath::Max(Size.Y - 2, 0));
+			const int64 Row0 = int64(Y0) * Size.X;
+			const int64 Row1 = int64(FMath::Min(Y0 + 1, Size.Y - 1)) * Size.X;
+			const int32 X1 = FMath::Min(X0 + 1, Size.X - 1);
+
+			// All four channels of a texel are interpolated at once
+			const VectorRegister4Float Tx = VectorSetFloat1(ClampedX - X0);
+			const VectorRegister4Float Ty = VectorSetFloat1(ClampedY - Y0);
+			const VectorRegister4Float C00 = VectorLoad(&Source[Row0 + X0].R);
+			const VectorRegister4Float C01 = VectorLoad(&Source[Row0 + X1].R);
+			const VectorRegister4Float C10 = VectorLoad(&Source[Row1 + X0].R);
+			const VectorRegister4Float C11 = VectorLoad(&Source[Row1 + X1].R);
+			const VectorRegister4Float Top = VectorMultiplyAdd(VectorSubtract(C01, C00), Tx, C00);
+			const VectorRegister4Float Bottom = VectorMultiplyAdd(VectorSubtract(C11, C10), Tx, C10);
+			VectorStore(VectorMultiplyAdd(VectorSubtract(Bottom, Top), Ty, Top), &OutWarped[Index].R);
+			OutValid[Index] = true;
+		}
+	});
+}
+
+FFlowValidator::FFrameStats FFlowValidator::CompareImages(
+	const TArray64<FLinearColor>& Warped,
+	const TArray64<FLinearColor>& Image,
+	const TArray64<bool>& Valid,
+	const FIntPoint Size)
+{
+	check(Warped.Num() == int64(Size.X) * Size.Y && Image.Num() == Warped.Num() && Valid.Num() == Warped.Num())
+
+	// Rows are summed in float registers and accumulated in double precision
+	TArray<double> RowAbsoluteSums, RowSquareSums;
+	TArray<int64> RowValidPixels;
+	RowAbsoluteSums.SetNumZeroed(Size.Y);
+	RowSquareSums.SetNumZeroed(Size.Y);
+	RowValidPixels.SetNumZeroed(Size.Y);
+	const VectorRegister4Float ColorMask = MakeVectorRegisterFloat(1.0f, 1.0f, 1.0f, 0.0f);
+
+	ParallelFor(Size.Y, [&](const int32 Y)
+	{
+		VectorRegister4Float AbsoluteSum = VectorZero();
+		VectorRegister4Float SquareSum = VectorZero();
+		int64 ValidPixels = 0;
+		for (int64 Index = int64(Y) * Size.X; Index < int64(Y + 1) * Size.X; Index++)
+		{
+			if (!Valid[Index])
+			{
+				continue;
+			}
+			const VectorRegister4Float Difference = VectorMultiply(
+				VectorAbs(VectorSubtract(VectorLoad(&Warped[Index].R), VectorLoad(&Image[Index].R))), ColorMask);
+			AbsoluteSum = VectorAdd(AbsoluteSum, Difference);
+			SquareSum = VectorMultiplyAdd(Difference, Difference, SquareSum);
+			ValidPixels++;
+		}
+
+		alignas(16) float Absolute[4];
+		alignas(16) float Square[4];
+		VectorStoreAligned(AbsoluteSum, Absolute);
+		VectorStoreAligned(SquareSum, Square);
+		RowAbsoluteSums[Y] = double(Absolute[0]) + Absolute[1] + Absolute[2];
+		RowSquareSums[Y] = double(Square[0]) + Square[1] + Square[2];
+		RowValidPixels[Y] = ValidPixels;
+	});
+
+	FFrameStats Stats;
+	double AbsoluteSum = 0.0;
+	double SquareSum = 0.0;
+	for (int32 Y = 0; Y < Size.Y; Y++)
+	{
+		AbsoluteSum += RowAbsoluteSums[Y];
+		SquareSum += RowSquareSums[Y];
+		Stats.ValidPixels += RowValidPixels[Y];
+	}
+
+	if (Stats.ValidPixels > 0)
+	{
+		const double Samples = 3.0 * Stats.ValidPixels;
+		const double MeanSquareError = SquareSum / Samples;
+		Stats.MeanAbsoluteError = AbsoluteSum / Samples;
+		Stats.RootMeanSquareError = FMath::Sqrt(MeanSquareError);
+		Stats.Psnr = MeanSquareError > 0.0 ? -10.0 * FMath::LogX(10.0, MeanSquareError) : 100.0;
+	}
+	return Stats;
+}
+
+bool FFlowValidator::ReadImage(
+	const FString& FilePath,
+	const bool bLinearize,
+	TArray64<FLinearColor>& OutPixels,
+	FIntPoint& OutSize,
+	bool& bOutHdr)
+{
+	bOutHdr = FPaths::GetExtension(FilePath).Equals(TEXT("exr"), ESearchCase::IgnoreCase);
+	if (bOutHdr)
+	{
+		TUniquePtr<FImagePixelData> Image = FExrLayerMerger::ReadImage(FilePath);
+		if (!Image.IsValid())
+		{
+			return false;
+		}
+
+		const void* RawData = nullptr;
+		int64 RawSize = 0;
+		Image->GetRawData(RawData, RawSize);
+		OutSize = Image->GetSize();
+		OutPixels.SetNumUninitialized(int64(OutSize.X) * OutSize.Y);
+		if (Image->GetType() == EImagePixelType::Float32)
+		{
+			FMemory::Memcpy(OutPixels.GetData(), RawData, OutPixels.Num() * sizeof(FLinearColor));
+		}
+		else
+		{
+			const FFloat16Color* Pixels = static_cast<const FFloat16Color*>(RawData);
+			for (int64 i = 0; i < OutPixels.Num(); i++)
+			{
+				OutPixels[i] = FLinearColor(Pixels[i]);
+			}
+		}
+		return true;
+	}
+
+	TArray64<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not load %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>("ImageWrapper");
+	const EImageFormat ImageFormat = ImageWrapperModule.DetectImageFormat(FileData.GetData(), FileData.Num());
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(ImageFormat);
+	TArray64<uint8> RawData;
+	if (!ImageWrapper.IsValid() ||
+		!ImageWrapper->SetCompressed(FileData.GetData(), FileData.Num()) ||
+		!ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, RawData))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not decode %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	OutSize = FIntPoint(ImageWrapper->GetWidth(), ImageWrapper->GetHeight());
+	const FColor* Pixels = reinterpret_cast<const FColor*>(RawData.GetData());
+	OutPixels.SetNumUninitialized(int64(OutSize.X) * OutSize.Y);
+	for (int64 i = 0; i < OutPixels.Num(); i++)
+	{
+		OutPixels[i] = bLinearize ? FLinearColor(Pixels[i]) : Pixels[i].ReinterpretAsLinear();
+	}
+	return true;
+}
+
+TArray<FString> FFlowValidator::FindImageFiles(const FString& Directory)
+{
+	TArray<FString> Files;
+	for (const TCHAR* Extension : { TEXT("exr"), TEXT("png"), TEXT("jpeg"), TEXT("jpg") })
+	{
+		TArray<FString> ExtensionFiles;
+		IFileManager::Get().FindFiles(ExtensionFiles, *Directory, Extension);
+		Files.Append(ExtensionFiles);
+	}
+	Files.Sort();
+	return Files;
+}
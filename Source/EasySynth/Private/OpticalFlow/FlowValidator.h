@@ -0,0 +1,95 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Warps the previous color image of each frame with its optical flow image
+ * and measures the photometric error against the current color image, to validate flow quality
+*/
+class FFlowValidator
+{
+public:
+	/** Photometric error of a single warped frame */
+	struct FFrameStats
+	{
+		/** Name of the validated frame file */
+		FString FrameName;
+
+		/** Number of pixels that were warped from inside the previous image and not masked out */
+		int64 ValidPixels = 0;
+
+		/** Mean absolute error over the color channels of valid pixels */
+		double MeanAbsoluteError = 0.0;
+
+		/** Root mean square error over the color channels of valid pixels */
+		double RootMeanSquareError = 0.0;
+
+		/** Peak signal to noise ratio in dB, relative to the peak value of 1 */
+		double Psnr = 0.0;
+	};
+
+	explicit FFlowValidator(const float FlowScale);
+
+	/**
+	 * Validates all frames of matching color and flow image directories, frames are matched in the order
+	 * of their file names, optional masks exclude occluded pixels from the statistics
+	 * Statistics are saved to the output directory, together with warped images if requested
+	*/
+	bool ValidateDirectories(
+		const FString& ImageDir,
+		const FString& FlowDir,
+		const FString& MaskDir,
+		const FString& OutputDir,
+		const bool bWriteWarpedImages) const;
+
+	/** Decodes an HSV color coded flow image into flow vectors, in image coordinates scaled to a 1.0 x 1.0 square */
+	TArray64<FVector2f> DecodeFlow(const TArray64<FLinearColor>& FlowImage) const;
+
+	/**
+	 * Samples the previous image at the position each pixel content had according to the flow,
+	 * pixels whose content was outside of the previous image are black and marked invalid
+	*/
+	static void WarpImage(
+		const TArray64<FLinearColor>& PreviousImage,
+		const TArray64<FVector2f>& Flow,
+		const FIntPoint Size,
+		TArray64<FLinearColor>& OutWarped,
+		TArray64<bool>& OutValid);
+
+	/** Computes the photometric error of the color channels over valid pixels */
+	static FFrameStats CompareImages(
+		const TArray64<FLinearColor>& Warped,
+		const TArray64<FLinearColor>& Image,
+		const TArray64<bool>& Valid,
+		const FIntPoint Size);
+
+	/**
+	 * Reads an EXR, PNG or JPEG image, 8-bit images are converted from sRGB to linear if requested,
+	 * otherwise their encoded values are kept
+	*/
+	static bool ReadImage(
+		const FString& FilePath,
+		const bool bLinearize,
+		TArray64<FLinearColor>& OutPixels,
+		FIntPoint& OutSize,
+		bool& bOutHdr);
+
+private:
+	/** Validates a single frame and writes its warped image if requested */
+	bool ValidateFrame(
+		const FString& PreviousImagePath,
+		const FString& ImagePath,
+		const FString& FlowPath,
+		const FString& MaskPath,
+		const FString& WarpedImagePath,
+		FFrameStats& OutStats) const;
+
+	/** Lists image files inside a directory sorted by name */
+	static TArray<FString> FindImageFiles(const FString& Directory);
+
+	/** Scaling coefficient the flow images were rendered with */
+	float OpticalFlowScale;
+};
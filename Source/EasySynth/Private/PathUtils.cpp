@@ -15,4 +15,14 @@ const FString FPathUtils::WidgetStateAssetName(TEXT("WidgetStateAsset"));
 const FString FPathUtils::RenderingOutputDirName(TEXT("RenderingOutput"));
 const FString FPathUtils::CameraRigFileName(TEXT("CameraRig.json"));
 const FString FPathUtils::SemanticClassesFileName(TEXT("SemanticClasses.csv"));
+const FString FPathUtils::SemanticClassIdsFileName(TEXT("SemanticClassIds.csv"));
+const FString FPathUtils::SemanticUnmatchedPixelsFileName(TEXT("SemanticUnmatchedPixels.csv"));
+const FString FPathUtils::MaskAnnotationsFileName(TEXT("Annotations.jsonl"));
+const FString FPathUtils::InstanceIdsFileName(TEXT("InstanceIds.csv"));
+const FString FPathUtils::FlowValidationFileName(TEXT("FlowValidation.csv"));
 const FString FPathUtils::CameraPosesFileName(TEXT("CameraPoses.csv"));
+const FString FPathUtils::BoundingBoxesFileName(TEXT("BoundingBoxes.bin"));
+const FString FPathUtils::BackwardOpticalFlowDirName(TEXT("OpticalFlowBackwardImage"));
+const FString FPathUtils::OcclusionMaskDirName(TEXT("OcclusionMaskImage"));
+const FString FPathUtils::PointCloudDirName(TEXT("PointCloud"));
+const FString FPathUtils::LidarDirName(TEXT("Lidar"));
@@ -0,0 +1,359 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "PointCloud/DepthPointCloud.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Math/VectorRegister.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "EasySynth.h"
+#include "OpticalFlow/DepthOpticalFlow.h"
+
+
+FDepthPointCloud::FDepthPointCloud(
+	const TArray<FTransform>& FramePoses,
+	const FVector4& CameraIntrinsics,
+	const float DepthRangeMeters,
+	const EFormat FileFormat) :
+	CameraPoses(FramePoses),
+	Intrinsics(CameraIntrinsics),
+	DepthRange(DepthRangeMeters * 100.0f),
+	Format(FileFormat)
+{}
+
+bool FDepthPointCloud::GeneratePointClouds(const FString& DepthDir, const FString& OutputDir) const
+{
+	TArray<FString> FrameFileNames;
+	IFileManager::Get().FindFiles(FrameFileNames, *DepthDir, TEXT("exr"));
+	FrameFileNames.Sort();
+
+	if (FrameFileNames.Num() != CameraPoses.Num())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Found %d depth frames inside %s, but got %d camera poses"),
+			*FString(__FUNCTION__), FrameFileNames.Num(), *DepthDir, CameraPoses.Num())
+		return false;
+	}
+
+	IFileManager::Get().MakeDirectory(*OutputDir, true);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	std::atomic<int32> FailedFrames(0);
+	std::atomic<int64> TotalPoints(0);
+	ParallelFor(FrameFileNames.Num(), [&](const int32 Index)
+	{
+		TArray64<float> Depth;
+		FIntPoint Size;
+		TMap<FString, FStringFormatArg> Metadata;
+		if (!FDepthOpticalFlow::ReadDepth(DepthDir / FrameFileNames[Index], DepthRange, Depth, Size, Metadata))
+		{
+			FailedFrames++;
+			return;
+		}
+
+		TArray64<FVector3f> Points;
+		BackProject(Depth, Size, CameraPoses[Index], Points);
+		TotalPoints += Points.Num();
+
+		const FString FilePath = OutputDir / FPaths::GetBaseFilename(FrameFileNames[Index]) + TEXT(".") + Extension(Format);
+		const uint8* PointData = reinterpret_cast<const uint8*>(Points.GetData());
+		if (!WritePoints(FilePath, PointData, Points.Num(), PositionProperties(), Format))
+		{
+			FailedFrames++;
+		}
+	});
+
+	if (FailedFrames > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to generate %d of %d point clouds inside %s"),
+			*FString(__FUNCTION__), FailedFrames.load(), FrameFileNames.Num(), *OutputDir)
+		return false;
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Generated %d point clouds with %lld points in %.2f s"),
+		*FString(__FUNCTION__), FrameFileNames.Num(), TotalPoints.load(), FPlatformTime::Seconds() - StartTime)
+
+	return true;
+}
+
+void FDepthPointCloud::BackProject(
+	const TArray64<float>& Depth,
+	const FIntPoint Size,
+	const FTransform& CameraPose,
+	TArray64<FVector3f>& OutPoints) const
+{
+	check(Depth.Num() == int64(Size.X) * Size.Y)
+
+	// Takes row vectors from the camera space into the world space
+	const FMatrix44f Pose(CameraPose.ToMatrixNoScale());
+
+	// Camera space point of a pixel is its depth multiplied by the ray (1, (u - cx) / fx, (cy - v) / fy)
+	const VectorRegister4Float Cx = VectorSetFloat1(Intrinsics.Z);
+	const VectorRegister4Float InvFx = VectorSetFloat1(1.0f / Intrinsics.X);
+	const VectorRegister4Float Range = VectorSetFloat1(DepthRange);
+	const VectorRegister4Float LaneOffsets = MakeVectorRegisterFloat(0.5f, 1.5f, 2.5f, 3.5f);
+	const VectorRegister4Float Mx1 = VectorSetFloat1(Pose.M[1][0]);
+	const VectorRegister4Float My1 = VectorSetFloat1(Pose.M[1][1]);
+	const VectorRegister4Float Mz1 = VectorSetFloat1(Pose.M[1][2]);
+	const VectorRegister4Float Tx = VectorSetFloat1(Pose.M[3][0]);
+	const VectorRegister4Float Ty = VectorSetFloat1(Pose.M[3][1]);
+	const VectorRegister4Float Tz = VectorSetFloat1(Pose.M[3][2]);
+
+	// Rows produce varying numbers of points, so they are gathered separately and concatenated afterwards
+	TArray<TArray<FVector3f>> RowPoints;
+	RowPoints.SetNum(Size.Y);
+
+	ParallelFor(Size.Y, [&](const int32 Y)
+	{
+		const float RayZ = (Intrinsics.W - (Y + 0.5f)) / Intrinsics.Y;
+
+		// Part of the rotated ray that is constant along the row
+		const VectorRegister4Float RowX = VectorSetFloat1(Pose.M[0][0] + RayZ * Pose.M[2][0]);
+		const VectorRegister4Float RowY = VectorSetFloat1(Pose.M[0][1] + RayZ * Pose.M[2][1]);
+		const VectorRegister4Float RowZ = VectorSetFloat1(Pose.M[0][2] + RayZ * Pose.M[2][2]);
+
+		const float* DepthRow = Depth.GetData() + int64(Y) * Size.X;
+		TArray<FVector3f>& Points = RowPoints[Y];
+		Points.Reserve(Size.X);
+
+		for (int32 X = 0; X < Size.X; X += 4)
+		{
+			// The row tail is padded with empty depth
+			const int32 Lanes = FMath::Min(4, Size.X - X);
+			alignas(16) float DepthLanes[4] = { DepthRange, DepthRange, DepthRange, DepthRange };
+			FMemory::Memcpy(DepthLanes, DepthRow + X, Lanes * sizeof(float));
+
+			const VectorRegister4Float D = VectorLoadAligned(DepthLanes);
+			const int32 Finite = VectorMaskBits(VectorCompareLT(D, Range));
+			if (Finite == 0)
+			{
+				continue;
+			}
+
+			const VectorRegister4Float U = VectorAdd(VectorSetFloat1(float(X)), LaneOffsets);
+			const VectorRegister4Float RayY = VectorMultiply(VectorSubtract(U, Cx), InvFx);
+			const VectorRegister4Float Wx = VectorMultiplyAdd(D, VectorMultiplyAdd(RayY, Mx1, RowX), Tx);
+			const VectorRegister4Float Wy = VectorMultiplyAdd(D, VectorMultiplyAdd(RayY, My1, RowY), Ty);
+			const VectorRegister4Float Wz = VectorMultiplyAdd(D, VectorMultiplyAdd(RayY, Mz1, RowZ), Tz);
+
+			alignas(16) float XLanes[4];
+			alignas(16) float YLanes[4];
+			alignas(16) float ZLanes[4];
+			VectorStoreAligned(Wx, XLanes);
+			VectorStoreAligned(Wy, YLanes);
+			VectorStoreAligned(Wz, ZLanes);
+			for (int32 Lane = 0; Lane < Lanes; Lane++)
+			{
+				if (Finite & (1 << Lane))
+				{
+					Points.Emplace(XLanes[Lane], YLanes[Lane], ZLanes[Lane]);
+				}
+			}
+		}
+	});
+
+	int64 NumPoints = 0;
+	for (const TArray<FVector3f>& Points : RowPoints)
+	{
+		NumPoints += Points.Num();
+	}
+	OutPoints.Reset(NumPoints);
+	for (const TArray<FVector3f>& Points : RowPoints)
+	{
+		OutPoints.Append(Points);
+	}
+}
+
+bool FDepthPointCloud::MergePointClouds(
+	const TArray<FString>& CameraPointCloudDirs,
+	const FString& OutputDir,
+	const EFormat FileFormat,
+	const TArray<FPointProperty>& Properties)
+{
+	if (CameraPointCloudDirs.Num() == 0)
+	{
+		return true;
+	}
+
+	// All cameras render the same frames, so the first one defines the frame files
+	TArray<FString> FrameFileNames;
+	IFileManager::Get().FindFiles(FrameFileNames, *CameraPointCloudDirs[0], Extension(FileFormat));
+	FrameFileNames.Sort();
+
+	IFileManager::Get().MakeDirectory(*OutputDir, true);
+
+	const int32 Stride = PointStride(Properties);
+	std::atomic<int32> FailedFrames(0);
+	ParallelFor(FrameFileNames.Num(), [&](const int32 Index)
+	{
+		TArray64<uint8> MergedData;
+		TArray64<uint8> CameraData;
+		for (const FString& CameraDir : CameraPointCloudDirs)
+		{
+			if (!ReadPoints(CameraDir / FrameFileNames[Index], FileFormat, Stride, CameraData))
+			{
+				FailedFrames++;
+				return;
+			}
+			MergedData.Append(CameraData);
+		}
+
+		const int64 NumPoints = MergedData.Num() / Stride;
+		if (!WritePoints(OutputDir / FrameFileNames[Index], MergedData.GetData(), NumPoints, Properties, FileFormat))
+		{
+			FailedFrames++;
+		}
+	});
+
+	if (FailedFrames > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to merge %d of %d point clouds inside %s"),
+			*FString(__FUNCTION__), FailedFrames.load(), FrameFileNames.Num(), *OutputDir)
+		return false;
+	}
+
+	return true;
+}
+
+bool FDepthPointCloud::WritePoints(
+	const FString& FilePath,
+	const uint8* PointData,
+	const int64 NumPoints,
+	const TArray<FPointProperty>& Properties,
+	const EFormat FileFormat)
+{
+	// Header characters are all single bytes
+	TArray<uint8> Header;
+	if (FileFormat == EFormat::NPY)
+	{
+		FString Descriptor;
+		FString Shape;
+		const bool bMixedTypes = Properties.ContainsByPredicate(
+			[](const FPointProperty& Property) { return Property.Type != EPropertyType::Float; });
+		if (bMixedTypes)
+		{
+			TArray<FString> Fields;
+			for (const FPointProperty& Property : Properties)
+			{
+				Fields.Add(FString::Printf(TEXT("('%s', '%s')"),
+					Property.Name, Property.Type == EPropertyType::Float ? TEXT("<f4") : TEXT("<u2")));
+			}
+			Descriptor = TEXT("[") + FString::Join(Fields, TEXT(", ")) + TEXT("]");
+			Shape = FString::Printf(TEXT("(%lld,)"), NumPoints);
+		}
+		else
+		{
+			Descriptor = TEXT("'<f4'");
+			Shape = FString::Printf(TEXT("(%lld, %d)"), NumPoints, Properties.Num());
+		}
+
+		// Version 1.0 header, padded so the data starts at a multiple of 64 bytes
+		FString Dictionary = FString::Printf(
+			TEXT("{'descr': %s, 'fortran_order': False, 'shape': %s, }"), *Descriptor, *Shape);
+		const int32 PrefixLength = 10;
+		const int32 PaddedLength = Align(PrefixLength + Dictionary.Len() + 1, 64);
+		Dictionary += FString::ChrN(PaddedLength - PrefixLength - Dictionary.Len() - 1, TEXT(' ')) + TEXT("\n");
+
+		const uint8 Prefix[] = { 0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+			uint8(Dictionary.Len() & 0xFF), uint8(Dictionary.Len() >> 8) };
+		Header.Append(Prefix, PrefixLength);
+		Header.Append(reinterpret_cast<const uint8*>(TCHAR_TO_ANSI(*Dictionary)), Dictionary.Len());
+	}
+	else
+	{
+		FString PlyHeader = FString::Printf(
+			TEXT("ply\nformat binary_little_endian 1.0\nelement vertex %lld\n"), NumPoints);
+		for (const FPointProperty& Property : Properties)
+		{
+			PlyHeader += FString::Printf(TEXT("property %s %s\n"),
+				Property.Type == EPropertyType::Float ? TEXT("float") : TEXT("ushort"), Property.Name);
+		}
+		PlyHeader += TEXT("end_header\n");
+		Header.Append(reinterpret_cast<const uint8*>(TCHAR_TO_ANSI(*PlyHeader)), PlyHeader.Len());
+	}
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not open %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	Writer->Serialize(Header.GetData(), Header.Num());
+	Writer->Serialize(const_cast<uint8*>(PointData), NumPoints * PointStride(Properties));
+
+	if (!Writer->Close())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	return true;
+}
+
+const TArray<FDepthPointCloud::FPointProperty>& FDepthPointCloud::PositionProperties()
+{
+	static const TArray<FPointProperty> Properties = {
+		{ TEXT("x"), EPropertyType::Float },
+		{ TEXT("y"), EPropertyType::Float },
+		{ TEXT("z"), EPropertyType::Float } };
+	return Properties;
+}
+
+int32 FDepthPointCloud::PointStride(const TArray<FPointProperty>& Properties)
+{
+	int32 Stride = 0;
+	for (const FPointProperty& Property : Properties)
+	{
+		Stride += Property.Type == EPropertyType::Float ? sizeof(float) : sizeof(uint16);
+	}
+	return Stride;
+}
+
+bool FDepthPointCloud::ReadPoints(
+	const FString& FilePath,
+	const EFormat FileFormat,
+	const int32 Stride,
+	TArray64<uint8>& OutPointData)
+{
+	TArray64<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not load %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	int64 DataOffset = INDEX_NONE;
+	if (FileFormat == EFormat::NPY)
+	{
+		if (FileData.Num() >= 10)
+		{
+			DataOffset = 10 + (FileData[8] | (FileData[9] << 8));
+		}
+	}
+	else
+	{
+		const char EndHeader[] = "end_header\n";
+		const int64 EndHeaderLength = sizeof(EndHeader) - 1;
+		for (int64 i = 0; i + EndHeaderLength <= FileData.Num(); i++)
+		{
+			if (FMemory::Memcmp(FileData.GetData() + i, EndHeader, EndHeaderLength) == 0)
+			{
+				DataOffset = i + EndHeaderLength;
+				break;
+			}
+		}
+	}
+
+	if (DataOffset == INDEX_NONE || DataOffset > FileData.Num() || (FileData.Num() - DataOffset) % Stride != 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Unexpected point cloud layout of %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+
+	OutPointData.Reset(FileData.Num() - DataOffset);
+	OutPointData.Append(FileData.GetData() + DataOffset, FileData.Num() - DataOffset);
+	return true;
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Back-projects rendered depth images into world space point clouds,
+ * points are in centimeters inside the left-handed Z-up coordinate system, the same as camera poses
+ * Settings are copied on construction, so the generation can run on worker threads
+*/
+class FDepthPointCloud
+{
+public:
+	/** Point cloud file formats */
+	enum class EFormat : uint8 { PLY, NPY };
+
+	/** Scalar types of point properties */
+	enum class EPropertyType : uint8 { Float, UShort };
+
+	/** Named property stored for each point, in the order of the point memory layout */
+	struct FPointProperty
+	{
+		const TCHAR* Name;
+		EPropertyType Type;
+	};
+
+	FDepthPointCloud(
+		const TArray<FTransform>& FramePoses,
+		const FVector4& CameraIntrinsics,
+		const float DepthRangeMeters,
+		const EFormat FileFormat);
+
+	/**
+	 * Writes a point cloud for each EXR depth frame inside the depth directory,
+	 * frames are matched with camera poses in the order of their file names
+	*/
+	bool GeneratePointClouds(const FString& DepthDir, const FString& OutputDir) const;
+
+	/** Back-projects all pixels with finite depth into world space points using the camera pose */
+	void BackProject(
+		const TArray64<float>& Depth,
+		const FIntPoint Size,
+		const FTransform& CameraPose,
+		TArray64<FVector3f>& OutPoints) const;
+
+	/**
+	 * Merges same named point clouds from each of the camera directories into a single point cloud per frame,
+	 * to form one sweep of the whole rig
+	*/
+	static bool MergePointClouds(
+		const TArray<FString>& CameraPointCloudDirs,
+		const FString& OutputDir,
+		const EFormat FileFormat,
+		const TArray<FPointProperty>& Properties = PositionProperties());
+
+	/**
+	 * Writes tightly packed points with the header of the file format,
+	 * NPY files hold a 2D float array if all properties are floats, otherwise a structured array
+	*/
+	static bool WritePoints(
+		const FString& FilePath,
+		const uint8* PointData,
+		const int64 NumPoints,
+		const TArray<FPointProperty>& Properties,
+		const EFormat FileFormat);
+
+	/** Properties of points that only hold their x, y and z coordinates */
+	static const TArray<FPointProperty>& PositionProperties();
+
+	/** Size of a tightly packed point in bytes */
+	static int32 PointStride(const TArray<FPointProperty>& Properties);
+
+	/** Extension of point cloud files */
+	static const TCHAR* Extension(const EFormat FileFormat)
+	{
+		return FileFormat == EFormat::NPY ? TEXT("npy") : TEXT("ply");
+	}
+
+private:
+	/** Reads raw point data from a point cloud file written by this class */
+	static bool ReadPoints(
+		const FString& FilePath,
+		const EFormat FileFormat,
+		const int32 Stride,
+		TArray64<uint8>& OutPointData);
+
+	/** Camera pose of each frame */
+	TArray<FTransform> CameraPoses;
+
+	/** Camera intrinsics packed as (fx, fy, cx, cy) */
+	FVector4f Intrinsics;
+
+	/** Depth range in centimeters, pixels at the range are considered empty */
+	float DepthRange;
+
+	/** Format of the written files */
+	EFormat Format;
+};
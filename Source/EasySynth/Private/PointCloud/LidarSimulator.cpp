@@ -0,0 +1,212 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "PointCloud/LidarSimulator.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#include "EasySynth.h"
+#include "OpticalFlow/DepthOpticalFlow.h"
+
+
+FLidarSimulator::FLidarSimulator(
+	const FBeamPattern& Pattern,
+	const TArray<FRigCamera>& RigCameras,
+	const FIntPoint Resolution,
+	const float DepthRangeMeters,
+	const FDepthPointCloud::EFormat FileFormat) :
+	ImageSize(Resolution),
+	DepthRange(DepthRangeMeters * 100.0f),
+	MaxRange(Pattern.MaxRangeMeters * 100.0f),
+	Format(FileFormat)
+{
+	const int32 Channels = FMath::Max(Pattern.Channels, 1);
+	const int32 Azimuths = FMath::Max(FMath::RoundToInt(360.0f / Pattern.AzimuthResolutionDegrees), 1);
+	const float RingStep = Channels > 1 ? (Pattern.UpperFovDegrees - Pattern.LowerFovDegrees) / (Channels - 1) : 0.0f;
+	const float AzimuthStep = 360.0f / Azimuths;
+
+	for (const FRigCamera& RigCamera : RigCameras)
+	{
+		CameraOrigins.Add(FVector3f(RigCamera.Transform.GetTranslation()));
+	}
+
+	TArray<TArray<FBeam>> CameraBeams;
+	CameraBeams.SetNum(RigCameras.Num());
+
+	for (int32 Ring = 0; Ring < Channels; Ring++)
+	{
+		for (int32 AzimuthIndex = 0; AzimuthIndex < Azimuths; AzimuthIndex++)
+		{
+			const float Azimuth = AzimuthIndex * AzimuthStep;
+			const FVector Direction = FRotator(Pattern.LowerFovDegrees + Ring * RingStep, Azimuth, 0.0f).Vector();
+
+			// The beam goes to the camera that sees it closest to the optical axis
+			int32 BestCamera = INDEX_NONE;
+			double BestForward = 0.0;
+			int32 BestPixelIndex = INDEX_NONE;
+			for (int32 CameraIndex = 0; CameraIndex < RigCameras.Num(); CameraIndex++)
+			{
+				const FVector4& Intrinsics = RigCameras[CameraIndex].Intrinsics;
+				const FVector Local = RigCameras[CameraIndex].Transform.InverseTransformVectorNoScale(Direction);
+				if (Local.X <= BestForward)
+				{
+					continue;
+				}
+
+				const int32 PixelX = FMath::FloorToInt32(Intrinsics.Z + Intrinsics.X * Local.Y / Local.X);
+				const int32 PixelY = FMath::FloorToInt32(Intrinsics.W - Intrinsics.Y * Local.Z / Local.X);
+				if (PixelX < 0 || PixelX >= ImageSize.X || PixelY < 0 || PixelY >= ImageSize.Y)
+				{
+					continue;
+				}
+
+				BestCamera = CameraIndex;
+				BestForward = Local.X;
+				BestPixelIndex = PixelY * ImageSize.X + PixelX;
+			}
+
+			if (BestCamera == INDEX_NONE)
+			{
+				continue;
+			}
+
+			// Depth is measured along the camera axis, so the ray is scaled to reach a unit depth
+			FBeam& Beam = CameraBeams[BestCamera].AddDefaulted_GetRef();
+			Beam.Ray = FVector3f(Direction / BestForward);
+			Beam.PixelIndex = BestPixelIndex;
+			Beam.Ring = Ring;
+		}
+	}
+
+	for (const TArray<FBeam>& SingleCameraBeams : CameraBeams)
+	{
+		CameraBeamOffsets.Add(Beams.Num());
+		Beams.Append(SingleCameraBeams);
+	}
+	CameraBeamOffsets.Add(Beams.Num());
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: %d of %d beams are seen by the rig cameras"),
+		*FString(__FUNCTION__), Beams.Num(), Channels * Azimuths)
+}
+
+bool FLidarSimulator::SampleCamera(const int32 CameraIndex, const FString& DepthDir, const FString& OutputDir) const
+{
+	check(CameraIndex >= 0 && CameraIndex + 1 < CameraBeamOffsets.Num())
+
+	TArray<FString> FrameFileNames;
+	IFileManager::Get().FindFiles(FrameFileNames, *DepthDir, TEXT("exr"));
+	FrameFileNames.Sort();
+
+	IFileManager::Get().MakeDirectory(*OutputDir, true);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	std::atomic<int32> FailedFrames(0);
+	ParallelFor(FrameFileNames.Num(), [&](const int32 Index)
+	{
+		TArray64<float> Depth;
+		FIntPoint Size;
+		TMap<FString, FStringFormatArg> Metadata;
+		if (!FDepthOpticalFlow::ReadDepth(DepthDir / FrameFileNames[Index], DepthRange, Depth, Size, Metadata))
+		{
+			FailedFrames++;
+			return;
+		}
+
+		if (Size != ImageSize)
+		{
+			UE_LOG(LogEasySynth, Error, TEXT("%s: Unexpected size %dx%d of %s"),
+				*FString(__FUNCTION__), Size.X, Size.Y, *FrameFileNames[Index])
+			FailedFrames++;
+			return;
+		}
+
+		TArray64<uint8> PointData;
+		SampleFrame(CameraIndex, Depth, PointData);
+
+		const FString FilePath = OutputDir /
+			FPaths::GetBaseFilename(FrameFileNames[Index]) + TEXT(".") + FDepthPointCloud::Extension(Format);
+		const int64 NumPoints = PointData.Num() / FDepthPointCloud::PointStride(PointProperties());
+		if (!FDepthPointCloud::WritePoints(FilePath, PointData.GetData(), NumPoints, PointProperties(), Format))
+		{
+			FailedFrames++;
+		}
+	});
+
+	if (FailedFrames > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to sample %d of %d depth frames inside %s"),
+			*FString(__FUNCTION__), FailedFrames.load(), FrameFileNames.Num(), *DepthDir)
+		return false;
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Sampled %d beams from %d depth frames in %.2f s"),
+		*FString(__FUNCTION__), CameraBeamOffsets[CameraIndex + 1] - CameraBeamOffsets[CameraIndex],
+		FrameFileNames.Num(), FPlatformTime::Seconds() - StartTime)
+
+	return true;
+}
+
+void FLidarSimulator::SampleFrame(
+	const int32 CameraIndex,
+	const TArray64<float>& Depth,
+	TArray64<uint8>& OutPointData) const
+{
+	check(Depth.Num() == int64(ImageSize.X) * ImageSize.Y)
+
+	const int32 Stride = FDepthPointCloud::PointStride(PointProperties());
+	const int32 FirstBeam = CameraBeamOffsets[CameraIndex];
+	const int32 EndBeam = CameraBeamOffsets[CameraIndex + 1];
+	const FVector3f& Origin = CameraOrigins[CameraIndex];
+	const float MaxRangeSquared = MaxRange * MaxRange;
+
+	OutPointData.Reset(int64(EndBeam - FirstBeam) * Stride);
+	for (int32 BeamIndex = FirstBeam; BeamIndex < EndBeam; BeamIndex++)
+	{
+		const FBeam& Beam = Beams[BeamIndex];
+		const float BeamDepth = Depth[Beam.PixelIndex];
+		if (BeamDepth >= DepthRange)
+		{
+			continue;
+		}
+
+		// The beam starts at the camera origin, so the azimuth is taken from the returned point instead of the beam
+		const FVector3f Point = Origin + Beam.Ray * BeamDepth;
+		if (Point.SizeSquared() > MaxRangeSquared)
+		{
+			continue;
+		}
+		float Azimuth = FMath::RadiansToDegrees(FMath::Atan2(Point.Y, Point.X));
+		if (Azimuth < 0.0f)
+		{
+			Azimuth += 360.0f;
+		}
+
+		const int64 PointOffset = OutPointData.AddUninitialized(Stride);
+		uint8* PointData = OutPointData.GetData() + PointOffset;
+		FMemory::Memcpy(PointData, &Point, sizeof(FVector3f));
+		FMemory::Memcpy(PointData + sizeof(FVector3f), &Azimuth, sizeof(float));
+		FMemory::Memcpy(PointData + sizeof(FVector3f) + sizeof(float), &Beam.Ring, sizeof(uint16));
+	}
+}
+
+bool FLidarSimulator::MergeSweeps(
+	const TArray<FString>& CameraSweepDirs,
+	const FString& OutputDir,
+	const FDepthPointCloud::EFormat FileFormat)
+{
+	return FDepthPointCloud::MergePointClouds(CameraSweepDirs, OutputDir, FileFormat, PointProperties());
+}
+
+const TArray<FDepthPointCloud::FPointProperty>& FLidarSimulator::PointProperties()
+{
+	using EPropertyType = FDepthPointCloud::EPropertyType;
+	static const TArray<FDepthPointCloud::FPointProperty> Properties = {
+		{ TEXT("x"), EPropertyType::Float },
+		{ TEXT("y"), EPropertyType::Float },
+		{ TEXT("z"), EPropertyType::Float },
+		{ TEXT("azimuth"), EPropertyType::Float },
+		{ TEXT("ring"), EPropertyType::UShort } };
+	return Properties;
+}
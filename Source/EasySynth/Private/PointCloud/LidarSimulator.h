@@ -0,0 +1,112 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "PointCloud/DepthPointCloud.h"
+
+
+/**
+ * Simulates a spinning LiDAR placed at the camera rig origin by resampling depth images of the rig cameras
+ * Each beam is assigned to a camera pixel once on construction, so a sweep only gathers depth values
+ * Beams are cast from the origin of the assigned camera in their rig space direction, so returns of cameras
+ * away from the rig origin are offset by the camera position compared to a sensor placed at the origin
+ * Points are in centimeters inside the rig coordinate system, together with the beam ring
+ * and the azimuth of the returned point as seen from the rig origin
+*/
+class FLidarSimulator
+{
+public:
+	/** Beam pattern of the simulated sensor */
+	struct FBeamPattern
+	{
+		/** Number of vertically stacked beams, called rings */
+		int32 Channels;
+
+		/** Elevation of the highest ring in degrees */
+		float UpperFovDegrees;
+
+		/** Elevation of the lowest ring in degrees */
+		float LowerFovDegrees;
+
+		/** Angle between consecutive beam firings of a ring in degrees */
+		float AzimuthResolutionDegrees;
+
+		/** Range beyond which beams produce no returns */
+		float MaxRangeMeters;
+	};
+
+	/** Rig camera data the beams are resampled from */
+	struct FRigCamera
+	{
+		/** Camera transform relative to the rig origin */
+		FTransform Transform;
+
+		/** Camera intrinsics packed as (fx, fy, cx, cy) */
+		FVector4 Intrinsics;
+	};
+
+	FLidarSimulator(
+		const FBeamPattern& Pattern,
+		const TArray<FRigCamera>& RigCameras,
+		const FIntPoint Resolution,
+		const float DepthRangeMeters,
+		const FDepthPointCloud::EFormat FileFormat);
+
+	/**
+	 * Writes returns of the beams assigned to the camera for each EXR depth frame inside the depth directory,
+	 * partial sweeps of all rig cameras are combined using MergeSweeps
+	*/
+	bool SampleCamera(const int32 CameraIndex, const FString& DepthDir, const FString& OutputDir) const;
+
+	/** Gathers returns of the beams assigned to the camera from a single depth frame */
+	void SampleFrame(const int32 CameraIndex, const TArray64<float>& Depth, TArray64<uint8>& OutPointData) const;
+
+	/** Combines partial sweeps of all rig cameras into a single sweep per frame */
+	static bool MergeSweeps(
+		const TArray<FString>& CameraSweepDirs,
+		const FString& OutputDir,
+		const FDepthPointCloud::EFormat FileFormat);
+
+	/** Properties of written points, tightly packed in this order */
+	static const TArray<FDepthPointCloud::FPointProperty>& PointProperties();
+
+	/** Number of beams that are seen by at least one rig camera */
+	int32 NumCoveredBeams() const { return Beams.Num(); }
+
+private:
+	/** Lookup table entry of a single beam */
+	struct FBeam
+	{
+		/** Beam direction in the rig coordinate system, scaled to a unit depth of the assigned camera */
+		FVector3f Ray;
+
+		/** Index of the depth pixel the beam hits */
+		int32 PixelIndex;
+
+		/** Beam ring, zero for the lowest one */
+		uint16 Ring;
+	};
+
+	/** Beams sorted by the assigned camera */
+	TArray<FBeam> Beams;
+
+	/** Index of the first beam of each camera, followed by the total number of beams */
+	TArray<int32> CameraBeamOffsets;
+
+	/** Camera positions relative to the rig origin */
+	TArray<FVector3f> CameraOrigins;
+
+	/** Depth image size each beam pixel index refers to */
+	FIntPoint ImageSize;
+
+	/** Depth range in centimeters, pixels at the range are considered empty */
+	float DepthRange;
+
+	/** Maximum beam range in centimeters */
+	float MaxRange;
+
+	/** Format of the written files */
+	FDepthPointCloud::EFormat Format;
+};
@@ -0,0 +1,287 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "RendererTargets/BoundingBoxExporter.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+
+#include "EasySynth.h"
+#include "TextureStyles/TextureStyleManager.h"
+
+
+namespace
+{
+	/** Per-frame projection result of a single actor */
+	struct FProjectedBox
+	{
+		float MinU;
+		float MinV;
+		float MaxU;
+		float MaxV;
+		float MinDepth;
+		bool bVisible;
+		bool bTruncated;
+	};
+
+	/** World oriented box of the local box, without the actor scale */
+	FTransform OrientedBoxTransform(const FTransform& ActorTransform, const FBox& LocalBox)
+	{
+		return FTransform(ActorTransform.GetRotation(), ActorTransform.TransformPosition(LocalBox.GetCenter()));
+	}
+
+	/** World space position of the local box corner, with each bit of the corner index selecting the max along an axis */
+	FVector WorldCorner(const FTransform& ActorTransform, const FBox& LocalBox, const int32 Corner)
+	{
+		return ActorTransform.TransformPosition(FVector(
+			(Corner & 1) ? LocalBox.Max.X : LocalBox.Min.X,
+			(Corner & 2) ? LocalBox.Max.Y : LocalBox.Min.Y,
+			(Corner & 4) ? LocalBox.Max.Z : LocalBox.Min.Z));
+	}
+}
+
+void FBoundingBoxExporter::CollectActors(UTextureStyleManager* TextureStyleManager)
+{
+	for (const FLabeledActor& LabeledActor : TextureStyleManager->LabeledActors())
+	{
+		AActor* Actor = LabeledActor.Actor;
+
+		// Oriented box from bounds of all components in the actor space
+		const bool bNonColliding = true;
+		const FBox LocalBox = Actor->CalculateComponentsBoundingBoxInLocalSpace(bNonColliding);
+		if (!LocalBox.IsValid)
+		{
+			continue;
+		}
+		const FTransform& ActorTransform = Actor->GetActorTransform();
+		const FVector Scale = ActorTransform.GetScale3D().GetAbs();
+
+		Actors.Add(Actor);
+		LocalBoxes.Add(LocalBox);
+		ClassIds.Add(LabeledActor.ClassId);
+		InstanceIds.Add(LabeledActor.InstanceId);
+		ActorGuids.Add(Actor->GetActorGuid());
+		BoxTransforms.Add(OrientedBoxTransform(ActorTransform, LocalBox));
+		BoxExtents.Add(FVector3f(LocalBox.GetExtent() * Scale));
+
+		for (int32 Corner = 0; Corner < NumCorners; Corner++)
+		{
+			const FVector Position = WorldCorner(ActorTransform, LocalBox, Corner);
+			CornersX.Add(Position.X);
+			CornersY.Add(Position.Y);
+			CornersZ.Add(Position.Z);
+		}
+	}
+}
+
+bool FBoundingBoxExporter::ExportBoundingBoxes(
+	const TArray<FTransform>& CameraTransforms,
+	const TMap<AActor*, TArray<FTransform>>& ActorTransforms,
+	const FVector4& CameraIntrinsics,
+	const FIntPoint& OutputResolution,
+	const FString& FilePath)
+{
+	TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!FileWriter.IsValid())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not open the file %s"), *FString(__FUNCTION__), *FilePath)
+		return false;
+	}
+	FArchive& Ar = *FileWriter;
+
+	const int32 NumActors = ClassIds.Num();
+	float Fx = CameraIntrinsics.X;
+	float Fy = CameraIntrinsics.Y;
+	float Cx = CameraIntrinsics.Z;
+	float Cy = CameraIntrinsics.W;
+
+	// Header
+	ANSICHAR Magic[4] = { 'E', 'S', 'B', 'B' };
+	Ar.Serialize(Magic, sizeof(Magic));
+	uint32 Version = 1;
+	uint32 ActorCount = NumActors;
+	uint32 FrameCount = CameraTransforms.Num();
+	Ar << Version << ActorCount << FrameCount << Fx << Fy << Cx << Cy;
+
+	// Actor table
+	for (int32 i = 0; i < NumActors; i++)
+	{
+		FVector3f Center(BoxTransforms[i].GetTranslation());
+		FQuat4f Rotation(BoxTransforms[i].GetRotation());
+		Ar << ClassIds[i] << InstanceIds[i] << ActorGuids[i] << Center << BoxExtents[i] << Rotation;
+	}
+
+	// Per frame transforms of animated actors, nullptr for actors that stay in place
+	TArray<const TArray<FTransform>*> FrameActorTransforms;
+	FrameActorTransforms.SetNumZeroed(NumActors);
+	for (int32 i = 0; i < NumActors; i++)
+	{
+		const TArray<FTransform>* Transforms = ActorTransforms.Find(Actors[i]);
+		if (Transforms != nullptr && Transforms->Num() == CameraTransforms.Num())
+		{
+			FrameActorTransforms[i] = Transforms;
+		}
+	}
+
+	TArray<FProjectedBox> ProjectedBoxes;
+	ProjectedBoxes.SetNumUninitialized(NumActors);
+	const float Width = OutputResolution.X;
+	const float Height = OutputResolution.Y;
+
+	for (int32 Frame = 0; Frame < CameraTransforms.Num(); Frame++)
+	{
+		FTransform CameraTransform = CameraTransforms[Frame];
+
+		// Camera scale makes no impact on the projection
+		CameraTransform.SetScale3D(FVector(1.0f, 1.0f, 1.0f));
+
+		// World to camera rotation and translation as plain floats, so that the inner loops stay vectorizable
+		const FMatrix WorldToCamera = CameraTransform.ToMatrixNoScale().Inverse();
+		const float R[3][3] = {
+			{ float(WorldToCamera.M[0][0]), float(WorldToCamera.M[1][0]), float(WorldToCamera.M[2][0]) },
+			{ float(WorldToCamera.M[0][1]), float(WorldToCamera.M[1][1]), float(WorldToCamera.M[2][1]) },
+			{ float(WorldToCamera.M[0][2]), float(WorldToCamera.M[1][2]), float(WorldToCamera.M[2][2]) } };
+		const float T[3] = { float(WorldToCamera.M[3][0]), float(WorldToCamera.M[3][1]), float(WorldToCamera.M[3][2]) };
+
+		// Project all actors in batches, UE cameras look along X with Y pointing right and Z up
+		const int32 BatchSize = 1024;
+		const int32 NumBatches = FMath::DivideAndRoundUp(NumActors, BatchSize);
+		ParallelFor(NumBatches, [&](const int32 Batch)
+		{
+			const int32 First = Batch * BatchSize;
+			const int32 Last = FMath::Min(First + BatchSize, NumActors);
+			for (int32 i = First; i < Last; i++)
+			{
+				float X[NumCorners];
+				float Y[NumCorners];
+				float Z[NumCorners];
+				if (FrameActorTransforms[i] != nullptr)
+				{
+					const FTransform& ActorTransform = (*FrameActorTransforms[i])[Frame];
+					for (int32 c = 0; c < NumCorners; c++)
+					{
+						const FVector Position = WorldCorner(ActorTransform, LocalBoxes[i], c);
+						X[c] = Position.X;
+						Y[c] = Position.Y;
+						Z[c] = Position.Z;
+					}
+				}
+				else
+				{
+					FMemory::Memcpy(X, &CornersX[i * NumCorners], sizeof(X));
+					FMemory::Memcpy(Y, &CornersY[i * NumCorners], sizeof(Y));
+					FMemory::Memcpy(Z, &CornersZ[i * NumCorners], sizeof(Z));
+				}
+
+				float Depth[NumCorners];
+				float Right[NumCorners];
+				float Up[NumCorners];
+				for (int32 c = 0; c < NumCorners; c++)
+				{
+					Depth[c] = R[0][0] * X[c] + R[0][1] * Y[c] + R[0][2] * Z[c] + T[0];
+					Right[c] = R[1][0] * X[c] + R[1][1] * Y[c] + R[1][2] * Z[c] + T[1];
+					Up[c] = R[2][0] * X[c] + R[2][1] * Y[c] + R[2][2] * Z[c] + T[2];
+				}
+
+				// Cull boxes behind the camera
+				FProjectedBox& Box = ProjectedBoxes[i];
+				float MaxDepth = Depth[0];
+				float MinCornerDepth = Depth[0];
+				for (int32 c = 1; c < NumCorners; c++)
+				{
+					MaxDepth = FMath::Max(MaxDepth, Depth[c]);
+					MinCornerDepth = FMath::Min(MinCornerDepth, Depth[c]);
+				}
+				Box.bVisible = MaxDepth > NearPlane;
+				if (!Box.bVisible)
+				{
+					continue;
+				}
+
+				// Only the part of the box in front of the near plane is bounded,
+				// made of the corners in front of it and the points where box edges cross it
+				Box.MinU = MAX_flt;
+				Box.MaxU = -MAX_flt;
+				Box.MinV = MAX_flt;
+				Box.MaxV = -MAX_flt;
+				Box.MinDepth = MAX_flt;
+				auto AddPoint = [&](const float PointDepth, const float PointRight, const float PointUp)
+				{
+					const float PointU = Cx + Fx * PointRight / PointDepth;
+					const float PointV = Cy - Fy * PointUp / PointDepth;
+					Box.MinU = FMath::Min(Box.MinU, PointU);
+					Box.MaxU = FMath::Max(Box.MaxU, PointU);
+					Box.MinV = FMath::Min(Box.MinV, PointV);
+					Box.MaxV = FMath::Max(Box.MaxV, PointV);
+					Box.MinDepth = FMath::Min(Box.MinDepth, PointDepth);
+				};
+				for (int32 c = 0; c < NumCorners; c++)
+				{
+					if (Depth[c] > NearPlane)
+					{
+						AddPoint(Depth[c], Right[c], Up[c]);
+					}
+				}
+				if (MinCornerDepth <= NearPlane)
+				{
+					// Box edges connect corners whose indices differ in a single bit
+					for (int32 Axis = 1; Axis < NumCorners; Axis <<= 1)
+					{
+						for (int32 c = 0; c < NumCorners; c++)
+						{
+							const int32 d = c | Axis;
+							if ((c & Axis) != 0 || (Depth[c] > NearPlane) == (Depth[d] > NearPlane))
+							{
+								continue;
+							}
+							const float Alpha = (NearPlane - Depth[c]) / (Depth[d] - Depth[c]);
+							AddPoint(NearPlane, FMath::Lerp(Right[c], Right[d], Alpha), FMath::Lerp(Up[c], Up[d], Alpha));
+						}
+					}
+				}
+
+				// Cull boxes outside of the image
+				Box.bVisible = Box.MaxU >= 0.0f && Box.MinU < Width && Box.MaxV >= 0.0f && Box.MinV < Height;
+				if (!Box.bVisible)
+				{
+					continue;
+				}
+
+				Box.bTruncated = MinCornerDepth <= NearPlane ||
+					Box.MinU < 0.0f || Box.MaxU > Width || Box.MinV < 0.0f || Box.MaxV > Height;
+				Box.MinU = FMath::Clamp(Box.MinU, 0.0f, Width);
+				Box.MaxU = FMath::Clamp(Box.MaxU, 0.0f, Width);
+				Box.MinV = FMath::Clamp(Box.MinV, 0.0f, Height);
+				Box.MaxV = FMath::Clamp(Box.MaxV, 0.0f, Height);
+			}
+		});
+
+		// Stream the visible boxes of the frame
+		uint32 NumVisible = 0;
+		for (const FProjectedBox& Box : ProjectedBoxes)
+		{
+			NumVisible += Box.bVisible ? 1 : 0;
+		}
+		Ar << NumVisible;
+
+		const FTransform CameraInverse = CameraTransform.Inverse();
+		for (int32 i = 0; i < NumActors; i++)
+		{
+			FProjectedBox& Box = ProjectedBoxes[i];
+			if (!Box.bVisible)
+			{
+				continue;
+			}
+			const FTransform BoxTransform = FrameActorTransforms[i] != nullptr ?
+				OrientedBoxTransform((*FrameActorTransforms[i])[Frame], LocalBoxes[i]) :
+				BoxTransforms[i];
+			const FTransform CameraBox = BoxTransform * CameraInverse;
+			uint32 ActorIndex = i;
+			FVector3f Center(CameraBox.GetTranslation());
+			FQuat4f Rotation(CameraBox.GetRotation());
+			uint8 bTruncated = Box.bTruncated ? 1 : 0;
+			Ar << ActorIndex << Box.MinU << Box.MinV << Box.MaxU << Box.MaxV << Box.MinDepth << Center << Rotation << bTruncated;
+		}
+	}
+
+	return FileWriter->Close();
+}
@@ -5,6 +5,7 @@
 #include "Camera/CameraComponent.h"
 #include "EntitySystem/Interrogation/MovieSceneInterrogationLinker.h"
 #include "EntitySystem/MovieSceneEntitySystemTypes.h"
+#include "GameFramework/Actor.h"
 #include "ILevelSequenceEditorToolkit.h"
 #include "ISequencer.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -23,20 +24,10 @@ bool FCameraPoseExporter::ExportCameraPoses(
 	const FString& OutputDir,
 	UCameraComponent* CameraComponent)
 {
-	// Open the received level sequence inside the sequencer wrapper
-	if (!SequencerWrapper.OpenSequence(LevelSequence))
-	{
-		UE_LOG(LogEasySynth, Error, TEXT("%s: Sequencer wrapper opening failed"), *FString(__FUNCTION__))
-		return false;
-	}
-
 	OutputResolution = OutputImageResolution;
 
-	// Extract the camera pose transforms
-	const bool bAccumulateCameraOffset = (CameraComponent != nullptr);
-	if (!ExtractCameraTransforms(bAccumulateCameraOffset))
+	if (!ExtractCameraPoses(LevelSequence, CameraComponent))
 	{
-		UE_LOG(LogEasySynth, Error, TEXT("%s: Camera pose extraction failed"), *FString(__FUNCTION__))
 		return false;
 	}
 
@@ -59,6 +50,33 @@ bool FCameraPoseExporter::ExportCameraPoses(
 	return true;
 }
 
+bool FCameraPoseExporter::ExtractCameraPoses(ULevelSequence* LevelSequence, UCameraComponent* CameraComponent)
+{
+	// Open the received level sequence inside the sequencer wrapper
+	if (!SequencerWrapper.OpenSequence(LevelSequence))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Sequencer wrapper opening failed"), *FString(__FUNCTION__))
+		return false;
+	}
+
+	// Extract the camera pose transforms
+	const bool bAccumulateCameraOffset = (CameraComponent != nullptr);
+	if (!ExtractCameraTransforms(bAccumulateCameraOffset))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Camera pose extraction failed"), *FString(__FUNCTION__))
+		return false;
+	}
+
+	// Extract the actor transforms for the same frames
+	if (bExtractActorTransforms && !ExtractActorTransforms())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Actor transform extraction failed"), *FString(__FUNCTION__))
+		return false;
+	}
+
+	return true;
+}
+
 bool FCameraPoseExporter::ExtractCameraTransforms(const bool bAccumulateCameraOffset)
 {
 	// Get level sequence fps
@@ -114,34 +132,15 @@ bool FCameraPoseExporter::ExtractCameraTransforms(const bool bAccumulateCameraOf
 			return false;
 		}
 
-		// Interrogator object that queries the transformation track for camera poses
-		UE::MovieScene::FSystemInterrogator Interrogator;
-
 		// Inclusive lower bound of the movie scene ticks that belong to this cut section
 		FFrameNumber StartTickNumber = CutSection->GetTrueRange().GetLowerBoundValue();
 		// Exclusive upper bound of the movie scene ticks that belong to this cut section
 		FFrameNumber EndTickNumber = CutSection->GetTrueRange().GetUpperBoundValue();
 		for (FFrameNumber TickNumber = StartTickNumber; TickNumber < EndTickNumber; TickNumber += TicksPerFrame)
 		{
-			// Reinitialize the interrogator for each frame
-			Interrogator.Reset();
-			TGuardValue<UE::MovieScene::FEntityManager*> DebugVizGuard(
-				UE::MovieScene::GEntityManagerForDebuggingVisualizers, &Interrogator.GetLinker()->EntityManager);
-			Interrogator.ImportTrack(CameraTransformTrack, UE::MovieScene::FInterrogationChannel::Default());
-
-			// Add frame interrogation
-			if (Interrogator.AddInterrogation(TickNumber) == INDEX_NONE)
-			{
-				UE_LOG(LogEasySynth, Error, TEXT("%s: Adding interrogation failed"), *FString(__FUNCTION__))
-				return false;
-			}
-			Interrogator.Update();
-
 			// Get the camera pose transform for the frame
-			// Engine crashes in case multiple interrogations are added at once
 			TArray<FTransform> TempTransforms;
-			Interrogator.QueryWorldSpaceTransforms(UE::MovieScene::FInterrogationChannel::Default(), TempTransforms);
-			if (TempTransforms.Num() == 0)
+			if (!InterrogateTransforms(CameraTransformTrack, TickNumber, TempTransforms))
 			{
 				UE_LOG(LogEasySynth, Error, TEXT("%s: No camera transforms found"), *FString(__FUNCTION__))
 				return false;
@@ -151,11 +150,13 @@ bool FCameraPoseExporter::ExtractCameraTransforms(const bool bAccumulateCameraOf
 			{
 				if (bAccumulateCameraOffset)
 				{
-					Transform.Accumulate(Camera->GetRelativeTransform());
+					// The camera offset is relative to the rig, so it has to be rotated by the rig orientation
+					Transform = Camera->GetRelativeTransform() * Transform;
 				}
 
 				AccumulatedFrameTime += FrameTime;
 				Timestamps.Add(AccumulatedFrameTime);
+				FrameTicks.Add(TickNumber);
 			}
 
 			CameraTransforms.Append(TempTransforms);
@@ -165,6 +166,78 @@ bool FCameraPoseExporter::ExtractCameraTransforms(const bool bAccumulateCameraOf
 	return true;
 }
 
+bool FCameraPoseExporter::ExtractActorTransforms()
+{
+	ISequencer* Sequencer = SequencerWrapper.GetSequencer();
+	for (const FMovieSceneBinding& Binding : SequencerWrapper.GetMovieScene()->GetBindings())
+	{
+		UMovieScene3DTransformTrack* TransformTrack = nullptr;
+		for (UMovieSceneTrack* Track : Binding.GetTracks())
+		{
+			TransformTrack = Cast<UMovieScene3DTransformTrack>(Track);
+			if (TransformTrack != nullptr)
+			{
+				break;
+			}
+		}
+		if (TransformTrack == nullptr)
+		{
+			continue;
+		}
+
+		// Only actor bindings move whole actors, component bindings are left out
+		for (const TWeakObjectPtr<>& BoundObject :
+			Sequencer->FindBoundObjects(Binding.GetObjectGuid(), Sequencer->GetFocusedTemplateID()))
+		{
+			AActor* Actor = Cast<AActor>(BoundObject.Get());
+			if (Actor == nullptr || ActorTransforms.Contains(Actor))
+			{
+				continue;
+			}
+
+			TArray<FTransform>& Transforms = ActorTransforms.Add(Actor);
+			Transforms.Reserve(FrameTicks.Num());
+			for (const FFrameNumber& TickNumber : FrameTicks)
+			{
+				TArray<FTransform> TempTransforms;
+				if (!InterrogateTransforms(TransformTrack, TickNumber, TempTransforms))
+				{
+					UE_LOG(LogEasySynth, Error, TEXT("%s: No transforms found for the actor %s"),
+						*FString(__FUNCTION__), *Actor->GetActorLabel())
+					return false;
+				}
+				Transforms.Add(TempTransforms[0]);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FCameraPoseExporter::InterrogateTransforms(
+	UMovieScene3DTransformTrack* TransformTrack,
+	const FFrameNumber TickNumber,
+	TArray<FTransform>& OutTransforms)
+{
+	// Interrogator object that queries the transformation track,
+	// it is reinitialized for each frame as the engine crashes in case multiple interrogations are added at once
+	UE::MovieScene::FSystemInterrogator Interrogator;
+	TGuardValue<UE::MovieScene::FEntityManager*> DebugVizGuard(
+		UE::MovieScene::GEntityManagerForDebuggingVisualizers, &Interrogator.GetLinker()->EntityManager);
+	Interrogator.ImportTrack(TransformTrack, UE::MovieScene::FInterrogationChannel::Default());
+
+	// Add frame interrogation
+	if (Interrogator.AddInterrogation(TickNumber) == INDEX_NONE)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Adding interrogation failed"), *FString(__FUNCTION__))
+		return false;
+	}
+	Interrogator.Update();
+
+	Interrogator.QueryWorldSpaceTransforms(UE::MovieScene::FInterrogationChannel::Default(), OutTransforms);
+	return OutTransforms.Num() > 0;
+}
+
 bool FCameraPoseExporter::SavePosesToCSV(const FString& FilePath)
 {
 	// Create the file content
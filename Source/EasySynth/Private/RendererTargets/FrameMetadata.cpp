@@ -0,0 +1,150 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "RendererTargets/FrameMetadata.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+#include "CameraRig/CameraRigRosInterface.h"
+#include "EasySynth.h"
+
+
+TArray<TPair<FString, FString>> FFrameMetadata::FrameValues(
+	const FTransform& CameraPose,
+	const double Timestamp,
+	const FVector4& CameraIntrinsics)
+{
+	const FVector Translation = CameraPose.GetTranslation();
+	const FQuat Rotation = CameraPose.GetRotation();
+
+	TArray<TPair<FString, FString>> Values;
+	Values.Emplace(TEXT("tx"), FString::Printf(TEXT("%f"), Translation.X));
+	Values.Emplace(TEXT("ty"), FString::Printf(TEXT("%f"), Translation.Y));
+	Values.Emplace(TEXT("tz"), FString::Printf(TEXT("%f"), Translation.Z));
+	Values.Emplace(TEXT("qx"), FString::Printf(TEXT("%f"), Rotation.X));
+	Values.Emplace(TEXT("qy"), FString::Printf(TEXT("%f"), Rotation.Y));
+	Values.Emplace(TEXT("qz"), FString::Printf(TEXT("%f"), Rotation.Z));
+	Values.Emplace(TEXT("qw"), FString::Printf(TEXT("%f"), Rotation.W));
+	Values.Emplace(TEXT("t"), FString::Printf(TEXT("%f"), Timestamp));
+	Values.Emplace(TEXT("fx"), FString::Printf(TEXT("%f"), CameraIntrinsics.X));
+	Values.Emplace(TEXT("fy"), FString::Printf(TEXT("%f"), CameraIntrinsics.Y));
+	Values.Emplace(TEXT("cx"), FString::Printf(TEXT("%f"), CameraIntrinsics.Z));
+	Values.Emplace(TEXT("cy"), FString::Printf(TEXT("%f"), CameraIntrinsics.W));
+	return Values;
+}
+
+TArray<TPair<FString, FString>> FFrameMetadata::FrameValuesFromAttributes(
+	const TMap<FString, FStringFormatArg>& Attributes)
+{
+	static const TCHAR* Keys[] = {
+		TEXT("tx"), TEXT("ty"), TEXT("tz"), TEXT("qx"), TEXT("qy"), TEXT("qz"), TEXT("qw"), TEXT("t"),
+		TEXT("fx"), TEXT("fy"), TEXT("cx"), TEXT("cy") };
+
+	TArray<TPair<FString, FString>> Values;
+	for (const TCHAR* Key : Keys)
+	{
+		const FStringFormatArg* Attribute = Attributes.Find(Key);
+		if (Attribute != nullptr && Attribute->Type == FStringFormatArg::String)
+		{
+			Values.Emplace(Key, Attribute->StringValue);
+		}
+	}
+	return Values;
+}
+
+FVector4 FFrameMetadata::CameraIntrinsics(UCameraComponent* Camera, const FIntPoint& SensorSize)
+{
+	const FCameraRigData::FCameraData CameraData = FCameraRigRosInterface::GetCameraData(Camera, SensorSize);
+	return FVector4(
+		CameraData.FocalLength,
+		CameraData.FocalLength,
+		CameraData.PrincipalPointX,
+		CameraData.PrincipalPointY);
+}
+
+bool FFrameMetadata::AddToPngFiles(
+	const FString& ImageDir,
+	const TArray<FTransform>& CameraPoses,
+	const TArray<double>& Timestamps,
+	const FVector4& CameraIntrinsics)
+{
+	TArray<FString> FileNames;
+	IFileManager::Get().FindFiles(FileNames, *ImageDir, TEXT("png"));
+	FileNames.Sort();
+
+	// A missing image would shift the frames of all following ones
+	if (FileNames.Num() != CameraPoses.Num() || FileNames.Num() != Timestamps.Num())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Found %d images inside %s, but got %d camera poses and %d timestamps"),
+			*FString(__FUNCTION__), FileNames.Num(), *ImageDir, CameraPoses.Num(), Timestamps.Num())
+		return false;
+	}
+
+	// Each image is rewritten on its own worker
+	std::atomic<int32> FailedImages(0);
+	ParallelFor(FileNames.Num(), [&](const int32 Index)
+	{
+		const FString FilePath = ImageDir / FileNames[Index];
+		TArray64<uint8> FileData;
+		if (!FFileHelper::LoadFileToArray(FileData, *FilePath) ||
+			!InsertPngTextChunks(FileData, FrameValues(CameraPoses[Index], Timestamps[Index], CameraIntrinsics)) ||
+			!FFileHelper::SaveArrayToFile(FileData, *FilePath))
+		{
+			FailedImages++;
+		}
+	});
+
+	if (FailedImages > 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to add metadata to %d of %d images inside %s"),
+			*FString(__FUNCTION__), FailedImages.load(), FileNames.Num(), *ImageDir)
+		return false;
+	}
+
+	return true;
+}
+
+bool FFrameMetadata::InsertPngTextChunks(TArray64<uint8>& FileData, const TArray<TPair<FString, FString>>& Values)
+{
+	// The signature is followed by the header chunk, which must stay the first one
+	static const uint8 PngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	const int32 HeaderChunkEnd = sizeof(PngSignature) + 4 + 4 + 13 + 4;
+	if (FileData.Num() < HeaderChunkEnd || FMemory::Memcmp(FileData.GetData(), PngSignature, sizeof(PngSignature)) != 0)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Not a valid PNG file"), *FString(__FUNCTION__))
+		return false;
+	}
+
+	auto AppendUint32 = [](TArray<uint8>& Data, const uint32 Value)
+	{
+		Data.Add((Value >> 24) & 0xFF);
+		Data.Add((Value >> 16) & 0xFF);
+		Data.Add((Value >> 8) & 0xFF);
+		Data.Add(Value & 0xFF);
+	};
+
+	// Chunks are formatted as length, type, data and CRC of the type and data, with Latin-1 keyword and text separated by a null
+	TArray<uint8> Chunks;
+	for (const TPair<FString, FString>& Value : Values)
+	{
+		const FTCHARToUTF8 Keyword(*Value.Key);
+		const FTCHARToUTF8 Text(*Value.Value);
+		const uint32 DataLength = Keyword.Length() + 1 + Text.Length();
+
+		AppendUint32(Chunks, DataLength);
+		const int32 TypeStart = Chunks.Num();
+		Chunks.Append(reinterpret_cast<const uint8*>("tEXt"), 4);
+		Chunks.Append(reinterpret_cast<const uint8*>(Keyword.Get()), Keyword.Length());
+		Chunks.Add(0);
+		Chunks.Append(reinterpret_cast<const uint8*>(Text.Get()), Text.Length());
+		AppendUint32(Chunks, crc32(0, Chunks.GetData() + TypeStart, 4 + DataLength));
+	}
+
+	FileData.Insert(Chunks, HeaderChunkEnd);
+	return true;
+}
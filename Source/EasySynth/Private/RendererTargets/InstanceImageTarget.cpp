@@ -0,0 +1,55 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "RendererTargets/InstanceImageTarget.h"
+
+#include "Camera/CameraComponent.h"
+
+#include "LevelSequence.h"
+#include "SemanticOutput/MoviePipelineInstanceIdOutput.h"
+#include "TextureStyles/TextureStyleManager.h"
+
+
+bool FInstanceImageTarget::PrepareSequence(ULevelSequence* LevelSequence)
+{
+	// Update texture style inside the level
+	TextureStyleManager->CheckoutTextureStyle(ETextureStyle::INSTANCE);
+
+	// Get all camera components bound to the level sequence
+	TArray<UCameraComponent*> Cameras = GetCameras(LevelSequence);
+	if (Cameras.Num() == 0)
+	{
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: No cameras bound to the level sequence found"), *FString(__FUNCTION__))
+		return false;
+	}
+
+	// Prepare the camera post process material
+	UMaterial* PostProcessMaterial = LoadPostProcessMaterial();
+	if (PostProcessMaterial == nullptr)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not load instance post process material"), *FString(__FUNCTION__))
+		return false;
+	}
+
+	for (UCameraComponent* Camera : Cameras)
+	{
+		if (Camera == nullptr)
+		{
+			UE_LOG(LogEasySynth, Error, TEXT("%s: Found camera is null"), *FString(__FUNCTION__))
+			return false;
+		}
+		Camera->PostProcessSettings.WeightedBlendables.Array.Empty();
+		Camera->PostProcessSettings.WeightedBlendables.Array.Add(FWeightedBlendable(1.0f, PostProcessMaterial));
+	}
+
+	return true;
+}
+
+UClass* FInstanceImageTarget::CustomOutputSettingClass() const
+{
+	return UMoviePipelineImageSequenceOutput_InstanceIds::StaticClass();
+}
+
+bool FInstanceImageTarget::FinalizeSequence(ULevelSequence* LevelSequence)
+{
+	return ClearCameraPostProcess(LevelSequence);
+}
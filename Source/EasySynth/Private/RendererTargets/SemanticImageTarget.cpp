@@ -5,6 +5,7 @@
 #include "Camera/CameraComponent.h"
 
 #include "LevelSequence.h"
+#include "SemanticOutput/MoviePipelineSemanticIdOutput.h"
 #include "TextureStyles/TextureStyleManager.h"
 
 
@@ -43,6 +44,11 @@ bool FSemanticImageTarget::PrepareSequence(ULevelSequence* LevelSequence)
 	return true;
 }
 
+UClass* FSemanticImageTarget::CustomOutputSettingClass() const
+{
+	return bUseClassOutput ? UMoviePipelineImageSequenceOutput_SemanticIds::StaticClass() : nullptr;
+}
+
 bool FSemanticImageTarget::FinalizeSequence(ULevelSequence* LevelSequence)
 {
 	return ClearCameraPostProcess(LevelSequence);
@@ -0,0 +1,158 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "SemanticOutput/MaskAnnotations.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
+
+#include "EasySynth.h"
+
+
+namespace
+{
+	/** Mask and box of a single id, accumulated while scanning the frame */
+	struct FIdMask
+	{
+		/** Alternating run lengths of pixels outside and inside the mask, starting with outside pixels */
+		TArray<uint32> Counts;
+
+		/** Column-major index after the last mask pixel */
+		int64 End = 0;
+
+		/** Number of mask pixels */
+		int64 Area = 0;
+
+		int32 MinX = MAX_int32;
+		int32 MinY = MAX_int32;
+		int32 MaxX = -1;
+		int32 MaxY = -1;
+	};
+}
+
+template <typename IdType>
+FString FMaskAnnotations::FrameAnnotationsLine(const FString& FileName, const IdType* Ids, const FIntPoint Size)
+{
+	// COCO masks are encoded in column-major order, so a single column-major pass produces runs of all ids,
+	// with map lookups only needed once per run instead of once per pixel
+	TMap<IdType, FIdMask> Masks;
+	const int64 NumPixels = static_cast<int64>(Size.X) * Size.Y;
+	for (int32 X = 0; X < Size.X; X++)
+	{
+		int32 Y = 0;
+		while (Y < Size.Y)
+		{
+			const IdType Id = Ids[static_cast<int64>(Y) * Size.X + X];
+			const int32 RunStartY = Y;
+			while (Y < Size.Y && Ids[static_cast<int64>(Y) * Size.X + X] == Id)
+			{
+				Y++;
+			}
+			if (Id == 0)
+			{
+				continue;
+			}
+
+			const int64 RunStart = static_cast<int64>(X) * Size.Y + RunStartY;
+			const int64 RunLength = Y - RunStartY;
+			FIdMask& Mask = Masks.FindOrAdd(Id);
+			if (Mask.Counts.Num() > 0 && Mask.End == RunStart)
+			{
+				// The run continues the previous one from the end of the previous column
+				Mask.Counts.Last() += RunLength;
+			}
+			else
+			{
+				Mask.Counts.Add(RunStart - Mask.End);
+				Mask.Counts.Add(RunLength);
+			}
+			Mask.End = RunStart + RunLength;
+			Mask.Area += RunLength;
+			Mask.MinX = FMath::Min(Mask.MinX, X);
+			Mask.MaxX = FMath::Max(Mask.MaxX, X);
+			Mask.MinY = FMath::Min(Mask.MinY, RunStartY);
+			Mask.MaxY = FMath::Max(Mask.MaxY, Y - 1);
+		}
+	}
+
+	Masks.KeySort([](const IdType A, const IdType B) { return A < B; });
+
+	FString Line = FString::Printf(TEXT("{\"file\":\"%s\",\"width\":%d,\"height\":%d,\"annotations\":["),
+		*FileName, Size.X, Size.Y);
+	bool bFirst = true;
+	for (TPair<IdType, FIdMask>& Element : Masks)
+	{
+		FIdMask& Mask = Element.Value;
+		if (Mask.End < NumPixels)
+		{
+			Mask.Counts.Add(NumPixels - Mask.End);
+		}
+
+		Line += FString::Printf(TEXT("%s{\"id\":%u,\"bbox\":[%d,%d,%d,%d],\"area\":%lld,\"segmentation\":{\"size\":[%d,%d],\"counts\":\""),
+			bFirst ? TEXT("") : TEXT(","),
+			static_cast<uint32>(Element.Key),
+			Mask.MinX, Mask.MinY, Mask.MaxX - Mask.MinX + 1, Mask.MaxY - Mask.MinY + 1,
+			Mask.Area,
+			Size.Y, Size.X);
+		AppendCompressedCounts(Mask.Counts, Line);
+		Line += TEXT("\"}}");
+		bFirst = false;
+	}
+	Line += TEXT("]}");
+
+	return Line;
+}
+
+template FString FMaskAnnotations::FrameAnnotationsLine<uint16>(const FString&, const uint16*, const FIntPoint);
+template FString FMaskAnnotations::FrameAnnotationsLine<uint32>(const FString&, const uint32*, const FIntPoint);
+
+void FMaskAnnotations::AppendCompressedCounts(const TArray<uint32>& Counts, FString& OutString)
+{
+	// Each count is stored as a difference to the count two places before it, using 5 bits per character
+	for (int32 i = 0; i < Counts.Num(); i++)
+	{
+		int64 Value = Counts[i];
+		if (i > 2)
+		{
+			Value -= Counts[i - 2];
+		}
+		bool bMore = true;
+		while (bMore)
+		{
+			int64 Char = Value & 0x1f;
+			Value >>= 5;
+			bMore = (Char & 0x10) ? Value != -1 : Value != 0;
+			if (bMore)
+			{
+				Char |= 0x20;
+			}
+			OutString.AppendChar(static_cast<TCHAR>(Char + 48));
+		}
+	}
+}
+
+FAnnotationFileWriter::FAnnotationFileWriter(const FString& FilePath) :
+	FileWriter(IFileManager::Get().CreateFileWriter(*FilePath))
+{
+	if (!FileWriter.IsValid())
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Could not open the file %s"), *FString(__FUNCTION__), *FilePath)
+	}
+}
+
+FAnnotationFileWriter::~FAnnotationFileWriter()
+{
+	if (FileWriter.IsValid())
+	{
+		FileWriter->Close();
+	}
+}
+
+void FAnnotationFileWriter::AppendLine(const FString& Line)
+{
+	const FTCHARToUTF8 Utf8Line(*(Line + TEXT("\n")));
+	FScopeLock ScopeLock(&CriticalSection);
+	if (FileWriter.IsValid())
+	{
+		FileWriter->Serialize(const_cast<ANSICHAR*>(Utf8Line.Get()), Utf8Line.Length());
+	}
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Extracts per-id bounding boxes and COCO run-length encoded masks from id images,
+ * where each semantic class or instance id represents a single annotation
+*/
+class FMaskAnnotations
+{
+public:
+	/**
+	 * Returns a single JSON line with annotations of all non-zero ids found in the frame
+	 * Boxes are written as [x, y, width, height] and masks use the compressed COCO RLE string format
+	*/
+	template <typename IdType>
+	static FString FrameAnnotationsLine(const FString& FileName, const IdType* Ids, const FIntPoint Size);
+
+private:
+	/** Appends run lengths encoded the same way as the COCO API rleToString */
+	static void AppendCompressedCounts(const TArray<uint32>& Counts, FString& OutString);
+};
+
+
+/**
+ * Thread safe writer that appends annotation lines to a single file as frames get written
+*/
+class FAnnotationFileWriter
+{
+public:
+	/** Opens the file, overwriting any existing one */
+	explicit FAnnotationFileWriter(const FString& FilePath);
+
+	/** Closes the file */
+	~FAnnotationFileWriter();
+
+	/** Appends the line followed by a line break */
+	void AppendLine(const FString& Line);
+
+private:
+	/** Guards the file against concurrent write tasks */
+	FCriticalSection CriticalSection;
+
+	/** The opened file */
+	TUniquePtr<FArchive> FileWriter;
+};
@@ -0,0 +1,172 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "SemanticOutput/MoviePipelineInstanceIdOutput.h"
+
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "ImageWriteQueue.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "MoviePipeline.h"
+#include "MoviePipelineImageQuantization.h"
+#include "MoviePipelineOutputSetting.h"
+#include "MoviePipelinePrimaryConfig.h"
+
+#include "EXROutput/ImageOutputUtils.h"
+#include "EXROutput/MoviePipelineEXROutputLocal.h"
+#include "EasySynth.h"
+#include "PathUtils.h"
+
+
+bool FInstanceIdImageWriteTask::RunTask()
+{
+	// Instance id colors are defined in the same 8-bit space as semantic class colors
+	TUniquePtr<FImagePixelData> QuantizedPixelData;
+	const FImagePixelData* ColorPixelData = PixelData.Get();
+	if (PixelData->GetType() != EImagePixelType::Color)
+	{
+		QuantizedPixelData = UE::MoviePipeline::QuantizeImagePixelDataToBitDepth(PixelData.Get(), 8);
+		ColorPixelData = QuantizedPixelData.Get();
+	}
+
+	const void* RawDataPtr;
+	int64 RawDataSize;
+	if (!ColorPixelData->GetRawData(RawDataPtr, RawDataSize))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to retrieve raw data for %s"), *FString(__FUNCTION__), *Filename)
+		return false;
+	}
+	const FColor* Pixels = static_cast<const FColor*>(RawDataPtr);
+	const int64 NumPixels = RawDataSize / sizeof(FColor);
+
+	// Ids are split into 8-bit color channels, with the most significant byte in the red channel
+	TArray64<uint32> Ids;
+	Ids.SetNumUninitialized(NumPixels);
+	for (int64 i = 0; i < NumPixels; i++)
+	{
+		Ids[i] = (static_cast<uint32>(Pixels[i].R) << 16) | (static_cast<uint32>(Pixels[i].G) << 8) | Pixels[i].B;
+	}
+
+	const FIntPoint Size = ColorPixelData->GetSize();
+	if (Annotations.IsValid())
+	{
+		Annotations->AppendLine(FMaskAnnotations::FrameAnnotationsLine(FPaths::GetCleanFilename(Filename), Ids.GetData(), Size));
+	}
+
+	return bWrite32BitIds ? Write32BitIds(Ids, Size) : Write16BitIds(Ids, Size);
+}
+
+bool FInstanceIdImageWriteTask::Write16BitIds(const TArray64<uint32>& Ids, const FIntPoint Size)
+{
+	TArray64<uint16> OutputData;
+	OutputData.SetNumUninitialized(Ids.Num());
+	for (int64 i = 0; i < Ids.Num(); i++)
+	{
+		OutputData[i] = static_cast<uint16>(Ids[i]);
+	}
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>("ImageWrapper");
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() ||
+		!ImageWrapper->SetRaw(OutputData.GetData(), OutputData.Num() * sizeof(uint16), Size.X, Size.Y, ERGBFormat::Gray, 16))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to encode %s"), *FString(__FUNCTION__), *Filename)
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(), *Filename))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *Filename)
+		return false;
+	}
+
+	return true;
+}
+
+bool FInstanceIdImageWriteTask::Write32BitIds(TArray64<uint32>& Ids, const FIntPoint Size)
+{
+#if WITH_UNREALEXR
+	Imf::Header Header(Size.X, Size.Y);
+	Header.compression() = Imf::ZIP_COMPRESSION;
+	Header.channels().insert("id", Imf::Channel(Imf::UINT));
+
+	Imf::FrameBuffer FrameBuffer;
+	FrameBuffer.insert("id", Imf::Slice(
+		Imf::UINT,
+		reinterpret_cast<char*>(Ids.GetData()),
+		sizeof(uint32),
+		sizeof(uint32) * Size.X));
+
+	bool bSuccess = true;
+#if WITH_EDITOR
+	try
+#endif
+	{
+		Imf::OutputFile ImfFile(TCHAR_TO_UTF8(*Filename), Header);
+		ImfFile.setFrameBuffer(FrameBuffer);
+		ImfFile.writePixels(Size.Y);
+	}
+#if WITH_EDITOR
+	catch (const IEX_NAMESPACE::BaseExc& Exception)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s: %s"),
+			*FString(__FUNCTION__), *Filename, UTF8_TO_TCHAR(Exception.what()))
+		bSuccess = false;
+	}
+#endif
+	return bSuccess;
+#else
+	UE_LOG(LogEasySynth, Error, TEXT("%s: EXR support is required for writing 32-bit instance ids"), *FString(__FUNCTION__))
+	return false;
+#endif // WITH_UNREALEXR
+}
+
+void UMoviePipelineImageSequenceOutput_InstanceIds::OnReceiveImageDataImpl(FMoviePipelineMergerOutputFrame* InMergedOutputFrame)
+{
+	check(InMergedOutputFrame);
+
+	// Image wrappers are created on the write threads, so make sure the module is loaded from the main thread
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+
+	// When no other output consumes the merged frame, pixel data is moved into the write task instead of being copied
+	const bool bTakeOwnership = FImageOutputUtils::IsSoleImageOutput(this);
+	const bool bWrite32BitIds = MaxInstanceId > MAX_uint16;
+
+	if (bWriteAnnotations && !Annotations.IsValid())
+	{
+		UMoviePipelineOutputSetting* OutputSettings = GetPipeline()->GetPipelinePrimaryConfig()->FindSetting<UMoviePipelineOutputSetting>();
+		Annotations = MakeShared<FAnnotationFileWriter>(FPathUtils::MaskAnnotationsFilePath(OutputSettings->OutputDirectory.Path));
+	}
+
+	// The instance target renders a single pass
+	for (TPair<FMoviePipelinePassIdentifier, TUniquePtr<FImagePixelData>>& RenderPassData : InMergedOutputFrame->ImageOutputData)
+	{
+		const FString FinalFilePath = FImageOutputUtils::ResolveFrameFilePath(
+			this, InMergedOutputFrame->FrameOutputState, bWrite32BitIds ? TEXT("exr") : TEXT("png"));
+
+		const int32 ShotIndex = RenderPassData.Value->GetPayload<FImagePixelDataPayload>()->SampleState.OutputState.ShotIndex;
+
+		TUniquePtr<FInstanceIdImageWriteTask> InstanceIdImageTask = MakeUnique<FInstanceIdImageWriteTask>();
+		InstanceIdImageTask->Filename = FinalFilePath;
+		InstanceIdImageTask->PixelData = bTakeOwnership ?
+			MoveTemp(RenderPassData.Value) :
+			RenderPassData.Value->CopyImageData();
+		InstanceIdImageTask->bWrite32BitIds = bWrite32BitIds;
+		InstanceIdImageTask->Annotations = Annotations;
+
+		MoviePipeline::FMoviePipelineOutputFutureData OutputData;
+		OutputData.Shot = GetPipeline()->GetActiveShotList()[ShotIndex];
+		OutputData.PassIdentifier = RenderPassData.Key;
+		OutputData.FilePath = FinalFilePath;
+		GetPipeline()->AddOutputFuture(ImageWriteQueue->Enqueue(MoveTemp(InstanceIdImageTask)), OutputData);
+	}
+}
+
+void UMoviePipelineImageSequenceOutput_InstanceIds::FinalizeImpl()
+{
+	Super::FinalizeImpl();
+
+	// All write tasks are finished by now, so releasing the writer closes the complete file
+	Annotations.Reset();
+}
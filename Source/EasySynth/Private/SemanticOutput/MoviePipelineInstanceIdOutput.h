@@ -0,0 +1,88 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImagePixelData.h"
+#include "ImageWriteTask.h"
+#include "MoviePipelineImageSequenceOutput.h"
+
+#include "SemanticOutput/MaskAnnotations.h"
+
+#include "MoviePipelineInstanceIdOutput.generated.h"
+
+
+/**
+ * Image write task that decodes instance ids from instance image colors,
+ * and writes them as single channel 16-bit PNG or 32-bit EXR images
+*/
+class FInstanceIdImageWriteTask : public IImageWriteTaskBase
+{
+public:
+	/** The filename to write to */
+	FString Filename;
+
+	/** Instance image data in any of the pixel formats produced by the pipeline */
+	TUniquePtr<FImagePixelData> PixelData;
+
+	/** Whether ids need 32 bits, in which case an EXR file with a single unsigned integer channel is written */
+	bool bWrite32BitIds;
+
+	/** Receives per-instance boxes and masks of the frame, annotations are not computed if null */
+	TSharedPtr<FAnnotationFileWriter> Annotations;
+
+	FInstanceIdImageWriteTask() : bWrite32BitIds(false) {}
+
+	virtual bool RunTask() override final;
+	virtual void OnAbandoned() override final {}
+
+private:
+	/** Writes ids as a 16-bit grayscale PNG file */
+	bool Write16BitIds(const TArray64<uint32>& Ids, const FIntPoint Size);
+
+	/** Writes ids as an EXR file with a single 32-bit unsigned integer channel */
+	bool Write32BitIds(TArray64<uint32>& Ids, const FIntPoint Size);
+};
+
+
+/**
+ * Movie pipeline output that writes instance images as instance id maps,
+ * where ids match the rows of the exported InstanceIds file
+*/
+UCLASS()
+class UMoviePipelineImageSequenceOutput_InstanceIds : public UMoviePipelineImageSequenceOutputBase
+{
+	GENERATED_BODY()
+public:
+#if WITH_EDITOR
+	virtual FText GetDisplayText() const override { return NSLOCTEXT("EasySynth", "InstanceIdsSettingDisplayName", ".png/.exr Instance Ids [16/32bit]"); }
+#endif
+public:
+	UMoviePipelineImageSequenceOutput_InstanceIds()
+	{
+		OutputFormat = EImageFormat::PNG;
+		MaxInstanceId = 0;
+		bWriteAnnotations = false;
+	}
+
+	virtual void OnReceiveImageDataImpl(FMoviePipelineMergerOutputFrame* InMergedOutputFrame) override;
+
+	virtual void FinalizeImpl() override;
+
+public:
+	/**
+	* The largest assigned instance id, images are written as 32-bit EXR files if it does not fit into 16 bits
+	*/
+	UPROPERTY()
+	int32 MaxInstanceId;
+
+	/**
+	* Should per-instance bounding boxes and RLE masks of each frame be written into the annotations file?
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Instance")
+	bool bWriteAnnotations;
+
+private:
+	/** Annotations file shared by write tasks of all frames */
+	TSharedPtr<FAnnotationFileWriter> Annotations;
+};
@@ -0,0 +1,199 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "SemanticOutput/MoviePipelineSemanticIdOutput.h"
+
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "ImageWriteQueue.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Modules/ModuleManager.h"
+#include "MoviePipeline.h"
+#include "MoviePipelineImageQuantization.h"
+#include "MoviePipelineOutputSetting.h"
+#include "MoviePipelinePrimaryConfig.h"
+
+#include "EXROutput/ImageOutputUtils.h"
+#include "EasySynth.h"
+#include "PathUtils.h"
+
+
+void FSemanticFrameStats::AddFrame(const FString& Filename, const int64 UnmatchedPixels)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Frames.Emplace(Filename, UnmatchedPixels);
+}
+
+TArray<TPair<FString, int64>> FSemanticFrameStats::SortedFrames()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	TArray<TPair<FString, int64>> SortedFrames = Frames;
+	SortedFrames.Sort([](const TPair<FString, int64>& A, const TPair<FString, int64>& B) { return A.Key < B.Key; });
+	return SortedFrames;
+}
+
+bool FSemanticIdImageWriteTask::RunTask()
+{
+	// Class colors are defined in the same 8-bit space as the one used by PNG and JPEG outputs
+	TUniquePtr<FImagePixelData> QuantizedPixelData;
+	const FImagePixelData* ColorPixelData = PixelData.Get();
+	if (PixelData->GetType() != EImagePixelType::Color)
+	{
+		QuantizedPixelData = UE::MoviePipeline::QuantizeImagePixelDataToBitDepth(PixelData.Get(), 8);
+		ColorPixelData = QuantizedPixelData.Get();
+	}
+
+	const void* RawDataPtr;
+	int64 RawDataSize;
+	if (!ColorPixelData->GetRawData(RawDataPtr, RawDataSize))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to retrieve raw data for %s"), *FString(__FUNCTION__), *Filename)
+		return false;
+	}
+	const FColor* Pixels = static_cast<const FColor*>(RawDataPtr);
+	const int64 NumPixels = RawDataSize / sizeof(FColor);
+
+	// Map all pixels to class ids through the lookup table
+	TArray64<uint16> Ids;
+	Ids.SetNumUninitialized(NumPixels);
+	const int64 UnmatchedPixels = ColorLut->MapToIds(Pixels, Ids.GetData(), NumPixels);
+	FrameStats->AddFrame(FPaths::GetCleanFilename(Filename), UnmatchedPixels);
+
+	const FIntPoint Size = ColorPixelData->GetSize();
+	if (Annotations.IsValid())
+	{
+		Annotations->AppendLine(FMaskAnnotations::FrameAnnotationsLine(FPaths::GetCleanFilename(Filename), Ids.GetData(), Size));
+	}
+
+	// Prepare the output pixels in the format expected by the image wrapper
+	TArray64<uint8> OutputData;
+	ERGBFormat OutputFormat;
+	int32 BitDepth;
+	if (bWriteClassIds && ColorLut->NumIds() <= MAX_uint8 + 1)
+	{
+		OutputFormat = ERGBFormat::Gray;
+		BitDepth = 8;
+		OutputData.SetNumUninitialized(NumPixels);
+		for (int64 i = 0; i < NumPixels; i++)
+		{
+			OutputData[i] = static_cast<uint8>(Ids[i]);
+		}
+	}
+	else if (bWriteClassIds)
+	{
+		OutputFormat = ERGBFormat::Gray;
+		BitDepth = 16;
+		OutputData.SetNumUninitialized(NumPixels * sizeof(uint16));
+		FMemory::Memcpy(OutputData.GetData(), Ids.GetData(), OutputData.Num());
+	}
+	else
+	{
+		OutputFormat = ERGBFormat::BGRA;
+		BitDepth = 8;
+		OutputData.SetNumUninitialized(NumPixels * sizeof(FColor));
+		FColor* OutputColors = reinterpret_cast<FColor*>(OutputData.GetData());
+		for (int64 i = 0; i < NumPixels; i++)
+		{
+			OutputColors[i] = ColorLut->ClassColor(Ids[i]);
+		}
+	}
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>("ImageWrapper");
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() ||
+		!ImageWrapper->SetRaw(OutputData.GetData(), OutputData.Num(), Size.X, Size.Y, OutputFormat, BitDepth))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed to encode %s"), *FString(__FUNCTION__), *Filename)
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(), *Filename))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *Filename)
+		return false;
+	}
+
+	return true;
+}
+
+void UMoviePipelineImageSequenceOutput_SemanticIds::OnReceiveImageDataImpl(FMoviePipelineMergerOutputFrame* InMergedOutputFrame)
+{
+	check(InMergedOutputFrame);
+
+	// Image wrappers are created on the write threads, so make sure the module is loaded from the main thread
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+
+	if (!ColorLut.IsValid())
+	{
+		ColorLut = MakeShared<FSemanticColorLut>(ClassIds, ClassColors, bSnapToClassColors);
+		FrameStats = MakeShared<FSemanticFrameStats>();
+		if (bWriteAnnotations)
+		{
+			UMoviePipelineOutputSetting* OutputSettings = GetPipeline()->GetPipelinePrimaryConfig()->FindSetting<UMoviePipelineOutputSetting>();
+			Annotations = MakeShared<FAnnotationFileWriter>(FPathUtils::MaskAnnotationsFilePath(OutputSettings->OutputDirectory.Path));
+		}
+	}
+
+	// When no other output consumes the merged frame, pixel data is moved into the write task instead of being copied
+	const bool bTakeOwnership = FImageOutputUtils::IsSoleImageOutput(this);
+
+	// The semantic target renders a single pass
+	for (TPair<FMoviePipelinePassIdentifier, TUniquePtr<FImagePixelData>>& RenderPassData : InMergedOutputFrame->ImageOutputData)
+	{
+		const FString FinalFilePath = FImageOutputUtils::ResolveFrameFilePath(
+			this, InMergedOutputFrame->FrameOutputState, TEXT("png"));
+
+		const int32 ShotIndex = RenderPassData.Value->GetPayload<FImagePixelDataPayload>()->SampleState.OutputState.ShotIndex;
+
+		TUniquePtr<FSemanticIdImageWriteTask> SemanticIdImageTask = MakeUnique<FSemanticIdImageWriteTask>();
+		SemanticIdImageTask->Filename = FinalFilePath;
+		SemanticIdImageTask->PixelData = bTakeOwnership ?
+			MoveTemp(RenderPassData.Value) :
+			RenderPassData.Value->CopyImageData();
+		SemanticIdImageTask->ColorLut = ColorLut;
+		SemanticIdImageTask->FrameStats = FrameStats;
+		SemanticIdImageTask->Annotations = Annotations;
+		SemanticIdImageTask->bWriteClassIds = bWriteClassIds;
+
+		MoviePipeline::FMoviePipelineOutputFutureData OutputData;
+		OutputData.Shot = GetPipeline()->GetActiveShotList()[ShotIndex];
+		OutputData.PassIdentifier = RenderPassData.Key;
+		OutputData.FilePath = FinalFilePath;
+		GetPipeline()->AddOutputFuture(ImageWriteQueue->Enqueue(MoveTemp(SemanticIdImageTask)), OutputData);
+	}
+}
+
+void UMoviePipelineImageSequenceOutput_SemanticIds::FinalizeImpl()
+{
+	Super::FinalizeImpl();
+
+	if (!FrameStats.IsValid())
+	{
+		return;
+	}
+
+	// All write tasks are finished by now, so the per-frame counts are complete
+	TArray<FString> Lines;
+	Lines.Add("file,unmatched_pixels");
+	int64 TotalUnmatchedPixels = 0;
+	for (const TPair<FString, int64>& Frame : FrameStats->SortedFrames())
+	{
+		Lines.Add(FString::Printf(TEXT("%s,%lld"), *Frame.Key, Frame.Value));
+		TotalUnmatchedPixels += Frame.Value;
+	}
+
+	UMoviePipelineOutputSetting* OutputSettings = GetPipeline()->GetPipelinePrimaryConfig()->FindSetting<UMoviePipelineOutputSetting>();
+	const FString SaveFilePath = FPathUtils::SemanticUnmatchedPixelsFilePath(OutputSettings->OutputDirectory.Path);
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *SaveFilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *SaveFilePath)
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: %lld pixels in %d frames did not match any semantic class color"),
+		*FString(__FUNCTION__), TotalUnmatchedPixels, Lines.Num() - 1)
+
+	ColorLut.Reset();
+	FrameStats.Reset();
+	Annotations.Reset();
+}
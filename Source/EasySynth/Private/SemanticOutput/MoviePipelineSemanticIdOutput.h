@@ -0,0 +1,134 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImagePixelData.h"
+#include "ImageWriteTask.h"
+#include "MoviePipelineImageSequenceOutput.h"
+
+#include "SemanticOutput/MaskAnnotations.h"
+#include "SemanticOutput/SemanticColorLut.h"
+
+#include "MoviePipelineSemanticIdOutput.generated.h"
+
+
+/**
+ * Thread safe collection of unmatched pixel counts reported by semantic image write tasks
+*/
+class FSemanticFrameStats
+{
+public:
+	/** Adds the number of pixels of the frame file that did not match any class color */
+	void AddFrame(const FString& Filename, const int64 UnmatchedPixels);
+
+	/** Returns frame file names and their unmatched pixel counts, sorted by file name */
+	TArray<TPair<FString, int64>> SortedFrames();
+
+private:
+	/** Guards the frames array against concurrent write tasks */
+	FCriticalSection CriticalSection;
+
+	/** Unmatched pixel counts of each frame */
+	TArray<TPair<FString, int64>> Frames;
+};
+
+
+/**
+ * Image write task that maps semantic image pixels to semantic classes,
+ * and writes either single channel class id images or exact class color images as PNG
+*/
+class FSemanticIdImageWriteTask : public IImageWriteTaskBase
+{
+public:
+	/** The filename to write to */
+	FString Filename;
+
+	/** Semantic image data in any of the pixel formats produced by the pipeline */
+	TUniquePtr<FImagePixelData> PixelData;
+
+	/** Color to class id lookup, shared between all frames */
+	TSharedPtr<const FSemanticColorLut> ColorLut;
+
+	/** Collects unmatched pixel counts, shared between all frames */
+	TSharedPtr<FSemanticFrameStats> FrameStats;
+
+	/** Receives per-class boxes and masks of the frame, annotations are not computed if null */
+	TSharedPtr<FAnnotationFileWriter> Annotations;
+
+	/** Whether class ids or class colors are written */
+	bool bWriteClassIds;
+
+	FSemanticIdImageWriteTask() : bWriteClassIds(true) {}
+
+	virtual bool RunTask() override final;
+	virtual void OnAbandoned() override final {}
+};
+
+
+/**
+ * Movie pipeline output that writes semantic images as class id maps, where class ids
+ * match the rows of the exported SemanticClassIds file, or as images with colors snapped to class colors
+*/
+UCLASS()
+class UMoviePipelineImageSequenceOutput_SemanticIds : public UMoviePipelineImageSequenceOutputBase
+{
+	GENERATED_BODY()
+public:
+#if WITH_EDITOR
+	virtual FText GetDisplayText() const override { return NSLOCTEXT("EasySynth", "SemanticIdsSettingDisplayName", ".png Semantic Classes [8/16bit]"); }
+#endif
+public:
+	UMoviePipelineImageSequenceOutput_SemanticIds()
+	{
+		OutputFormat = EImageFormat::PNG;
+		bWriteClassIds = true;
+		bSnapToClassColors = false;
+		bWriteAnnotations = false;
+	}
+
+	virtual void OnReceiveImageDataImpl(FMoviePipelineMergerOutputFrame* InMergedOutputFrame) override;
+
+	virtual void FinalizeImpl() override;
+
+public:
+	/**
+	* Should single channel class id images be written? Otherwise class color images are written.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Semantic")
+	bool bWriteClassIds;
+
+	/**
+	* Should pixels that match no class, such as blended edges, take the nearest class color?
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Semantic")
+	bool bSnapToClassColors;
+
+	/**
+	* Should per-class bounding boxes and RLE masks of each frame be written into the annotations file?
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Semantic")
+	bool bWriteAnnotations;
+
+	/**
+	* Semantic class ids, starting from id 1, as id 0 marks pixels that match no class
+	*/
+	UPROPERTY()
+	TArray<int32> ClassIds;
+
+	/**
+	* Semantic class colors, matching the class ids
+	*/
+	UPROPERTY()
+	TArray<FColor> ClassColors;
+
+private:
+	/** Color to class id lookup built from the class colors on the first frame */
+	TSharedPtr<const FSemanticColorLut> ColorLut;
+
+	/** Unmatched pixel counts of written frames */
+	TSharedPtr<FSemanticFrameStats> FrameStats;
+
+	/** Annotations file shared by write tasks of all frames */
+	TSharedPtr<FAnnotationFileWriter> Annotations;
+};
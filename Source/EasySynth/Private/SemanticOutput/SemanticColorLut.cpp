@@ -0,0 +1,159 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "SemanticOutput/SemanticColorLut.h"
+
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+#include "EasySynth.h"
+
+
+FSemanticColorLut::FSemanticColorLut(
+	const TArray<int32>& ClassIds,
+	const TArray<FColor>& ClassColors,
+	const bool bSnapToNearest) :
+	bSnapToNearest(bSnapToNearest)
+{
+	check(ClassIds.Num() == ClassColors.Num());
+
+	// Packed colors of pixels always have full alpha, so the zero packed color of unused ids never matches
+	Colors.Add(FColor::Black);
+	PackedColors.Add(0);
+	for (int32 i = 0; i < ClassIds.Num(); i++)
+	{
+		const int32 Id = ClassIds[i];
+		if (Id <= 0 || Id > MAX_uint16)
+		{
+			UE_LOG(LogEasySynth, Error, TEXT("%s: Class id %d cannot be written into class id images"),
+				*FString(__FUNCTION__), Id)
+			continue;
+		}
+		if (Id >= Colors.Num())
+		{
+			Colors.SetNumZeroed(Id + 1);
+			PackedColors.SetNumZeroed(Id + 1);
+		}
+		FColor Color = ClassColors[i];
+		Color.A = 255;
+		Colors[Id] = Color;
+		PackedColors[Id] = Color.DWColor();
+		ExactIds.Add(Color.DWColor(), Id);
+	}
+	for (FColor& Color : Colors)
+	{
+		Color.A = 255;
+	}
+
+	// Each cell takes the class nearest to the cell center
+	CellIds.SetNumZeroed(CellsPerChannel * CellsPerChannel * CellsPerChannel);
+	if (bSnapToNearest && ClassColors.Num() > 0)
+	{
+		const int32 HalfCell = (256 / CellsPerChannel) / 2;
+		ParallelFor(CellsPerChannel, [&](const int32 R)
+		{
+			for (int32 G = 0; G < CellsPerChannel; G++)
+			{
+				for (int32 B = 0; B < CellsPerChannel; B++)
+				{
+					const FIntVector Center(
+						(R << (8 - CellBits)) + HalfCell,
+						(G << (8 - CellBits)) + HalfCell,
+						(B << (8 - CellBits)) + HalfCell);
+
+					int32 BestDistance = MAX_int32;
+					uint16 BestId = 0;
+					for (int32 Id = 1; Id < Colors.Num(); Id++)
+					{
+						if (PackedColors[Id] == 0)
+						{
+							continue;
+						}
+						const FIntVector Delta = Center - FIntVector(Colors[Id].R, Colors[Id].G, Colors[Id].B);
+						const int32 Distance = Delta.X * Delta.X + Delta.Y * Delta.Y + Delta.Z * Delta.Z;
+						if (Distance < BestDistance)
+						{
+							BestDistance = Distance;
+							BestId = Id;
+						}
+					}
+					CellIds[(R << (2 * CellBits)) | (G << CellBits) | B] = BestId;
+				}
+			}
+		});
+	}
+
+	// Cells containing a class color always map to that class
+	for (int32 Id = 1; Id < Colors.Num(); Id++)
+	{
+		if (PackedColors[Id] == 0)
+		{
+			continue;
+		}
+		const FColor& Color = Colors[Id];
+		const int32 Cell =
+			((Color.R >> (8 - CellBits)) << (2 * CellBits)) |
+			((Color.G >> (8 - CellBits)) << CellBits) |
+			(Color.B >> (8 - CellBits));
+		CellIds[Cell] = Id;
+	}
+}
+
+int64 FSemanticColorLut::MapToIds(const FColor* Pixels, uint16* OutIds, const int64 NumPixels) const
+{
+	static_assert(CellBits == 6, "Cell index masks assume 6 bits per channel");
+
+	// FColor is packed as BGRA, so the cell index is assembled from the top bits of each channel
+	const VectorRegister4Int AlphaMask = VectorIntSet1(static_cast<int32>(0xFF000000));
+	const VectorRegister4Int ChannelMask = VectorIntSet1(0x3F);
+	const uint32* PackedPixels = reinterpret_cast<const uint32*>(Pixels);
+	const uint16* CellIdData = CellIds.GetData();
+	const uint32* PackedColorData = PackedColors.GetData();
+
+	int64 Unmatched = 0;
+	int64 i = 0;
+	for (; i + 4 <= NumPixels; i += 4)
+	{
+		// Four cell indices are computed at once, followed by four table reads
+		const VectorRegister4Int PixelColors4 = VectorIntOr(VectorIntLoad(PackedPixels + i), AlphaMask);
+		const VectorRegister4Int Cells4 = VectorIntOr(
+			VectorIntOr(
+				VectorShiftLeftImm(VectorIntAnd(VectorShiftRightImmLogical(PixelColors4, 18), ChannelMask), 12),
+				VectorShiftLeftImm(VectorIntAnd(VectorShiftRightImmLogical(PixelColors4, 10), ChannelMask), 6)),
+			VectorIntAnd(VectorShiftRightImmLogical(PixelColors4, 2), ChannelMask));
+
+		alignas(16) uint32 PixelColors[4];
+		alignas(16) uint32 Cells[4];
+		VectorIntStoreAligned(PixelColors4, PixelColors);
+		VectorIntStoreAligned(Cells4, Cells);
+
+		for (int32 j = 0; j < 4; j++)
+		{
+			const uint16 Id = CellIdData[Cells[j]];
+			OutIds[i + j] = (PackedColorData[Id] == PixelColors[j]) ? Id : ResolveMismatch(PixelColors[j], Id, Unmatched);
+		}
+	}
+
+	// Remaining pixels
+	for (; i < NumPixels; i++)
+	{
+		const uint32 PixelColor = PackedPixels[i] | 0xFF000000;
+		const uint32 Cell = (((PixelColor >> 18) & 0x3F) << 12) | (((PixelColor >> 10) & 0x3F) << 6) | ((PixelColor >> 2) & 0x3F);
+		const uint16 Id = CellIdData[Cell];
+		OutIds[i] = (PackedColorData[Id] == PixelColor) ? Id : ResolveMismatch(PixelColor, Id, Unmatched);
+	}
+
+	return Unmatched;
+}
+
+uint16 FSemanticColorLut::ResolveMismatch(const uint32 PackedColor, const uint16 CellId, int64& InOutUnmatched) const
+{
+	// The pixel may still be an exact class color that shares its cell with another class
+	const uint16* ExactId = ExactIds.Find(PackedColor);
+	if (ExactId != nullptr)
+	{
+		return *ExactId;
+	}
+
+	InOutUnmatched++;
+	return bSnapToNearest ? CellId : 0;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Lookup from semantic image colors to semantic class ids,
+ * with colors that match no class optionally snapped to the nearest class color
+*/
+class FSemanticColorLut
+{
+public:
+	/** Builds the lookup from class ids and their colors, ids unused by any class never match a pixel */
+	FSemanticColorLut(const TArray<int32>& ClassIds, const TArray<FColor>& ClassColors, const bool bSnapToNearest);
+
+	/**
+	 * Maps each pixel to its class id, returns the number of pixels that did not match a class color exactly
+	 * Unmatched pixels get the nearest class id if snapping is enabled, or 0 otherwise
+	*/
+	int64 MapToIds(const FColor* Pixels, uint16* OutIds, const int64 NumPixels) const;
+
+	/** Returns the color of the class id, black for the id 0 */
+	const FColor& ClassColor(const uint16 Id) const { return Colors[Id]; }
+
+	/** Largest class id plus one, which accounts for the id 0 */
+	int32 NumIds() const { return Colors.Num(); }
+
+private:
+	/** Resolves a pixel that differs from the class color of its lookup cell */
+	uint16 ResolveMismatch(const uint32 PackedColor, const uint16 CellId, int64& InOutUnmatched) const;
+
+	/** Bits of each color channel used to index the lookup cells */
+	static constexpr int32 CellBits = 6;
+
+	/** Number of lookup cells along each color channel */
+	static constexpr int32 CellsPerChannel = 1 << CellBits;
+
+	/** Class id for each lookup cell */
+	TArray<uint16> CellIds;
+
+	/** Class colors indexed by id, black for the id 0 and unused ids */
+	TArray<FColor> Colors;
+
+	/** Packed class colors with full alpha indexed by id, used for exact match checks, 0 for unused ids */
+	TArray<uint32> PackedColors;
+
+	/** Class ids of exact class colors, needed when several class colors fall into the same cell */
+	TMap<uint32, uint16> ExactIds;
+
+	/** Whether unmatched pixels take the nearest class id */
+	bool bSnapToNearest;
+};
@@ -2,16 +2,28 @@
 
 #include "SequenceRenderer.h"
 
+#include "Async/Async.h"
 #include "CineCameraComponent.h"
+#include "HAL/FileManager.h"
 #include "MoviePipelineImageSequenceOutput.h"
 #include "MoviePipelineOutputSetting.h"
 #include "MoviePipelineQueueSubsystem.h"
 #include "MovieRenderPipelineSettings.h"
 
+#include "CameraRig/CameraRigRosInterface.h"
+#include "EXROutput/ExrLayerMerger.h"
+#include "EXROutput/ImageBufferPool.h"
 #include "EXROutput/MoviePipelineEXROutputLocal.h"
+#include "OpticalFlow/DepthOpticalFlow.h"
 #include "PathUtils.h"
+#include "PointCloud/DepthPointCloud.h"
+#include "PointCloud/LidarSimulator.h"
+#include "RendererTargets/BoundingBoxExporter.h"
 #include "RendererTargets/CameraPoseExporter.h"
+#include "RendererTargets/FrameMetadata.h"
 #include "RendererTargets/RendererTarget.h"
+#include "SemanticOutput/MoviePipelineInstanceIdOutput.h"
+#include "SemanticOutput/MoviePipelineSemanticIdOutput.h"
 #include "TextureStyles/SemanticCsvInterface.h"
 
 
@@ -21,7 +33,26 @@ const float FRendererTargetOptions::DefaultOpticalFlowScaleValue = 1.0f;
 FRendererTargetOptions::FRendererTargetOptions() :
 	bExportCameraPoses(false),
 	DepthRangeMetersValue(DefaultDepthRangeMetersValue),
-	OpticalFlowScaleValue(DefaultOpticalFlowScaleValue)
+	OpticalFlowScaleValue(DefaultOpticalFlowScaleValue),
+	ExrTileSizeValue(0),
+	bExrMipLevels(false),
+	bCombineExrTargets(false),
+	bEmbedFrameMetadata(false),
+	bSemanticClassIds(false),
+	bSnapSemanticColors(false),
+	bExportMaskAnnotations(false),
+	bExportBoundingBoxes(false),
+	bOpticalFlowFromDepth(false),
+	bExportOcclusionMasks(false),
+	bExportPointClouds(false),
+	bPointCloudsAsNpy(false),
+	bMergeRigPointClouds(false),
+	bExportLidar(false),
+	LidarChannelsValue(32),
+	LidarUpperFovDegreesValue(15.0f),
+	LidarLowerFovDegreesValue(-25.0f),
+	LidarAzimuthResolutionDegreesValue(0.2f),
+	LidarMaxRangeMetersValue(100.0f)
 {
 	SelectedTargets.Init(false, TargetType::COUNT);
 	OutputFormats.Init(EImageFormat::JPEG, TargetType::COUNT);
@@ -39,6 +70,42 @@ bool FRendererTargetOptions::AnyOptionSelected() const
 	return false;
 }
 
+bool FRendererTargetOptions::CombinedExrOutput() const
+{
+	if (!bCombineExrTargets)
+	{
+		return false;
+	}
+	for (int i = 0; i < TargetType::COUNT; i++)
+	{
+		if (SelectedTargets[i] &&
+			(OutputFormats[i] != EImageFormat::EXR || (i == SEMANTIC_IMAGE && SemanticClassOutput()) || i == INSTANCE_IMAGE))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FRendererTargetOptions::LidarOutput() const
+{
+	return bExportLidar && SelectedTargets[DEPTH_IMAGE] && OutputFormats[DEPTH_IMAGE] == EImageFormat::EXR &&
+		LidarChannelsValue > 0 && LidarAzimuthResolutionDegreesValue > 0.0f;
+}
+
+bool FRendererTargetOptions::PointCloudOutput() const
+{
+	return bExportPointClouds && SelectedTargets[DEPTH_IMAGE] && OutputFormats[DEPTH_IMAGE] == EImageFormat::EXR;
+}
+
+bool FRendererTargetOptions::DerivedOpticalFlowOutput() const
+{
+	return bOpticalFlowFromDepth &&
+		SelectedTargets[OPTICAL_FLOW_IMAGE] &&
+		SelectedTargets[DEPTH_IMAGE] &&
+		OutputFormats[DEPTH_IMAGE] == EImageFormat::EXR;
+}
+
 void FRendererTargetOptions::GetSelectedTargets(
 	UTextureStyleManager* TextureStyleManager,
 	TQueue<TSharedPtr<FRendererTarget>>& OutTargetsQueue) const
@@ -46,7 +113,8 @@ void FRendererTargetOptions::GetSelectedTargets(
 	OutTargetsQueue.Empty();
 	for (int i = 0; i < TargetType::COUNT; i++)
 	{
-		if (SelectedTargets[i])
+		// Derived optical flow is generated from the depth target output instead of being rendered
+		if (SelectedTargets[i] && !(i == OPTICAL_FLOW_IMAGE && DerivedOpticalFlowOutput()))
 		{
 			TSharedPtr<FRendererTarget> Target = RendererTarget(i, TextureStyleManager);
 			if (Target != nullptr)
@@ -77,11 +145,27 @@ TSharedPtr<FRendererTarget> FRendererTargetOptions::RendererTarget(
 	case NORMAL_IMAGE: return MakeShared<FNormalImageTarget>(TextureStyleManager, OutputFormat); break;
 	case OPTICAL_FLOW_IMAGE: return MakeShared<FOpticalFlowImageTarget>(
 		TextureStyleManager, OutputFormat, OpticalFlowScaleValue); break;
-	case SEMANTIC_IMAGE: return MakeShared<FSemanticImageTarget>(TextureStyleManager, OutputFormat); break;
+	case SEMANTIC_IMAGE: return MakeShared<FSemanticImageTarget>(
+		TextureStyleManager, OutputFormat, SemanticClassOutput()); break;
+	case INSTANCE_IMAGE: return MakeShared<FInstanceImageTarget>(TextureStyleManager, OutputFormat); break;
 	default: return nullptr;
 	}
 }
 
+FString FRendererTargetOptions::TargetName(const int TargetType)
+{
+	switch (TargetType)
+	{
+	case COLOR_IMAGE: return FColorImageTarget::StaticName(); break;
+	case DEPTH_IMAGE: return FDepthImageTarget::StaticName(); break;
+	case NORMAL_IMAGE: return FNormalImageTarget::StaticName(); break;
+	case OPTICAL_FLOW_IMAGE: return FOpticalFlowImageTarget::StaticName(); break;
+	case SEMANTIC_IMAGE: return FSemanticImageTarget::StaticName(); break;
+	case INSTANCE_IMAGE: return FInstanceImageTarget::StaticName(); break;
+	default: return FString();
+	}
+}
+
 USequenceRenderer::USequenceRenderer() :
 	EasySynthMoviePipelineConfig(DuplicateObject<UMoviePipelinePrimaryConfig>(
 		LoadObject<UMoviePipelinePrimaryConfig>(nullptr, *FPathUtils::DefaultMoviePipelineConfigPath()), nullptr)),
@@ -136,6 +220,28 @@ bool USequenceRenderer::RenderSequence(
 		return false;
 	}
 
+	// Check if outputs derived from depth have what they need, instead of silently rendering without them
+	if (RenderingTargets.OpticalFlowFromDepth() && !RenderingTargets.DerivedOpticalFlowOutput())
+	{
+		ErrorMessage = "Optical flow from depth requires optical flow images and depth images in the EXR format";
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: %s"), *FString(__FUNCTION__), *ErrorMessage)
+		return false;
+	}
+	if (RenderingTargets.ExportPointClouds() && !RenderingTargets.PointCloudOutput())
+	{
+		ErrorMessage = "Point clouds require depth images in the EXR format";
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: %s"), *FString(__FUNCTION__), *ErrorMessage)
+		return false;
+	}
+	if (RenderingTargets.ExportLidar() && !RenderingTargets.LidarOutput())
+	{
+		ErrorMessage = RenderingTargets.LidarChannels() > 0 && RenderingTargets.LidarAzimuthResolutionDegrees() > 0.0f ?
+			"LiDAR sweeps require depth images in the EXR format" :
+			"LiDAR sweeps require a positive number of channels and azimuth resolution";
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: %s"), *FString(__FUNCTION__), *ErrorMessage)
+		return false;
+	}
+
 	// Store parameters
 	RendererTargetOptions = RenderingTargets;
 	OutputResolution = OutputImageResolution;
@@ -238,6 +344,33 @@ bool USequenceRenderer::RenderSequence(
 		return false;
 	}
 
+	// Beams of the simulated LiDAR are assigned to camera pixels before the rig cameras get moved for rendering
+	LidarSimulator.Reset();
+	if (RendererTargetOptions.LidarOutput())
+	{
+		TArray<FLidarSimulator::FRigCamera> LidarRigCameras;
+		for (UCameraComponent* RigCamera : RigCameras)
+		{
+			const FCameraRigData::FCameraData CameraData =
+				FCameraRigRosInterface::GetCameraData(RigCamera, OutputResolution);
+			LidarRigCameras.Add({ CameraData.Transform, FFrameMetadata::CameraIntrinsics(RigCamera, OutputResolution) });
+		}
+
+		FLidarSimulator::FBeamPattern BeamPattern;
+		BeamPattern.Channels = RendererTargetOptions.LidarChannels();
+		BeamPattern.UpperFovDegrees = RendererTargetOptions.LidarUpperFovDegrees();
+		BeamPattern.LowerFovDegrees = RendererTargetOptions.LidarLowerFovDegrees();
+		BeamPattern.AzimuthResolutionDegrees = RendererTargetOptions.LidarAzimuthResolutionDegrees();
+		BeamPattern.MaxRangeMeters = RendererTargetOptions.LidarMaxRangeMeters();
+
+		LidarSimulator = MakeShared<const FLidarSimulator>(
+			BeamPattern,
+			LidarRigCameras,
+			OutputResolution,
+			RendererTargetOptions.DepthRangeMeters(),
+			RendererTargetOptions.PointCloudsAsNpy() ? FDepthPointCloud::EFormat::NPY : FDepthPointCloud::EFormat::PLY);
+	}
+
 	// Export camera rig poses if requested
 	if (RendererTargetOptions.ExportCameraPoses())
 	{
@@ -263,10 +396,22 @@ bool USequenceRenderer::RenderSequence(
 		}
 	}
 
+	// Export instance ids if instance rendering is selected
+	if (RendererTargetOptions.TargetSelected(FRendererTargetOptions::TargetType::INSTANCE_IMAGE))
+	{
+		if (!TextureStyleManager->ExportInstanceIds(RenderingDirectory))
+		{
+			ErrorMessage = "Could not save the instance ids CSV file";
+			UE_LOG(LogEasySynth, Error, TEXT("%s: %s"), *FString(__FUNCTION__), *ErrorMessage)
+			return false;
+		}
+	}
+
 	OriginalTextureStyle = TextureStyleManager->SelectedTextureStyle();
 
 	UE_LOG(LogEasySynth, Log, TEXT("%s: Rendering..."), *FString(__FUNCTION__))
 	bCurrentlyRendering = true;
+	FImageBufferPool::Get().ResetStats();
 
 	FindNextCamera();
 
@@ -288,6 +433,38 @@ void USequenceRenderer::OnExecutorFinished(UMoviePipelineExecutorBase* InPipelin
 		return BroadcastRenderingFinished(false);
 	}
 
+	// PNG images are written by the engine and custom outputs, so the frame metadata is added afterwards,
+	// while the remaining targets render
+	const bool bMayContainPngImages =
+		CurrentTarget->ImageFormat == EImageFormat::PNG || CurrentTarget->CustomOutputSettingClass() != nullptr;
+	if (bMayContainPngImages && CameraFramePoses.Num() > 0)
+	{
+		const FString TargetDir =
+			FPathUtils::RigCameraDir(RenderingDirectory, RigCameras[CurrentRigCameraId]) / CurrentTarget->Name();
+		PngMetadataTasks.Add(Async(EAsyncExecution::ThreadPool,
+			[TargetDir, Poses = CameraFramePoses, Timestamps = CameraFrameTimestamps, Intrinsics = CameraIntrinsics]()
+		{
+			return FFrameMetadata::AddToPngFiles(TargetDir, Poses, Timestamps, Intrinsics);
+		}));
+	}
+
+	// Outputs derived from depth only need the depth frames, so they are generated while the remaining targets render
+	if (CurrentTarget->Name() == FRendererTargetOptions::TargetName(FRendererTargetOptions::TargetType::DEPTH_IMAGE))
+	{
+		if (RendererTargetOptions.DerivedOpticalFlowOutput())
+		{
+			StartDepthOpticalFlow();
+		}
+		if (RendererTargetOptions.PointCloudOutput())
+		{
+			StartDepthPointCloud();
+		}
+		if (LidarSimulator.IsValid())
+		{
+			StartLidarSampling();
+		}
+	}
+
 	// Successful rendering, proceed to the next target
 	FindNextTarget();
 }
@@ -299,6 +476,31 @@ void USequenceRenderer::FindNextCamera()
 	// Check if the end is reached
 	if (CurrentRigCameraId == RigCameras.Num())
 	{
+		if (!WaitForExrMerge())
+		{
+			return BroadcastRenderingFinished(false);
+		}
+		// Point clouds of all cameras are available only after the last camera is rendered
+		if (RendererTargetOptions.PointCloudOutput() && RendererTargetOptions.MergeRigPointClouds())
+		{
+			TArray<FString> CameraPointCloudDirs;
+			for (UCameraComponent* RigCamera : RigCameras)
+			{
+				CameraPointCloudDirs.Add(FPathUtils::PointCloudDir(RenderingDirectory, RigCamera));
+			}
+			if (!FDepthPointCloud::MergePointClouds(
+				CameraPointCloudDirs,
+				RenderingDirectory / FPathUtils::PointCloudDirName,
+				RendererTargetOptions.PointCloudsAsNpy() ? FDepthPointCloud::EFormat::NPY : FDepthPointCloud::EFormat::PLY))
+			{
+				ErrorMessage = "Could not merge point clouds of rig cameras";
+				return BroadcastRenderingFinished(false);
+			}
+		}
+		if (LidarSimulator.IsValid() && !FinalizeLidarSweeps())
+		{
+			return BroadcastRenderingFinished(false);
+		}
 		return BroadcastRenderingFinished(true);
 	}
 
@@ -315,21 +517,62 @@ void USequenceRenderer::FindNextCamera()
 		RigCameras[0]->SetFieldOfView(RigCameras[CurrentRigCameraId]->FieldOfView);
 	}
 
-	// Export camera poses if requested
-	if (RendererTargetOptions.ExportCameraPoses())
+	// Export camera poses if requested, and keep them if they are embedded into images or used by other outputs
+	CameraFramePoses.Empty();
+	CameraFrameTimestamps.Empty();
+	DepthFramePoses.Empty();
+	if (RendererTargetOptions.ExportCameraPoses() ||
+		RendererTargetOptions.EmbedFrameMetadata() ||
+		RendererTargetOptions.ExportBoundingBoxes() ||
+		RendererTargetOptions.DerivedOpticalFlowOutput() ||
+		RendererTargetOptions.PointCloudOutput())
 	{
+		// Bounding boxes of actors animated by the sequence follow their transforms in each frame
 		FCameraPoseExporter CameraPoseExporter;
-		if (!CameraPoseExporter.ExportCameraPoses(
-			RenderingSequence, OutputResolution, RenderingDirectory, RigCameras[CurrentRigCameraId]))
+		CameraPoseExporter.SetExtractActorTransforms(RendererTargetOptions.ExportBoundingBoxes());
+		const bool bPosesReady = RendererTargetOptions.ExportCameraPoses() ?
+			CameraPoseExporter.ExportCameraPoses(
+				RenderingSequence, OutputResolution, RenderingDirectory, RigCameras[CurrentRigCameraId]) :
+			CameraPoseExporter.ExtractCameraPoses(RenderingSequence, RigCameras[CurrentRigCameraId]);
+		if (!bPosesReady)
 		{
 			ErrorMessage = "Could not export camera poses";
 			return BroadcastRenderingFinished(false);
 		}
+
+		if (RendererTargetOptions.EmbedFrameMetadata())
+		{
+			CameraFramePoses = CameraPoseExporter.GetCameraTransforms();
+			CameraFrameTimestamps = CameraPoseExporter.GetTimestamps();
+			CameraIntrinsics = FFrameMetadata::CameraIntrinsics(RigCameras[CurrentRigCameraId], OutputResolution);
+		}
+
+		if (RendererTargetOptions.DerivedOpticalFlowOutput() || RendererTargetOptions.PointCloudOutput())
+		{
+			DepthFramePoses = CameraPoseExporter.GetCameraTransforms();
+		}
+
+		if (RendererTargetOptions.ExportBoundingBoxes())
+		{
+			FBoundingBoxExporter BoundingBoxExporter;
+			BoundingBoxExporter.CollectActors(TextureStyleManager);
+			if (!BoundingBoxExporter.ExportBoundingBoxes(
+				CameraPoseExporter.GetCameraTransforms(),
+				CameraPoseExporter.GetActorTransforms(),
+				FFrameMetadata::CameraIntrinsics(RigCameras[CurrentRigCameraId], OutputResolution),
+				OutputResolution,
+				FPathUtils::BoundingBoxesFilePath(RenderingDirectory, RigCameras[CurrentRigCameraId])))
+			{
+				ErrorMessage = "Could not export bounding boxes";
+				return BroadcastRenderingFinished(false);
+			}
+		}
 	}
 
 	// Prepare the targets queue
 	RendererTargetOptions.GetSelectedTargets(TextureStyleManager, TargetsQueue);
 	CurrentTarget = nullptr;
+	RenderedTargetNames.Empty();
 
 	UE_LOG(LogEasySynth, Log, TEXT("%s: Rendering camera %d/%d"), *FString(__FUNCTION__), CurrentRigCameraId + 1, RigCameras.Num())
 
@@ -342,11 +585,16 @@ void USequenceRenderer::FindNextTarget()
 	// Check if the end is reached
 	if (TargetsQueue.IsEmpty())
 	{
+		if (!FinalizeCameraOutputs())
+		{
+			return BroadcastRenderingFinished(false);
+		}
 		return FindNextCamera();
 	}
 
 	// Select the next requested target
 	TargetsQueue.Dequeue(CurrentTarget);
+	RenderedTargetNames.Add(CurrentTarget->Name());
 
 	// Setup specifics of the current rendering target
 	UE_LOG(LogEasySynth, Log, TEXT("%s: Rendering the %s target"), *FString(__FUNCTION__), *CurrentTarget->Name())
@@ -420,6 +668,215 @@ void USequenceRenderer::StartRendering()
 	ActiveExecutor->OnExecutorFinished().AddUObject(this, &USequenceRenderer::OnExecutorFinished);
 }
 
+void USequenceRenderer::StartDepthOpticalFlow()
+{
+	const FString FlowTargetName =
+		FRendererTargetOptions::TargetName(FRendererTargetOptions::TargetType::OPTICAL_FLOW_IMAGE);
+	const FString CameraDir = FPathUtils::RigCameraDir(RenderingDirectory, RigCameras[CurrentRigCameraId]);
+	const FString DepthDir = CameraDir / CurrentTarget->Name();
+	const FString FlowDir = CameraDir / FlowTargetName;
+
+	// Flow images are combined with the rendered targets as if they were rendered
+	RenderedTargetNames.Add(FlowTargetName);
+
+	// Backward flow and occlusion masks are generated by the same workers, next to the forward flow
+	FString BackwardFlowDir;
+	FString OcclusionMaskDir;
+	if (RendererTargetOptions.ExportOcclusionMasks())
+	{
+		BackwardFlowDir = FPathUtils::BackwardOpticalFlowDir(RenderingDirectory, RigCameras[CurrentRigCameraId]);
+		OcclusionMaskDir = FPathUtils::OcclusionMaskDir(RenderingDirectory, RigCameras[CurrentRigCameraId]);
+		RenderedTargetNames.Add(FPathUtils::BackwardOpticalFlowDirName);
+		RenderedTargetNames.Add(FPathUtils::OcclusionMaskDirName);
+	}
+
+	// Everything the generator needs is copied here, as the renderer state keeps changing
+	const FDepthOpticalFlow DepthOpticalFlow(
+		DepthFramePoses,
+		FFrameMetadata::CameraIntrinsics(RigCameras[CurrentRigCameraId], OutputResolution),
+		RendererTargetOptions.DepthRangeMeters(),
+		RendererTargetOptions.OpticalFlowScale(),
+		RendererTargetOptions.OutputFormat(FRendererTargetOptions::TargetType::OPTICAL_FLOW_IMAGE),
+		EasySynthMoviePipelineConfig->FindSetting<UMoviePipelineImageSequenceOutput_EXRLocal>());
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Deriving optical flow from %s"), *FString(__FUNCTION__), *DepthDir)
+	DepthOpticalFlowTask = Async(EAsyncExecution::ThreadPool,
+		[DepthOpticalFlow, DepthDir, FlowDir, BackwardFlowDir, OcclusionMaskDir]()
+		{
+			return DepthOpticalFlow.GenerateFlowImages(DepthDir, FlowDir, BackwardFlowDir, OcclusionMaskDir);
+		});
+}
+
+void USequenceRenderer::StartDepthPointCloud()
+{
+	const FString DepthDir = FPathUtils::RigCameraDir(RenderingDirectory, RigCameras[CurrentRigCameraId]) /
+		CurrentTarget->Name();
+	const FString PointCloudDir = FPathUtils::PointCloudDir(RenderingDirectory, RigCameras[CurrentRigCameraId]);
+
+	// Everything the generator needs is copied here, as the renderer state keeps changing
+	const FDepthPointCloud DepthPointCloud(
+		DepthFramePoses,
+		FFrameMetadata::CameraIntrinsics(RigCameras[CurrentRigCameraId], OutputResolution),
+		RendererTargetOptions.DepthRangeMeters(),
+		RendererTargetOptions.PointCloudsAsNpy() ? FDepthPointCloud::EFormat::NPY : FDepthPointCloud::EFormat::PLY);
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Generating point clouds from %s"), *FString(__FUNCTION__), *DepthDir)
+	DepthPointCloudTask = Async(EAsyncExecution::ThreadPool, [DepthPointCloud, DepthDir, PointCloudDir]()
+	{
+		return DepthPointCloud.GeneratePointClouds(DepthDir, PointCloudDir);
+	});
+}
+
+void USequenceRenderer::StartLidarSampling()
+{
+	const int32 CameraIndex = CurrentRigCameraId;
+	const FString DepthDir = FPathUtils::RigCameraDir(RenderingDirectory, RigCameras[CameraIndex]) /
+		CurrentTarget->Name();
+	const FString SweepDir = FPathUtils::LidarDir(RenderingDirectory, RigCameras[CameraIndex]);
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Resampling LiDAR beams from %s"), *FString(__FUNCTION__), *DepthDir)
+	LidarSamplingTask = Async(EAsyncExecution::ThreadPool,
+		[Simulator = LidarSimulator, CameraIndex, DepthDir, SweepDir]()
+		{
+			return Simulator->SampleCamera(CameraIndex, DepthDir, SweepDir);
+		});
+}
+
+bool USequenceRenderer::FinalizeLidarSweeps()
+{
+	TArray<FString> CameraSweepDirs;
+	for (UCameraComponent* RigCamera : RigCameras)
+	{
+		CameraSweepDirs.Add(FPathUtils::LidarDir(RenderingDirectory, RigCamera));
+	}
+
+	const FDepthPointCloud::EFormat Format = RendererTargetOptions.PointCloudsAsNpy() ?
+		FDepthPointCloud::EFormat::NPY : FDepthPointCloud::EFormat::PLY;
+	if (!FLidarSimulator::MergeSweeps(CameraSweepDirs, RenderingDirectory / FPathUtils::LidarDirName, Format))
+	{
+		ErrorMessage = "Could not combine LiDAR sweeps of rig cameras";
+		return false;
+	}
+
+	// Partial sweeps only hold the beams seen by a single camera
+	for (const FString& CameraSweepDir : CameraSweepDirs)
+	{
+		IFileManager::Get().DeleteDirectory(*CameraSweepDir, false, true);
+	}
+
+	return true;
+}
+
+bool USequenceRenderer::FinalizeCameraOutputs()
+{
+	if (!WaitForPngMetadata())
+	{
+		return false;
+	}
+
+	// LiDAR beams have to be resampled before depth images of combined outputs are removed
+	if (LidarSamplingTask.IsValid())
+	{
+		const bool bLidarSampled = LidarSamplingTask.Get();
+		LidarSamplingTask.Reset();
+		if (!bLidarSampled)
+		{
+			ErrorMessage = "Could not resample LiDAR beams from depth images";
+			return false;
+		}
+	}
+
+	// Point clouds have to be complete before depth images of combined outputs are removed
+	if (DepthPointCloudTask.IsValid())
+	{
+		const bool bPointCloudsGenerated = DepthPointCloudTask.Get();
+		DepthPointCloudTask.Reset();
+		if (!bPointCloudsGenerated)
+		{
+			ErrorMessage = "Could not generate point clouds from depth images";
+			return false;
+		}
+	}
+
+	// Derived optical flow has to be complete before the camera outputs are finalized
+	if (DepthOpticalFlowTask.IsValid())
+	{
+		const bool bFlowGenerated = DepthOpticalFlowTask.Get();
+		DepthOpticalFlowTask.Reset();
+		if (!bFlowGenerated)
+		{
+			ErrorMessage = "Could not derive optical flow from depth images";
+			return false;
+		}
+	}
+
+	if (!RendererTargetOptions.CombinedExrOutput())
+	{
+		return true;
+	}
+
+	const UMoviePipelineImageSequenceOutput_EXRLocal* ExrSetting =
+		EasySynthMoviePipelineConfig->FindSetting<UMoviePipelineImageSequenceOutput_EXRLocal>();
+	if (ExrSetting == nullptr)
+	{
+		ErrorMessage = "Could not find the EXR setting inside the default config";
+		return false;
+	}
+
+	// Only one camera is merged at a time, to keep the disk traffic next to the rendering bounded
+	if (!WaitForExrMerge())
+	{
+		return false;
+	}
+
+	// Write all targets of each frame as layers of a single file inside the camera directory,
+	// while the next camera is rendered, everything the merger needs is copied here
+	const FExrLayerMerger ExrLayerMerger(ExrSetting);
+	const FString CameraDir = FPathUtils::RigCameraDir(RenderingDirectory, RigCameras[CurrentRigCameraId]);
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Merging EXR targets inside %s"), *FString(__FUNCTION__), *CameraDir)
+	ExrMergeTask = Async(EAsyncExecution::ThreadPool, [ExrLayerMerger, CameraDir, TargetNames = RenderedTargetNames]()
+	{
+		return ExrLayerMerger.MergeTargets(CameraDir, TargetNames);
+	});
+
+	return true;
+}
+
+bool USequenceRenderer::WaitForPngMetadata()
+{
+	bool bMetadataAdded = true;
+	for (TFuture<bool>& PngMetadataTask : PngMetadataTasks)
+	{
+		bMetadataAdded &= PngMetadataTask.Get();
+	}
+	PngMetadataTasks.Empty();
+
+	if (!bMetadataAdded)
+	{
+		ErrorMessage = "Failed while adding metadata to PNG images";
+		return false;
+	}
+
+	return true;
+}
+
+bool USequenceRenderer::WaitForExrMerge()
+{
+	if (!ExrMergeTask.IsValid())
+	{
+		return true;
+	}
+
+	const bool bMerged = ExrMergeTask.Get();
+	ExrMergeTask.Reset();
+	if (!bMerged)
+	{
+		ErrorMessage = "Could not combine the EXR targets";
+		return false;
+	}
+	return true;
+}
+
 bool USequenceRenderer::PrepareJobQueue(UMoviePipelineQueueSubsystem* MoviePipelineQueueSubsystem)
 {
 	check(MoviePipelineQueueSubsystem)
@@ -431,14 +888,58 @@ bool USequenceRenderer::PrepareJobQueue(UMoviePipelineQueueSubsystem* MoviePipel
 		UMoviePipelineImageSequenceOutput_PNG::StaticClass(), true);
 	UMoviePipelineSetting* ExrSetting = EasySynthMoviePipelineConfig->FindOrAddSettingByClass(
 		UMoviePipelineImageSequenceOutput_EXRLocal::StaticClass(), true);
-	if (JpegSetting == nullptr || PngSetting == nullptr || ExrSetting == nullptr)
+	UMoviePipelineSetting* SemanticIdsSetting = EasySynthMoviePipelineConfig->FindOrAddSettingByClass(
+		UMoviePipelineImageSequenceOutput_SemanticIds::StaticClass(), true);
+	UMoviePipelineSetting* InstanceIdsSetting = EasySynthMoviePipelineConfig->FindOrAddSettingByClass(
+		UMoviePipelineImageSequenceOutput_InstanceIds::StaticClass(), true);
+	if (JpegSetting == nullptr || PngSetting == nullptr || ExrSetting == nullptr ||
+		SemanticIdsSetting == nullptr || InstanceIdsSetting == nullptr)
 	{
-		ErrorMessage = "JPEG, PNG or EXR settings not found";
+		ErrorMessage = "JPEG, PNG, EXR, semantic ids or instance ids settings not found";
 		return false;
 	}
-	JpegSetting->SetIsEnabled(CurrentTarget->ImageFormat == EImageFormat::JPEG);
-	PngSetting->SetIsEnabled(CurrentTarget->ImageFormat == EImageFormat::PNG);
-	ExrSetting->SetIsEnabled(CurrentTarget->ImageFormat == EImageFormat::EXR);
+
+	// Targets with a custom output only use that output
+	UClass* CustomOutputSettingClass = CurrentTarget->CustomOutputSettingClass();
+	const bool bImageFormatOutput = (CustomOutputSettingClass == nullptr);
+	JpegSetting->SetIsEnabled(bImageFormatOutput && CurrentTarget->ImageFormat == EImageFormat::JPEG);
+	PngSetting->SetIsEnabled(bImageFormatOutput && CurrentTarget->ImageFormat == EImageFormat::PNG);
+	ExrSetting->SetIsEnabled(bImageFormatOutput && CurrentTarget->ImageFormat == EImageFormat::EXR);
+	SemanticIdsSetting->SetIsEnabled(CustomOutputSettingClass == SemanticIdsSetting->GetClass());
+	InstanceIdsSetting->SetIsEnabled(CustomOutputSettingClass == InstanceIdsSetting->GetClass());
+
+	// Update semantic class output
+	UMoviePipelineImageSequenceOutput_SemanticIds* SemanticIdsOutputSetting =
+		CastChecked<UMoviePipelineImageSequenceOutput_SemanticIds>(SemanticIdsSetting);
+	TextureStyleManager->SemanticClassIdColors(SemanticIdsOutputSetting->ClassIds, SemanticIdsOutputSetting->ClassColors);
+	SemanticIdsOutputSetting->bWriteClassIds = RendererTargetOptions.SemanticClassIds();
+	SemanticIdsOutputSetting->bSnapToClassColors = RendererTargetOptions.SnapSemanticColors();
+	SemanticIdsOutputSetting->bWriteAnnotations = RendererTargetOptions.ExportMaskAnnotations();
+
+	// Update instance id output
+	UMoviePipelineImageSequenceOutput_InstanceIds* InstanceIdsOutputSetting =
+		CastChecked<UMoviePipelineImageSequenceOutput_InstanceIds>(InstanceIdsSetting);
+	InstanceIdsOutputSetting->MaxInstanceId = TextureStyleManager->MaxInstanceId();
+	InstanceIdsOutputSetting->bWriteAnnotations = RendererTargetOptions.ExportMaskAnnotations();
+
+	// Update EXR tiling
+	UMoviePipelineImageSequenceOutput_EXRLocal* ExrOutputSetting = Cast<UMoviePipelineImageSequenceOutput_EXRLocal>(ExrSetting);
+	if (ExrOutputSetting == nullptr)
+	{
+		ErrorMessage = "Could not cast the EXR setting";
+		return false;
+	}
+	ExrOutputSetting->bTiled = RendererTargetOptions.ExrTileSize() > 0;
+	if (ExrOutputSetting->bTiled)
+	{
+		ExrOutputSetting->TileSize = RendererTargetOptions.ExrTileSize();
+	}
+	ExrOutputSetting->bMipLevels = RendererTargetOptions.ExrMipLevels();
+
+	// Frame metadata is only written if camera poses were kept for the current camera
+	ExrOutputSetting->FrameCameraPoses = CameraFramePoses;
+	ExrOutputSetting->FrameTimestamps = CameraFrameTimestamps;
+	ExrOutputSetting->CameraIntrinsics = CameraIntrinsics;
 
 	// Update pipeline output settings for the current target
 	UMoviePipelineOutputSetting* OutputSetting =
@@ -507,12 +1008,44 @@ void USequenceRenderer::BroadcastRenderingFinished(const bool bSuccess)
 		RigCameras[0]->SetFieldOfView(OriginalCameraFOV);
 	}
 
+	// Make sure no derived outputs are still being written when the rendering is reported as finished
+	if (DepthOpticalFlowTask.IsValid())
+	{
+		DepthOpticalFlowTask.Wait();
+		DepthOpticalFlowTask.Reset();
+	}
+	if (DepthPointCloudTask.IsValid())
+	{
+		DepthPointCloudTask.Wait();
+		DepthPointCloudTask.Reset();
+	}
+	if (LidarSamplingTask.IsValid())
+	{
+		LidarSamplingTask.Wait();
+		LidarSamplingTask.Reset();
+	}
+	if (ExrMergeTask.IsValid())
+	{
+		ExrMergeTask.Wait();
+		ExrMergeTask.Reset();
+	}
+	for (TFuture<bool>& PngMetadataTask : PngMetadataTasks)
+	{
+		PngMetadataTask.Wait();
+	}
+	PngMetadataTasks.Empty();
+	LidarSimulator.Reset();
+
 	RigCameras.Empty();
 	TargetsQueue.Empty();
 
 	// Revert world state to the original one
 	TextureStyleManager->CheckoutTextureStyle(OriginalTextureStyle);
 
+	// Report image buffer reuse and free the memory kept for the rendering
+	FImageBufferPool::Get().LogStats();
+	FImageBufferPool::Get().Trim();
+
 	bCurrentlyRendering = false;
 	RenderingFinishedEvent.Broadcast(bSuccess);
 }
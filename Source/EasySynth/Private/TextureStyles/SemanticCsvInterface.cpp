@@ -57,16 +57,14 @@ FReply FSemanticCsvInterface::OnImportSemanticClassesClicked(UTextureStyleManage
 		}
 	}
 
-	TextureStyleManager->RemoveAllSemanticCLasses();
-
 	// Parse the file contents
 	const FCsvParser CsvParser(FileContent);
 	const FCsvParser::FRows& Rows = CsvParser.GetRows();
 
-	for (int i = 0; i < Rows.Num(); i++)
+	TArray<TPair<FString, FColor>> Classes;
+	Classes.Reserve(Rows.Num());
+	for (const TArray<const TCHAR*>& Row : Rows)
 	{
-		const TArray<const TCHAR*>& Row = Rows[i];
-
 		if (Row.Num() != 4)
 		{
 			const FText MessageBoxTitle = LOCTEXT("InvalidCsvMessageBoxTitle", "Failed to load CSV");
@@ -76,12 +74,18 @@ FReply FSemanticCsvInterface::OnImportSemanticClassesClicked(UTextureStyleManage
 				&MessageBoxTitle);
 			return FReply::Handled();
 		}
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: %s"), *FString(__FUNCTION__), Row[0])
 
-		const bool bSaveTextureMappingAsset = (i == Rows.Num() - 1);
-		TextureStyleManager->NewSemanticClass(Row[0],
-			FColor(FCString::Atoi(Row[1]), FCString::Atoi(Row[2]), FCString::Atoi(Row[3])),
-			bSaveTextureMappingAsset);
+		Classes.Emplace(Row[0], FColor(FCString::Atoi(Row[1]), FCString::Atoi(Row[2]), FCString::Atoi(Row[3])));
+	}
+
+	// All classes are validated and inserted at once, with a single asset save
+	if (!TextureStyleManager->ImportSemanticClasses(Classes))
+	{
+		const FText MessageBoxTitle = LOCTEXT("InvalidCsvMessageBoxTitle", "Failed to load CSV");
+		FMessageDialog::Open(
+			EAppMsgType::Ok,
+			LOCTEXT("CollidingClassesMessageBoxText", "Class names and colors must be non-empty and unique"),
+			&MessageBoxTitle);
 	}
 
 	return FReply::Handled();
@@ -110,6 +114,27 @@ bool FSemanticCsvInterface::ExportSemanticClasses(const FString& OutputDir, UTex
 		return false;
 	}
 
+	// Save ids used by class id images, with 0 reserved for pixels that match no class
+	TArray<FString> IdLines;
+	IdLines.Add("id,name,r,g,b");
+	for (const FSemanticClass* Class : TextureMappingAsset->ClassesById())
+	{
+		IdLines.Add(FString::Printf(TEXT("%d,%s,%d,%d,%d"),
+			Class->Key, *Class->Name, Class->Color.R, Class->Color.G, Class->Color.B));
+	}
+
+	const FString SaveIdsFilePath = FPathUtils::SemanticClassIdsFilePath(OutputDir);
+	if (!FFileHelper::SaveStringArrayToFile(
+		IdLines,
+		*SaveIdsFilePath,
+		FFileHelper::EEncodingOptions::AutoDetect,
+		&IFileManager::Get(),
+		EFileWrite::FILEWRITE_None))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *SaveIdsFilePath)
+		return false;
+	}
+
 	return true;
 }
 
@@ -0,0 +1,152 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#include "TextureStyles/SemanticRulesAsset.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInterface.h"
+
+#include "EasySynth.h"
+
+
+void USemanticRulesAsset::CompileRules(const TArray<FString>& ClassNames)
+{
+	CompiledClassNames = ClassNames;
+	bRulesCompiled = true;
+
+	CompiledRules.Reset(Rules.Num());
+	for (const FSemanticLabelingRule& Rule : Rules)
+	{
+		if (!ClassNames.Contains(Rule.ClassName))
+		{
+			UE_LOG(LogEasySynth, Warning, TEXT("%s: Skipping a rule of the unknown semantic class '%s'"),
+				*FString(__FUNCTION__), *Rule.ClassName)
+			continue;
+		}
+
+		FCompiledRule& CompiledRule = CompiledRules.AddDefaulted_GetRef();
+		CompiledRule.Rule = &Rule;
+		if (!Rule.ActorLabelRegex.IsEmpty())
+		{
+			CompiledRule.ActorLabelPattern = MakeShared<FRegexPattern>(Rule.ActorLabelRegex);
+		}
+		if (!Rule.FolderPath.IsEmpty())
+		{
+			CompiledRule.FolderPrefix = Rule.FolderPath;
+			CompiledRule.FolderPrefix.RemoveFromEnd(TEXT("/"));
+			CompiledRule.FolderPrefix += TEXT("/");
+		}
+	}
+
+	// Stable sorting keeps the order of rules with equal priorities
+	CompiledRules.StableSort([](const FCompiledRule& A, const FCompiledRule& B)
+	{
+		return A.Rule->Priority > B.Rule->Priority;
+	});
+}
+
+const FString* USemanticRulesAsset::MatchingClassName(
+	const AActor* Actor,
+	TFunctionRef<void(const AActor*, TArray<const UMaterialInterface*>&)> ActorMaterials) const
+{
+	// Materials are gathered at most once, and only if a checked rule needs them
+	TArray<const UMaterialInterface*> Materials;
+	bool bMaterialsGathered = false;
+	auto GatheredMaterials = [&]() -> const TArray<const UMaterialInterface*>&
+	{
+		if (!bMaterialsGathered)
+		{
+			ActorMaterials(Actor, Materials);
+			bMaterialsGathered = true;
+		}
+		return Materials;
+	};
+
+	for (const FCompiledRule& CompiledRule : CompiledRules)
+	{
+		if (Matches(CompiledRule, Actor, GatheredMaterials))
+		{
+			return &CompiledRule.Rule->ClassName;
+		}
+	}
+	return nullptr;
+}
+
+#if WITH_EDITOR
+void USemanticRulesAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	// Compiled rules point into the edited array, and actors added later are still labeled using them
+	if (bRulesCompiled)
+	{
+		const TArray<FString> ClassNames = CompiledClassNames;
+		CompileRules(ClassNames);
+	}
+}
+#endif
+
+bool USemanticRulesAsset::Matches(
+	const FCompiledRule& CompiledRule,
+	const AActor* Actor,
+	TFunctionRef<const TArray<const UMaterialInterface*>&()> ActorMaterials)
+{
+	const FSemanticLabelingRule& Rule = *CompiledRule.Rule;
+
+	// Cheaper criteria are checked first
+	if (Rule.ActorClass != nullptr && !Actor->IsA(Rule.ActorClass))
+	{
+		return false;
+	}
+
+	if (!CompiledRule.FolderPrefix.IsEmpty())
+	{
+		const FString ActorFolder = Actor->GetFolderPath().ToString() + TEXT("/");
+		if (!ActorFolder.StartsWith(CompiledRule.FolderPrefix))
+		{
+			return false;
+		}
+	}
+
+	if (CompiledRule.ActorLabelPattern.IsValid())
+	{
+		FRegexMatcher Matcher(*CompiledRule.ActorLabelPattern, Actor->GetActorLabel());
+		if (!Matcher.FindNext())
+		{
+			return false;
+		}
+	}
+
+	if (!Rule.MeshPathGlob.IsEmpty())
+	{
+		bool bMeshMatched = false;
+		for (const UActorComponent* Component : Actor->GetComponents())
+		{
+			const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component);
+			const UStaticMesh* StaticMesh =
+				StaticMeshComponent != nullptr ? StaticMeshComponent->GetStaticMesh() : nullptr;
+			if (StaticMesh != nullptr && StaticMesh->GetPathName().MatchesWildcard(Rule.MeshPathGlob))
+			{
+				bMeshMatched = true;
+				break;
+			}
+		}
+		if (!bMeshMatched)
+		{
+			return false;
+		}
+	}
+
+	if (!Rule.MaterialName.IsEmpty())
+	{
+		const bool bMaterialMatched = ActorMaterials().ContainsByPredicate([&](const UMaterialInterface* Material)
+		{
+			return Material != nullptr && Material->GetName().MatchesWildcard(Rule.MaterialName);
+		});
+		if (!bMaterialMatched)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -2,7 +2,11 @@
 
 #include "TextureStyles/TextureBackupManager.h"
 
+#include "Async/ParallelFor.h"
+#include "Components/MeshComponent.h"
+#include "LandscapeComponent.h"
 #include "LandscapeProxy.h"
+#include "Materials/MaterialInstanceConstant.h"
 
 
 void UTextureBackupManager::AddAndPaint(
@@ -29,7 +33,7 @@ bool UTextureBackupManager::ContainsActor(AActor* Actor)
 		return LandscapeActorDescriptors.Contains(LandscapeProxy);
 	}
 
-	return OriginalActorDescriptors.Contains(Actor);
+	return ActorBackupRanges.Contains(Actor);
 }
 
 void UTextureBackupManager::RemoveActor(AActor* Actor)
@@ -38,10 +42,101 @@ void UTextureBackupManager::RemoveActor(AActor* Actor)
 	if (LandscapeProxy != nullptr)
 	{
 		LandscapeActorDescriptors.Remove(LandscapeProxy);
+		for (auto It = LandscapeMaterialStates.CreateIterator(); It; ++It)
+		{
+			if (It.Key().Key == TObjectKey<ALandscapeProxy>(LandscapeProxy))
+			{
+				It.RemoveCurrent();
+			}
+		}
+		return;
+	}
+
+	ReleaseActor(Actor);
+}
+
+void UTextureBackupManager::OriginalActorMaterials(
+	const AActor* Actor,
+	TArray<const UMaterialInterface*>& OutMaterials) const
+{
+	OutMaterials.Reset();
+
+	// Landscapes are represented by their landscape material
+	const ALandscapeProxy* LandscapeProxy = Cast<ALandscapeProxy>(Actor);
+	if (LandscapeProxy != nullptr)
+	{
+		UMaterialInstanceConstant* const* OriginalMaterial =
+			LandscapeActorDescriptors.Find(const_cast<ALandscapeProxy*>(LandscapeProxy));
+		OutMaterials.Add(OriginalMaterial != nullptr ? *OriginalMaterial : LandscapeProxy->GetLandscapeMaterial());
 		return;
 	}
 
-	OriginalActorDescriptors.Remove(Actor);
+	const FActorBackupRange* Range = ActorBackupRanges.Find(Actor);
+	if (Range != nullptr)
+	{
+		for (int32 ComponentIndex = Range->FirstComponent;
+			ComponentIndex < Range->FirstComponent + Range->NumComponents;
+			ComponentIndex++)
+		{
+			OutMaterials.Append(
+				BackupMaterials.GetData() + ComponentFirstMaterials[ComponentIndex],
+				ComponentNumMaterials[ComponentIndex]);
+		}
+		return;
+	}
+
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		const UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(Component);
+		if (PrimitiveComponent == nullptr)
+		{
+			continue;
+		}
+		for (int32 i = 0; i < PrimitiveComponent->GetNumMaterials(); i++)
+		{
+			OutMaterials.Add(PrimitiveComponent->GetMaterial(i));
+		}
+	}
+}
+
+SIZE_T UTextureBackupManager::GetAllocatedSize() const
+{
+	SIZE_T LandscapeStatesSize = LandscapeMaterialStates.GetAllocatedSize();
+	for (const auto& Element : LandscapeMaterialStates)
+	{
+		const FLandscapeMaterialState& State = Element.Value;
+		LandscapeStatesSize += State.Components.GetAllocatedSize() +
+			State.MaterialInstances.GetAllocatedSize() +
+			State.LODIndexToMaterialIndex.GetAllocatedSize();
+		for (int32 i = 0; i < State.Components.Num(); i++)
+		{
+			LandscapeStatesSize += State.MaterialInstances[i].GetAllocatedSize() +
+				State.LODIndexToMaterialIndex[i].GetAllocatedSize();
+		}
+	}
+
+	return ActorBackupRanges.GetAllocatedSize() +
+		BackupComponents.GetAllocatedSize() +
+		ComponentFirstMaterials.GetAllocatedSize() +
+		ComponentNumMaterials.GetAllocatedSize() +
+		BackupMaterials.GetAllocatedSize() +
+		LandscapeActorDescriptors.GetAllocatedSize() +
+		LandscapeStatesSize;
+}
+
+void UTextureBackupManager::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	// Material instances are released together with their state when it is replaced or its proxy is removed
+	UTextureBackupManager* This = CastChecked<UTextureBackupManager>(InThis);
+	for (auto& Element : This->LandscapeMaterialStates)
+	{
+		for (TArray<TObjectPtr<UMaterialInstanceConstant>>& MaterialInstances : Element.Value.MaterialInstances)
+		{
+			Collector.AddReferencedObjects(MaterialInstances);
+		}
+	}
 }
 
 void UTextureBackupManager::AddLandscapeActor(
@@ -57,11 +152,10 @@ void UTextureBackupManager::AddLandscapeActor(
 		// Revert to original material
 		if (bDoPaint)
 		{
-			LandscapeProxy->LandscapeMaterial = Cast<UMaterialInstance>(LandscapeActorDescriptors[LandscapeProxy]);
-			if (LandscapeProxy->LandscapeMaterial != nullptr)
+			UMaterialInstance* OriginalMaterial = Cast<UMaterialInstance>(LandscapeActorDescriptors[LandscapeProxy]);
+			if (OriginalMaterial != nullptr)
 			{
-				FPropertyChangedEvent PropertyChangedEvent(FindFieldChecked<FProperty>(LandscapeProxy->GetClass(), FName("LandscapeMaterial")));
-				LandscapeProxy->PostEditChangeProperty(PropertyChangedEvent);
+				SetLandscapeMaterial(LandscapeProxy, OriginalMaterial);
 				LandscapeActorDescriptors.Remove(LandscapeProxy);
 			}
 			else
@@ -80,6 +174,8 @@ void UTextureBackupManager::AddLandscapeActor(
 			if (MaterialInstanceConstant != nullptr)
 			{
 				LandscapeActorDescriptors.Add(LandscapeProxy, MaterialInstanceConstant);
+				// Original material instances are reused when restoring, so they are always cached fresh
+				CacheLandscapeMaterialState(LandscapeProxy, MaterialInstanceConstant);
 			}
 			else
 			{
@@ -91,9 +187,7 @@ void UTextureBackupManager::AddLandscapeActor(
 			UMaterialInterface* MaterialInterface = Cast<UMaterialInterface>(Material);
 			if (MaterialInterface != nullptr)
 			{
-				LandscapeProxy->LandscapeMaterial = MaterialInterface;
-				FPropertyChangedEvent PropertyChangedEvent(FindFieldChecked<FProperty>(LandscapeProxy->GetClass(), FName("LandscapeMaterial")));
-				LandscapeProxy->PostEditChangeProperty(PropertyChangedEvent);
+				SetLandscapeMaterial(LandscapeProxy, MaterialInterface);
 			}
 			else
 			{
@@ -103,105 +197,344 @@ void UTextureBackupManager::AddLandscapeActor(
 	}
 }
 
+void UTextureBackupManager::SetLandscapeMaterial(ALandscapeProxy* LandscapeProxy, UMaterialInterface* Material)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	LandscapeProxy->LandscapeMaterial = Material;
+	const bool bRestored = RestoreLandscapeMaterialState(LandscapeProxy, Material);
+	if (!bRestored)
+	{
+		// Regenerates material instances of all proxy components
+		FPropertyChangedEvent PropertyChangedEvent(
+			FindFieldChecked<FProperty>(LandscapeProxy->GetClass(), FName("LandscapeMaterial")));
+		LandscapeProxy->PostEditChangeProperty(PropertyChangedEvent);
+		CacheLandscapeMaterialState(LandscapeProxy, Material);
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: %s material instances of '%s' in %.3f s"),
+		*FString(__FUNCTION__), bRestored ? TEXT("Reused cached") : TEXT("Rebuilt"),
+		*LandscapeProxy->GetName(), FPlatformTime::Seconds() - StartTime)
+}
+
+void UTextureBackupManager::CacheLandscapeMaterialState(ALandscapeProxy* LandscapeProxy, UMaterialInterface* Material)
+{
+	FLandscapeMaterialState& State = LandscapeMaterialStates.Add({ LandscapeProxy, Material });
+	for (ULandscapeComponent* LandscapeComponent : LandscapeProxy->LandscapeComponents)
+	{
+		if (LandscapeComponent == nullptr)
+		{
+			continue;
+		}
+		State.Components.Add(LandscapeComponent);
+		State.MaterialInstances.Add(LandscapeComponent->MaterialInstances);
+		State.LODIndexToMaterialIndex.Add(LandscapeComponent->LODIndexToMaterialIndex);
+	}
+}
+
+bool UTextureBackupManager::RestoreLandscapeMaterialState(ALandscapeProxy* LandscapeProxy, UMaterialInterface* Material)
+{
+	const FLandscapeMaterialState* State = LandscapeMaterialStates.Find({ LandscapeProxy, Material });
+	if (State == nullptr)
+	{
+		return false;
+	}
+
+	// Cached material instances can only be reused if proxy components did not change since
+	int32 StateIndex = 0;
+	for (ULandscapeComponent* LandscapeComponent : LandscapeProxy->LandscapeComponents)
+	{
+		if (LandscapeComponent == nullptr)
+		{
+			continue;
+		}
+		if (StateIndex >= State->Components.Num() || State->Components[StateIndex].Get() != LandscapeComponent)
+		{
+			return false;
+		}
+		StateIndex++;
+	}
+	if (StateIndex != State->Components.Num())
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < State->Components.Num(); i++)
+	{
+		ULandscapeComponent* LandscapeComponent = State->Components[i].Get();
+		LandscapeComponent->MaterialInstances = State->MaterialInstances[i];
+		LandscapeComponent->LODIndexToMaterialIndex = State->LODIndexToMaterialIndex[i];
+		LandscapeComponent->MarkRenderStateDirty();
+	}
+	return true;
+}
+
 void UTextureBackupManager::AddDefaultActor(
 	AActor* Actor,
 	const bool bDoAdd,
 	const bool bDoPaint,
 	UMaterialInstanceConstant* Material)
 {
-	const bool bDoRestore = (Material == nullptr);
-
-	if (bDoAdd)
+	if (bBatchingPaints)
 	{
-		OriginalActorDescriptors.Add(Actor);
+		PaintBatch.Add({ Actor, bDoAdd, bDoPaint, Material });
+		return;
 	}
-	else if (!OriginalActorDescriptors.Contains(Actor))
+
+	if (bDoAdd)
 	{
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: Actor expected but not found in OriginalActorDescriptors"),
-			*FString(__FUNCTION__))
-		return;
+		FActorMaterials ActorMaterials;
+		GatherActorMaterials(Actor, ActorMaterials);
+		BackupActor(Actor, ActorMaterials);
 	}
 
-	// Get actor mesh components
-	TArray<UActorComponent*> ActorComponents;
-	const bool bIncludeFromChildActors = true;
-	Actor->GetComponents(UPrimitiveComponent::StaticClass(), ActorComponents, bIncludeFromChildActors);
+	PaintActor(Actor, bDoPaint, Material);
+}
+
+void UTextureBackupManager::BeginPaintBatch()
+{
+	bBatchingPaints = true;
+}
 
-	// If no mesh components are found, ignore the actor
-	if (ActorComponents.Num() == 0)
+void UTextureBackupManager::EndPaintBatch()
+{
+	bBatchingPaints = false;
+	if (PaintBatch.Num() == 0)
 	{
 		return;
 	}
 
-	// Set new materials
-	for (UActorComponent* ActorComponent : ActorComponents)
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Original materials are only read while gathering, so actors are gathered in parallel
+	TArray<FActorMaterials> BatchMaterials;
+	BatchMaterials.SetNum(PaintBatch.Num());
+	ParallelFor(PaintBatch.Num(), [&](const int32 Index)
 	{
-		// Apply to each static mesh component
-		UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(ActorComponent);
-		if (PrimitiveComponent == nullptr)
+		if (PaintBatch[Index].bDoAdd)
 		{
-			UE_LOG(LogEasySynth, Error, TEXT("%s: Got null static mesh component"), *FString(__FUNCTION__))
-			return;
+			GatherActorMaterials(PaintBatch[Index].Actor, BatchMaterials[Index]);
 		}
+	});
+	const double GatherTime = FPlatformTime::Seconds();
 
-		if (bDoAdd)
-		{
-			OriginalActorDescriptors[Actor].Add(PrimitiveComponent);
-		}
-		else if (!OriginalActorDescriptors[Actor].Contains(PrimitiveComponent))
+	// Backup arrays are shared and components can only be painted on the game thread
+	for (int32 Index = 0; Index < PaintBatch.Num(); Index++)
+	{
+		const FPaintRequest& Request = PaintBatch[Index];
+		if (Request.bDoAdd)
 		{
-			UE_LOG(LogEasySynth, Warning, TEXT("%s: PrimitiveComponent expected but not found in OriginalActorDescriptors"),
-				*FString(__FUNCTION__))
-			return;
+			BackupActor(Request.Actor, BatchMaterials[Index]);
 		}
+		PaintActor(Request.Actor, Request.bDoPaint, Request.Material);
+	}
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Painted %d actors, gathering took %.2f s and painting %.2f s"),
+		*FString(__FUNCTION__), PaintBatch.Num(), GatherTime - StartTime, FPlatformTime::Seconds() - GatherTime)
+
+	PaintBatch.Empty();
+}
 
-		// Check whether number of stored materials is correct, if they are needed
-		if (!bDoAdd && bDoRestore &&
-			OriginalActorDescriptors[Actor][PrimitiveComponent].Num() != PrimitiveComponent->GetNumMaterials())
+void UTextureBackupManager::GatherActorMaterials(AActor* Actor, FActorMaterials& OutActorMaterials)
+{
+	// Get actor mesh components
+	const bool bIncludeFromChildActors = true;
+	Actor->GetComponents<UPrimitiveComponent>(OutActorMaterials.Components, bIncludeFromChildActors);
+
+	// Store all mesh component materials
+	OutActorMaterials.NumMaterials.Reserve(OutActorMaterials.Components.Num());
+	for (const UPrimitiveComponent* PrimitiveComponent : OutActorMaterials.Components)
+	{
+		const int32 NumMaterials = PrimitiveComponent->GetNumMaterials();
+		OutActorMaterials.NumMaterials.Add(NumMaterials);
+		for (int i = 0; i < NumMaterials; i++)
 		{
-			UE_LOG(LogEasySynth, Error, TEXT("%s: %d instead of %d actor's mesh component materials found"),
-				*FString(__FUNCTION__),
-				OriginalActorDescriptors[Actor][PrimitiveComponent].Num(),
-				PrimitiveComponent->GetNumMaterials())
-			return;
+			OutActorMaterials.Materials.Add(PrimitiveComponent->GetMaterial(i));
 		}
+	}
+}
+
+void UTextureBackupManager::BackupActor(AActor* Actor, const FActorMaterials& ActorMaterials)
+{
+	// Backing up an actor again replaces its previous backup
+	ReleaseActor(Actor);
 
-		// Store all mesh component materials
-		for (int i = 0; i < PrimitiveComponent->GetNumMaterials(); i++)
+	// Actors without mesh components are still added, so that they are known to be backed up
+	ActorBackupRanges.Add(Actor, { BackupComponents.Num(), ActorMaterials.Components.Num() });
+
+	int32 FirstMaterial = BackupMaterials.Num();
+	for (int32 i = 0; i < ActorMaterials.Components.Num(); i++)
+	{
+		BackupComponents.Add(ActorMaterials.Components[i]);
+		ComponentFirstMaterials.Add(FirstMaterial);
+		ComponentNumMaterials.Add(ActorMaterials.NumMaterials[i]);
+		FirstMaterial += ActorMaterials.NumMaterials[i];
+	}
+	BackupMaterials.Append(ActorMaterials.Materials);
+}
+
+void UTextureBackupManager::PaintActor(AActor* Actor, const bool bDoPaint, UMaterialInstanceConstant* Material)
+{
+	const bool bDoRestore = (Material == nullptr);
+
+	const FActorBackupRange* Range = ActorBackupRanges.Find(Actor);
+	if (Range == nullptr)
+	{
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: Actor expected but not found in ActorBackupRanges"),
+			*FString(__FUNCTION__))
+		return;
+	}
+
+	// Backed up components are painted directly, without querying the actor components again
+	if (bDoPaint)
+	{
+		const int32 EndComponent = Range->FirstComponent + Range->NumComponents;
+		for (int32 ComponentIndex = Range->FirstComponent; ComponentIndex < EndComponent; ComponentIndex++)
 		{
+			UPrimitiveComponent* PrimitiveComponent = BackupComponents[ComponentIndex].Get();
+			if (PrimitiveComponent == nullptr)
+			{
+				continue;
+			}
+
+			const int32 NumMaterials = PrimitiveComponent->GetNumMaterials();
 			if (bDoRestore)
 			{
-				// Revert to original material
-				if (bDoPaint)
+				// Check whether number of stored materials is correct
+				if (ComponentNumMaterials[ComponentIndex] != NumMaterials)
 				{
-					PrimitiveComponent->SetMaterial(i, OriginalActorDescriptors[Actor][PrimitiveComponent][i]);
+					UE_LOG(LogEasySynth, Error, TEXT("%s: %d instead of %d actor's mesh component materials found"),
+						*FString(__FUNCTION__), ComponentNumMaterials[ComponentIndex], NumMaterials)
+					continue;
 				}
+
+				// Revert to original materials
+				UMaterialInterface* const* OriginalMaterials =
+					BackupMaterials.GetData() + ComponentFirstMaterials[ComponentIndex];
+				SetComponentMaterials(PrimitiveComponent, NumMaterials,
+					[OriginalMaterials](const int32 Slot) { return OriginalMaterials[Slot]; });
 			}
 			else
 			{
 				// Change to semantic material
-				if (bDoAdd)
-				{
-					OriginalActorDescriptors[Actor][PrimitiveComponent].Add(PrimitiveComponent->GetMaterial(i));
-				}
-				if (bDoPaint)
-				{
-					UMaterialInterface* MaterialInterface = Cast<UMaterialInterface>(Material);
-					if (MaterialInterface != nullptr)
-					{
-						PrimitiveComponent->SetMaterial(i, MaterialInterface);
-					}
-					else
-					{
-						UE_LOG(LogEasySynth, Error, TEXT("%s: Failed cast to UMaterialInterface"), *FString(__FUNCTION__))
-					}
-				}
+				SetComponentMaterials(PrimitiveComponent, NumMaterials,
+					[Material](const int32 Slot) { return Material; });
 			}
 		}
 	}
 
 	if (bDoRestore)
 	{
-		OriginalActorDescriptors.Remove(Actor);
+		ReleaseActor(Actor);
+	}
+}
+
+void UTextureBackupManager::SetComponentMaterials(
+	UPrimitiveComponent* PrimitiveComponent,
+	const int32 NumMaterials,
+	TFunctionRef<UMaterialInterface*(const int32)> SlotMaterial)
+{
+	UMeshComponent* MeshComponent = Cast<UMeshComponent>(PrimitiveComponent);
+	if (MeshComponent == nullptr)
+	{
+		// Other primitives may store their materials differently, so they are set slot by slot
+		for (int i = 0; i < NumMaterials; i++)
+		{
+			PrimitiveComponent->SetMaterial(i, SlotMaterial(i));
+		}
+		return;
+	}
+
+	// SetMaterial marks the render state dirty for every slot, so the overrides are written directly instead
+	if (MeshComponent->OverrideMaterials.Num() < NumMaterials)
+	{
+		MeshComponent->OverrideMaterials.SetNumZeroed(NumMaterials);
+	}
+	bool bAnyMaterialChanged = false;
+	for (int i = 0; i < NumMaterials; i++)
+	{
+		UMaterialInterface* Material = SlotMaterial(i);
+		if (MeshComponent->OverrideMaterials[i] != Material)
+		{
+			MeshComponent->OverrideMaterials[i] = Material;
+			bAnyMaterialChanged = true;
+		}
+	}
+	if (bAnyMaterialChanged)
+	{
+		MeshComponent->MarkCachedMaterialParameterNameIndicesDirty();
+		MeshComponent->MarkRenderStateDirty();
+	}
+}
+
+void UTextureBackupManager::ReleaseActor(AActor* Actor)
+{
+	FActorBackupRange Range;
+	if (!ActorBackupRanges.RemoveAndCopyValue(Actor, Range))
+	{
+		return;
 	}
+
+	// Free the whole storage once all actors are restored, which is the case after each switch to original colors
+	if (ActorBackupRanges.Num() == 0)
+	{
+		BackupComponents.Empty();
+		ComponentFirstMaterials.Empty();
+		ComponentNumMaterials.Empty();
+		BackupMaterials.Empty();
+		NumReleasedComponents = 0;
+		return;
+	}
+
+	// Drop the references of the released range, it is reclaimed by the next compaction
+	const int32 EndComponent = Range.FirstComponent + Range.NumComponents;
+	for (int32 ComponentIndex = Range.FirstComponent; ComponentIndex < EndComponent; ComponentIndex++)
+	{
+		BackupComponents[ComponentIndex].Reset();
+		for (int32 i = 0; i < ComponentNumMaterials[ComponentIndex]; i++)
+		{
+			BackupMaterials[ComponentFirstMaterials[ComponentIndex] + i] = nullptr;
+		}
+	}
+
+	NumReleasedComponents += Range.NumComponents;
+	if (NumReleasedComponents > BackupComponents.Num() / 2)
+	{
+		CompactBackups();
+	}
+}
+
+void UTextureBackupManager::CompactBackups()
+{
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> Components;
+	TArray<int32> FirstMaterials;
+	TArray<int32> NumMaterials;
+	TArray<UMaterialInterface*> Materials;
+	const int32 NumComponents = BackupComponents.Num() - NumReleasedComponents;
+	Components.Reserve(NumComponents);
+	FirstMaterials.Reserve(NumComponents);
+	NumMaterials.Reserve(NumComponents);
+
+	for (TPair<TObjectKey<AActor>, FActorBackupRange>& Element : ActorBackupRanges)
+	{
+		FActorBackupRange& Range = Element.Value;
+		const int32 PreviousFirstComponent = Range.FirstComponent;
+		Range.FirstComponent = Components.Num();
+		for (int32 i = 0; i < Range.NumComponents; i++)
+		{
+			const int32 ComponentIndex = PreviousFirstComponent + i;
+			Components.Add(BackupComponents[ComponentIndex]);
+			FirstMaterials.Add(Materials.Num());
+			NumMaterials.Add(ComponentNumMaterials[ComponentIndex]);
+			Materials.Append(
+				BackupMaterials.GetData() + ComponentFirstMaterials[ComponentIndex],
+				ComponentNumMaterials[ComponentIndex]);
+		}
+	}
+
+	BackupComponents = MoveTemp(Components);
+	ComponentFirstMaterials = MoveTemp(FirstMaterials);
+	ComponentNumMaterials = MoveTemp(NumMaterials);
+	BackupMaterials = MoveTemp(Materials);
+	NumReleasedComponents = 0;
 }
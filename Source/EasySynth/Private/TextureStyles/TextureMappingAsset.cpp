@@ -1,3 +1,32 @@
 // Copyright (c) 2022 YDrive Inc. All rights reserved.
 
 #include "TextureStyles/TextureMappingAsset.h"
+
+
+void UTextureMappingAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	// Classes of older assets have no keys yet
+	for (TPair<FString, FSemanticClass>& Element : SemanticClasses)
+	{
+		if (Element.Value.Key == 0)
+		{
+			Element.Value.Key = NextClassKey++;
+		}
+	}
+
+	// Actors of older assets are bound to class names, bindings to missing classes are dropped
+	if (ActorClassPairs_DEPRECATED.Num() > 0)
+	{
+		ActorClassKeys.Reserve(ActorClassKeys.Num() + ActorClassPairs_DEPRECATED.Num());
+		for (const TPair<FGuid, FString>& Element : ActorClassPairs_DEPRECATED)
+		{
+			if (const FSemanticClass* SemanticClass = SemanticClasses.Find(Element.Value))
+			{
+				ActorClassKeys.Add(Element.Key, SemanticClass->Key);
+			}
+		}
+		ActorClassPairs_DEPRECATED.Empty();
+	}
+}
@@ -3,6 +3,7 @@
 #include "TextureStyles/TextureStyleManager.h"
 
 #include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
 #include "Components/StaticMeshComponent.h"
 #include "EditorAssetLibrary.h"
 #include "Engine/Selection.h"
@@ -10,21 +11,33 @@
 #include "FileHelpers.h"
 #include "HAL/FileManagerGeneric.h"
 #include "Kismet/GameplayStatics.h"
+#include "Materials/MaterialExpressionVectorParameter.h"
 #include "Materials/MaterialInstanceConstant.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopedSlowTask.h"
 #include "EngineUtils.h"
 
 #include "PathUtils.h"
 #include "Engine/StaticMeshActor.h"
 #include "TextureStyles/TextureBackupManager.h"
+#include "TextureStyles/SemanticRulesAsset.h"
 #include "TextureStyles/TextureMappingAsset.h"
 
 
 const FString UTextureStyleManager::SemanticColorParameter(TEXT("SemanticColor"));
 const FString UTextureStyleManager::UndefinedSemanticClassName(TEXT("Undefined"));
+const int32 UTextureStyleManager::MaxEncodableInstanceId = 0xFFFFFF;
+const float UTextureStyleManager::SemanticActorAddDelaySeconds = 0.2f;
+
+#define LOCTEXT_NAMESPACE "UTextureStyleManager"
 
 UTextureStyleManager::UTextureStyleManager() :
+	SemanticRulesAsset(nullptr),
 	PlainColorMaterial(DuplicateObject<UMaterial>(
 		LoadObject<UMaterial>(nullptr, *FPathUtils::PlainColorMaterialPath()), nullptr)),
+	InstanceColorMaterial(nullptr),
+	InstanceMaterialInstance(nullptr),
 	CurrentTextureStyle(ETextureStyle::COLOR),
 	TextureBackupManager(NewObject<UTextureBackupManager>()),
 	bEventsBound(false)
@@ -71,24 +84,22 @@ bool UTextureStyleManager::NewSemanticClass(
 	}
 
 	// Check collisions with existing classes
-	for (auto& Element : TextureMappingAsset->SemanticClasses)
+	const FSemanticClass* CollidingClass = TextureMappingAsset->SemanticClasses.Find(ClassName);
+	if (CollidingClass == nullptr)
 	{
-		const FSemanticClass& SemanticClass = Element.Value;
-		if (SemanticClass.Name == ClassName || SemanticClass.Color == ClassColor)
-		{
-			UE_LOG(LogEasySynth, Warning, TEXT("%s: New semantic class (%s, (%d %d %d)) colliding with existing (%s, (%d %d %d))"),
-				*FString(__FUNCTION__),
-				*ClassName, ClassColor.R, ClassColor.G, ClassColor.B,
-				*SemanticClass.Name, SemanticClass.Color.R, SemanticClass.Color.G, SemanticClass.Color.B);
-			return false;
-		}
+		const int32* CollidingClassKey = ClassKeysByColor.Find(ClassColor);
+		CollidingClass = CollidingClassKey != nullptr ? FindSemanticClass(*CollidingClassKey) : nullptr;
+	}
+	if (CollidingClass != nullptr)
+	{
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: New semantic class (%s, (%d %d %d)) colliding with existing (%s, (%d %d %d))"),
+			*FString(__FUNCTION__),
+			*ClassName, ClassColor.R, ClassColor.G, ClassColor.B,
+			*CollidingClass->Name, CollidingClass->Color.R, CollidingClass->Color.G, CollidingClass->Color.B);
+		return false;
 	}
 
-	// Crate the new class
-	FSemanticClass& NewSemanticClass = TextureMappingAsset->SemanticClasses.Add(ClassName);
-	NewSemanticClass.Name = ClassName;
-	NewSemanticClass.Color = ClassColor;
-	// The semantic class material instance will be created when it's needed
+	AddSemanticClass(ClassName, ClassColor);
 
 	if (bSaveTextureMappingAsset)
 	{
@@ -101,6 +112,64 @@ bool UTextureStyleManager::NewSemanticClass(
 	return true;
 }
 
+bool UTextureStyleManager::ImportSemanticClasses(const TArray<TPair<FString, FColor>>& Classes)
+{
+	// Validate all classes before modifying any, the undefined class is always kept
+	const FColor UndefinedClassColor = TextureMappingAsset->SemanticClasses[UndefinedSemanticClassName].Color;
+	TSet<FString> ClassNames;
+	TSet<FColor> ClassColors;
+	ClassNames.Reserve(Classes.Num());
+	ClassColors.Reserve(Classes.Num());
+	ClassColors.Add(UndefinedClassColor);
+	for (const TPair<FString, FColor>& Class : Classes)
+	{
+		if (Class.Key == UndefinedSemanticClassName)
+		{
+			continue;
+		}
+
+		bool bNameInUse = false;
+		bool bColorInUse = false;
+		ClassNames.Add(Class.Key, &bNameInUse);
+		ClassColors.Add(Class.Value, &bColorInUse);
+		if (Class.Key.Len() == 0 || bNameInUse || bColorInUse)
+		{
+			UE_LOG(LogEasySynth, Warning, TEXT("%s: Semantic class (%s, (%d %d %d)) is empty or collides with another one"),
+				*FString(__FUNCTION__), *Class.Key, Class.Value.R, Class.Value.G, Class.Value.B)
+			return false;
+		}
+	}
+
+	// Replace the existing classes, classes imported again keep their keys so that their output ids stay the same
+	TMap<FString, int32> KeptClassKeys;
+	for (const FString& ClassName : SemanticClassNames())
+	{
+		if (ClassName != UndefinedSemanticClassName)
+		{
+			if (ClassNames.Contains(ClassName))
+			{
+				KeptClassKeys.Add(ClassName, TextureMappingAsset->SemanticClasses[ClassName].Key);
+			}
+			RemoveSemanticClassUnchecked(ClassName);
+		}
+	}
+	TextureMappingAsset->SemanticClasses.Reserve(ClassNames.Num() + 1);
+	for (const TPair<FString, FColor>& Class : Classes)
+	{
+		if (Class.Key != UndefinedSemanticClassName)
+		{
+			AddSemanticClass(Class.Key, Class.Value, KeptClassKeys.FindRef(Class.Key));
+		}
+	}
+
+	SaveTextureMappingAsset();
+
+	// Broadcast the semantic classes change
+	SemanticClassesUpdatedEvent.Broadcast();
+
+	return true;
+}
+
 FColor UTextureStyleManager::ClassColor(const FString& ClassName)
 {
 	if (TextureMappingAsset->SemanticClasses.Contains(ClassName))
@@ -137,27 +206,21 @@ bool UTextureStyleManager::UpdateClassName(const FString& OldClassName, const FS
 		return false;
 	}
 
-	const FColor ClassColor = TextureMappingAsset->SemanticClasses[OldClassName].Color;
-
-	// Remove the existing class
-	TextureMappingAsset->SemanticClasses.Remove(OldClassName);
-	// Add new class with the same color
-	NewSemanticClass(NewClassName, ClassColor);
-	// Update actor mappings to the new semantic class name
-	TArray<AActor*> LevelActors;
-	UGameplayStatics::GetAllActorsOfClass(GEditor->GetEditorWorldContext().World(), AActor::StaticClass(), LevelActors);
-	for (AActor* Actor : LevelActors)
-	{
-		if (TextureMappingAsset->ActorClassPairs.Contains(Actor->GetActorGuid()) &&
-			TextureMappingAsset->ActorClassPairs[Actor->GetActorGuid()] == OldClassName)
-		{
-			TextureMappingAsset->ActorClassPairs[Actor->GetActorGuid()] = NewClassName;
-		}
-	}
+	// Move the class under the new name, keeping its key so that actor bindings stay valid
+	FSemanticClass SemanticClass;
+	TextureMappingAsset->SemanticClasses.RemoveAndCopyValue(OldClassName, SemanticClass);
+	SemanticClass.Name = NewClassName;
+	// The material instance is named after the class, it will be recreated when it's needed
+	SemanticClass.PlainColorMaterialInstance = nullptr;
+	TextureMappingAsset->SemanticClasses.Add(NewClassName, SemanticClass);
+	ClassNamesByKey.Add(SemanticClass.Key, NewClassName);
 	// No action regarding actor materials necessary
 
 	SaveTextureMappingAsset();
 
+	// Broadcast the semantic classes change
+	SemanticClassesUpdatedEvent.Broadcast();
+
 	return true;
 }
 
@@ -176,31 +239,25 @@ bool UTextureStyleManager::UpdateClassColor(const FString& ClassName, const FCol
 	}
 
 	// Check if color is already in use
-	for (auto& Element : TextureMappingAsset->SemanticClasses)
+	if (const int32* CollidingClassKey = ClassKeysByColor.Find(NewClassColor))
 	{
-		const FSemanticClass& SemanticClass = Element.Value;
-		if (SemanticClass.Color == NewClassColor)
-		{
-			UE_LOG(LogEasySynth, Warning, TEXT("%s: Requested color (%d %d %d) already used by %s"),
-				*FString(__FUNCTION__), NewClassColor.R, NewClassColor.G, NewClassColor.B, *SemanticClass.Name);
-			return false;
-		}
+		const FString* CollidingClassName = ClassNamesByKey.Find(*CollidingClassKey);
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: Requested color (%d %d %d) already used by %s"),
+			*FString(__FUNCTION__), NewClassColor.R, NewClassColor.G, NewClassColor.B,
+			CollidingClassName != nullptr ? **CollidingClassName : TEXT(""));
+		return false;
 	}
 
 	// Update the class color
+	ClassKeysByColor.Remove(TextureMappingAsset->SemanticClasses[ClassName].Color);
+	ClassKeysByColor.Add(NewClassColor, TextureMappingAsset->SemanticClasses[ClassName].Key);
 	TextureMappingAsset->SemanticClasses[ClassName].Color = NewClassColor;
 	// Invalidate the material instance
 	TextureMappingAsset->SemanticClasses[ClassName].PlainColorMaterialInstance = nullptr;
 	// Update each actor color immediately in case of the semantic view mode
-	TArray<AActor*> LevelActors;
-	UGameplayStatics::GetAllActorsOfClass(GEditor->GetEditorWorldContext().World(), AActor::StaticClass(), LevelActors);
-	for (AActor* Actor : LevelActors)
+	for (AActor* Actor : ClassActors(TextureMappingAsset->SemanticClasses[ClassName].Key))
 	{
-		if (TextureMappingAsset->ActorClassPairs.Contains(Actor->GetActorGuid()) &&
-			TextureMappingAsset->ActorClassPairs[Actor->GetActorGuid()] == ClassName)
-		{
-			SetSemanticClassToActor(Actor, ClassName);
-		}
+		SetSemanticClassToActor(Actor, ClassName);
 	}
 
 	SaveTextureMappingAsset();
@@ -223,20 +280,7 @@ bool UTextureStyleManager::RemoveSemanticClass(const FString& ClassName)
 		return true;
 	}
 
-	// Reset all actor to the undefined class
-	TArray<AActor*> LevelActors;
-	UGameplayStatics::GetAllActorsOfClass(GEditor->GetEditorWorldContext().World(), AActor::StaticClass(), LevelActors);
-	for (AActor* Actor : LevelActors)
-	{
-		if (TextureMappingAsset->ActorClassPairs.Contains(Actor->GetActorGuid()) &&
-			TextureMappingAsset->ActorClassPairs[Actor->GetActorGuid()] == ClassName)
-		{
-			SetSemanticClassToActor(Actor, UndefinedSemanticClassName);
-		}
-	}
-
-	// Remove the class
-	TextureMappingAsset->SemanticClasses.Remove(ClassName);
+	RemoveSemanticClassUnchecked(ClassName);
 
 	SaveTextureMappingAsset();
 
@@ -248,15 +292,56 @@ bool UTextureStyleManager::RemoveSemanticClass(const FString& ClassName)
 
 void UTextureStyleManager::RemoveAllSemanticCLasses()
 {
-	for (auto& Element : TextureMappingAsset->SemanticClasses)
+	// Class names are copied, as removing classes modifies the class map
+	for (const FString& ClassName : SemanticClassNames())
 	{
-		const FString& ClassName = Element.Key;
 		// Skip the default undefined semantic class
 		if (ClassName != UndefinedSemanticClassName)
 		{
-			RemoveSemanticClass(ClassName);
+			RemoveSemanticClassUnchecked(ClassName);
 		}
 	}
+
+	SaveTextureMappingAsset();
+
+	// Broadcast the semantic classes change
+	SemanticClassesUpdatedEvent.Broadcast();
+}
+
+void UTextureStyleManager::AddSemanticClass(const FString& ClassName, const FColor& ClassColor, const int32 ClassKey)
+{
+	// Crate the new class
+	FSemanticClass& NewSemanticClass = TextureMappingAsset->SemanticClasses.Add(ClassName);
+	NewSemanticClass.Name = ClassName;
+	NewSemanticClass.Color = ClassColor;
+	NewSemanticClass.Key = ClassKey > 0 ? ClassKey : TextureMappingAsset->NextClassKey++;
+	ClassNamesByKey.Add(NewSemanticClass.Key, ClassName);
+	ClassKeysByColor.Add(ClassColor, NewSemanticClass.Key);
+	// The semantic class material instance will be created when it's needed
+}
+
+void UTextureStyleManager::RemoveSemanticClassUnchecked(const FString& ClassName)
+{
+	// Reset all actor to the undefined class
+	const int32 ClassKey = TextureMappingAsset->SemanticClasses[ClassName].Key;
+	for (AActor* Actor : ClassActors(ClassKey))
+	{
+		SetSemanticClassToActor(Actor, UndefinedSemanticClassName);
+	}
+
+	// Bindings of actors outside of the current level are reset as well
+	TSet<FGuid> RemainingActorGuids;
+	ClassActorGuids.RemoveAndCopyValue(ClassKey, RemainingActorGuids);
+	const int32 UndefinedClassKey = TextureMappingAsset->SemanticClasses[UndefinedSemanticClassName].Key;
+	for (const FGuid& ActorGuid : RemainingActorGuids)
+	{
+		AssignActorClass(ActorGuid, UndefinedClassKey);
+	}
+
+	// Remove the class
+	ClassKeysByColor.Remove(TextureMappingAsset->SemanticClasses[ClassName].Color);
+	TextureMappingAsset->SemanticClasses.Remove(ClassName);
+	ClassNamesByKey.Remove(ClassKey);
 }
 
 TArray<FString> UTextureStyleManager::SemanticClassNames() const
@@ -279,117 +364,261 @@ TArray<const FSemanticClass*> UTextureStyleManager::SemanticClasses() const
 	return SemanticClasses;
 }
 
-void UTextureStyleManager::ApplySemanticClassToDataTableActors(const FMeshSemanticTableRowBase& DataTableRow)
+void UTextureStyleManager::SemanticClassIdColors(TArray<int32>& OutClassIds, TArray<FColor>& OutClassColors) const
 {
-	// To get world actors
-	TArray<UObject*> SelectedActors;
-	GEditor->GetSelectedActors()->GetSelectedObjects(AActor::StaticClass(), SelectedActors);
+	OutClassIds.Reset();
+	OutClassColors.Reset();
+	for (const FSemanticClass* SemanticClass : TextureMappingAsset->ClassesById())
+	{
+		OutClassIds.Add(SemanticClass->Key);
+		OutClassColors.Add(SemanticClass->Color);
+	}
+}
+
+TArray<FLabeledActor> UTextureStyleManager::LabeledActors() const
+{
+	TArray<FLabeledActor> Actors;
+	TArray<AActor*> LevelActors;
+	UGameplayStatics::GetAllActorsOfClass(GEditor->GetEditorWorldContext().World(), AActor::StaticClass(), LevelActors);
+	for (AActor* Actor : LevelActors)
+	{
+		// Class keys are the class ids of rendered outputs
+		const int32* ClassKey = TextureMappingAsset->ActorClassKeys.Find(Actor->GetActorGuid());
+		if (ClassKey == nullptr || !ClassNamesByKey.Contains(*ClassKey))
+		{
+			continue;
+		}
+		const int32* InstanceId = TextureMappingAsset->ActorInstanceIds.Find(Actor->GetActorGuid());
+		Actors.Add({
+			Actor,
+			static_cast<uint32>(*ClassKey),
+			InstanceId != nullptr ? static_cast<uint32>(*InstanceId) : 0u });
+	}
+	return Actors;
+}
 
-	if (SelectedActors.Num() <= 0)
+void UTextureStyleManager::ApplySemanticClassToDataTableActors(const TArray<FMeshSemanticTableRowBase*>& DataTableRows)
+{
+	// Later rows override earlier ones for the same mesh, only meshes that are loaded can be used by the level
+	TMap<const UStaticMesh*, const FString*> MeshClasses;
+	MeshClasses.Reserve(DataTableRows.Num());
+	for (const FMeshSemanticTableRowBase* DataTableRow : DataTableRows)
 	{
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: not have the selected actor!"),
-			*FString(__FUNCTION__));
-		return;
+		if (!TextureMappingAsset->SemanticClasses.Contains(DataTableRow->MeshSemantic))
+		{
+			UE_LOG(LogEasySynth, Warning, TEXT("%s: Semantic class '%s' not found"),
+				*FString(__FUNCTION__), *DataTableRow->MeshSemantic)
+			continue;
+		}
+		if (const UStaticMesh* Mesh = DataTableRow->MeshObject.Get())
+		{
+			MeshClasses.Add(Mesh, &DataTableRow->MeshSemantic);
+		}
 	}
 
-	AActor* SelectActor = Cast<AActor>(SelectedActors[0]);
-	if (!SelectActor || !SelectActor->GetWorld())
+	if (MeshClasses.Num() == 0)
 	{
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: get world failed!"),
-			*FString(__FUNCTION__));
 		return;
 	}
 
-	// get class actor
-	for (TActorIterator<AActor> ItActor(SelectedActors[0]->GetWorld()); ItActor; ++ItActor)
+	TArray<AActor*> LevelActors;
+	for (TActorIterator<AActor> ItActor(GEditor->GetEditorWorldContext().World()); ItActor; ++ItActor)
 	{
-		AActor* Actor = *ItActor;
-		for (UActorComponent* Component : Actor->GetComponents())
+		LevelActors.Add(*ItActor);
+	}
+
+	FScopedSlowTask SlowTask(
+		LevelActors.Num() + 1,
+		LOCTEXT("ApplyDataTableSlowTaskText", "Applying semantic classes from the data table"));
+	const bool bShowCancelButton = true;
+	SlowTask.MakeDialog(bShowCancelButton);
+
+	// Components are only read while matching, so actors are matched in parallel
+	// The last matching component of an actor decides its class
+	SlowTask.EnterProgressFrame(1);
+	TArray<const FString*> ActorClasses;
+	ActorClasses.Init(nullptr, LevelActors.Num());
+	ParallelFor(LevelActors.Num(), [&](const int32 Index)
+	{
+		for (const UActorComponent* Component : LevelActors[Index]->GetComponents())
 		{
-			if (Component->IsA(UStaticMeshComponent::StaticClass()))
+			const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component);
+			if (StaticMeshComponent == nullptr)
+			{
+				continue;
+			}
+			if (const FString* const* ClassName = MeshClasses.Find(StaticMeshComponent->GetStaticMesh()))
 			{
-				if(Cast<UStaticMeshComponent>(Component)->GetStaticMesh() == DataTableRow.MeshObject)
-				{
-					// Set the class to the actor
-					FString ClassName = DataTableRow.MeshSemantic;
-					SetSemanticClassToActor(Actor, ClassName);
-				}
+				ActorClasses[Index] = *ClassName;
 			}
 		}
+	});
+
+	// Materials can only be updated on the game thread, while the batch gathers the originals in parallel
+	int32 LabeledActors = 0;
+	TextureBackupManager->BeginPaintBatch();
+	for (int32 Index = 0; Index < LevelActors.Num(); Index++)
+	{
+		SlowTask.EnterProgressFrame(1);
+		if (SlowTask.ShouldCancel())
+		{
+			UE_LOG(LogEasySynth, Log, TEXT("%s: Canceled, keeping already applied classes"), *FString(__FUNCTION__))
+			break;
+		}
+		if (ActorClasses[Index] != nullptr)
+		{
+			SetSemanticClassToActor(LevelActors[Index], *ActorClasses[Index]);
+			LabeledActors++;
+		}
 	}
+	TextureBackupManager->EndPaintBatch();
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Applied classes of %d meshes to %d actors"),
+		*FString(__FUNCTION__), MeshClasses.Num(), LabeledActors)
 
 	SaveTextureMappingAsset();
 }
 
-void UTextureStyleManager::ApplySemanticClassToTagedActors()
+void UTextureStyleManager::ApplySemanticClassToTagedActors(const bool bWholeLevel)
 {
+	// Tags that name semantic classes are used
+	TSet<FName> ClassTags;
+	if (bWholeLevel)
+	{
+		for (const TPair<FString, FSemanticClass>& Element : TextureMappingAsset->SemanticClasses)
+		{
+			ClassTags.Add(FName(*Element.Key));
+		}
+	}
+	else
+	{
+		TArray<UObject*> SelectedActors;
+		GEditor->GetSelectedActors()->GetSelectedObjects(AActor::StaticClass(), SelectedActors);
 
-	TArray<UObject*> SelectedActors;
-	GEditor->GetSelectedActors()->GetSelectedObjects(AActor::StaticClass(), SelectedActors);
+		if (SelectedActors.Num() <= 0)
+		{
+			UE_LOG(LogEasySynth, Warning, TEXT("%s: not have the selected actor!"),
+				*FString(__FUNCTION__));
+			return;
+		}
+
+		AActor* SelectActor = Cast<AActor>(SelectedActors[0]);
+		if (!SelectActor || SelectActor->Tags.Num() <= 0)
+		{
+			UE_LOG(LogEasySynth, Warning, TEXT("%s: not set the selected actor's tags!"),
+				*FString(__FUNCTION__));
+			return;
+		}
+
+		for (const FName& Tag : SelectActor->Tags)
+		{
+			if (!TextureMappingAsset->SemanticClasses.Contains(Tag.ToString()))
+			{
+				UE_LOG(LogEasySynth, Warning, TEXT("%s: Received semantic class '%s' not found"),
+					*FString(__FUNCTION__), *Tag.ToString());
+				continue;
+			}
+			ClassTags.Add(Tag);
+		}
+	}
 
-	if (SelectedActors.Num() <= 0)
+	// Resolve the class of each actor in a single level traversal,
+	// actors with multiple class tags take the class of the last one in their own tag order
+	TArray<TPair<AActor*, FName>> ActorTags;
+	for (TActorIterator<AActor> ItActor(GEditor->GetEditorWorldContext().World()); ItActor; ++ItActor)
 	{
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: not have the selected actor!"),
-			*FString(__FUNCTION__));
-		return;
+		const FName* ActorClassTag = nullptr;
+		for (const FName& Tag : ItActor->Tags)
+		{
+			if (ClassTags.Contains(Tag))
+			{
+				ActorClassTag = &Tag;
+			}
+		}
+		if (ActorClassTag != nullptr)
+		{
+			ActorTags.Emplace(*ItActor, *ActorClassTag);
+		}
 	}
 
-	AActor* SelectActor = Cast<AActor>(SelectedActors[0]);
-	if (!SelectActor || !SelectActor->GetWorld())
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Setting semantic classes of %d tags to %d actors"),
+		*FString(__FUNCTION__), ClassTags.Num(), ActorTags.Num())
+
+	for (const TPair<AActor*, FName>& Element : ActorTags)
 	{
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: get world failed!"),
-			*FString(__FUNCTION__));
-		return;
+		SetSemanticClassToActor(Element.Key, Element.Value.ToString());
 	}
 
-	if (SelectActor->Tags.Num() <= 0)
+	SaveTextureMappingAsset();
+}
+
+void UTextureStyleManager::ApplySemanticRules(USemanticRulesAsset* RulesAsset)
+{
+	if (RulesAsset == nullptr)
 	{
-		UE_LOG(LogEasySynth, Warning, TEXT("%s: not set the selected actor's tags!"),
-			*FString(__FUNCTION__));
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: No semantic rules asset provided"), *FString(__FUNCTION__))
 		return;
 	}
 
+	SetSemanticRules(RulesAsset);
 
-	TArray<UObject*> TagedActors;
-	for (int TagIndex = 0; TagIndex < SelectActor->Tags.Num(); ++TagIndex)
+	TArray<AActor*> LevelActors;
+	for (TActorIterator<AActor> ItActor(GEditor->GetEditorWorldContext().World()); ItActor; ++ItActor)
 	{
-		FString ClassName = SelectActor->Tags[TagIndex].ToString();
-		if (!TextureMappingAsset->SemanticClasses.Contains(ClassName))
-		{
-			UE_LOG(LogEasySynth, Warning, TEXT("%s: Received semantic class '%s' not found"),
-				*FString(__FUNCTION__), *ClassName);
-			return;
-		}
+		LevelActors.Add(*ItActor);
+	}
 
-		UE_LOG(LogEasySynth, Log, TEXT("%s: Setting the '%s' semantic class to selected actors"),
-			*FString(__FUNCTION__), *ClassName)
+	FScopedSlowTask SlowTask(
+		LevelActors.Num() + 1,
+		LOCTEXT("ApplySemanticRulesSlowTaskText", "Applying semantic rules"));
+	const bool bShowCancelButton = true;
+	SlowTask.MakeDialog(bShowCancelButton);
+
+	// Actors are only read while matching, so all rules are evaluated in parallel
+	SlowTask.EnterProgressFrame(1);
+	TArray<const FString*> ActorClasses;
+	ActorClasses.Init(nullptr, LevelActors.Num());
+	ParallelFor(LevelActors.Num(), [&](const int32 Index)
+	{
+		ActorClasses[Index] = RulesAsset->MatchingClassName(
+			LevelActors[Index],
+			[this](const AActor* Actor, TArray<const UMaterialInterface*>& OutMaterials)
+			{
+				TextureBackupManager->OriginalActorMaterials(Actor, OutMaterials);
+			});
+	});
 
-		for (TActorIterator<AActor> ItActor(SelectedActors[0]->GetWorld()); ItActor; ++ItActor)
+	// Materials can only be updated on the game thread
+	int32 LabeledActors = 0;
+	for (int32 Index = 0; Index < LevelActors.Num(); Index++)
+	{
+		SlowTask.EnterProgressFrame(1);
+		if (SlowTask.ShouldCancel())
 		{
-			AActor* Actor = *ItActor;
-			if (Actor && Actor->ActorHasTag(SelectActor->Tags[TagIndex]))
-			{
-				TagedActors.Add(Actor);
-			}
+			UE_LOG(LogEasySynth, Log, TEXT("%s: Canceled, keeping already applied classes"), *FString(__FUNCTION__))
+			break;
 		}
-
-		for (UObject* TagedObject : TagedActors)
+		if (ActorClasses[Index] != nullptr)
 		{
-			AActor* TagedActor = Cast<AActor>(TagedObject);
-			if (TagedActor == nullptr)
-			{
-				UE_LOG(LogEasySynth, Log, TEXT("%s: Got null actor"), *FString(__FUNCTION__))
-					return;
-			}
-
-			// Set the class to the actor
-			SetSemanticClassToActor(TagedActor, ClassName);
+			SetSemanticClassToActor(LevelActors[Index], *ActorClasses[Index]);
+			LabeledActors++;
 		}
 	}
 
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Applied semantic rules to %d of %d actors"),
+		*FString(__FUNCTION__), LabeledActors, LevelActors.Num())
+
 	SaveTextureMappingAsset();
 }
 
+void UTextureStyleManager::SetSemanticRules(USemanticRulesAsset* RulesAsset)
+{
+	if (RulesAsset != nullptr)
+	{
+		RulesAsset->CompileRules(SemanticClassNames());
+	}
+	SemanticRulesAsset = RulesAsset;
+}
 
 void UTextureStyleManager::ApplySemanticClassToSelectedActors(const FString& ClassName)
 {
@@ -433,13 +662,21 @@ void UTextureStyleManager::CheckoutTextureStyle(const ETextureStyle NewTextureSt
 		return;
 	}
 
+	const double StartTime = FPlatformTime::Seconds();
+
 	// Apply materials to all actors
 	TArray<AActor*> LevelActors;
 	UGameplayStatics::GetAllActorsOfClass(GEditor->GetEditorWorldContext().World(), AActor::StaticClass(), LevelActors);
+	TextureBackupManager->BeginPaintBatch();
 	for (AActor* Actor : LevelActors)
 	{
 		CheckoutActorTexture(Actor, NewTextureStyle);
 	}
+	TextureBackupManager->EndPaintBatch();
+
+	UE_LOG(LogEasySynth, Log, TEXT("%s: Checked out %d actors in %.2f s, material backups use %.1f KiB"),
+		*FString(__FUNCTION__), LevelActors.Num(), FPlatformTime::Seconds() - StartTime,
+		TextureBackupManager->GetAllocatedSize() / 1024.0)
 
 	// Make sure any changes to the TextureMappingAsset are changed
 	SaveTextureMappingAsset();
@@ -453,6 +690,54 @@ bool UTextureStyleManager::ExportSemanticClasses(const FString& OutputDir)
 	return SemanticCsvInterface.ExportSemanticClasses(OutputDir, TextureMappingAsset);
 }
 
+bool UTextureStyleManager::ExportInstanceIds(const FString& OutputDir)
+{
+	// Assign ids to all actors that can be rendered, so that new actors get their ids before rendering starts
+	TArray<TPair<int32, FString>> Rows;
+	TArray<AActor*> LevelActors;
+	UGameplayStatics::GetAllActorsOfClass(GEditor->GetEditorWorldContext().World(), AActor::StaticClass(), LevelActors);
+	for (AActor* Actor : LevelActors)
+	{
+		if (Actor->FindComponentByClass<UPrimitiveComponent>() == nullptr)
+		{
+			continue;
+		}
+		const FGuid& ActorGuid = Actor->GetActorGuid();
+		const int32* ClassKey = TextureMappingAsset->ActorClassKeys.Find(ActorGuid);
+		const FString* ClassName = ClassKey != nullptr ? ClassNamesByKey.Find(*ClassKey) : nullptr;
+		const int32 Id = InstanceId(Actor);
+		Rows.Emplace(Id, FString::Printf(TEXT("%d,%s,%s,%s"),
+			Id,
+			*ActorGuid.ToString(EGuidFormats::DigitsWithHyphens),
+			*Actor->GetActorLabel(),
+			ClassName != nullptr ? **ClassName : *UndefinedSemanticClassName));
+	}
+	SaveTextureMappingAsset();
+
+	Rows.Sort([](const TPair<int32, FString>& A, const TPair<int32, FString>& B) { return A.Key < B.Key; });
+	TArray<FString> Lines;
+	Lines.Add("id,actor_guid,actor_name,class");
+	for (const TPair<int32, FString>& Row : Rows)
+	{
+		Lines.Add(Row.Value);
+	}
+
+	// Save the file
+	const FString SaveFilePath = FPathUtils::InstanceIdsFilePath(OutputDir);
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *SaveFilePath))
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Failed while saving the file %s"), *FString(__FUNCTION__), *SaveFilePath)
+		return false;
+	}
+
+	return true;
+}
+
+int32 UTextureStyleManager::MaxInstanceId() const
+{
+	return TextureMappingAsset->NextInstanceId - 1;
+}
+
 void UTextureStyleManager::LoadOrCreateTextureMappingAsset()
 {
 	// Try to load
@@ -483,6 +768,8 @@ void UTextureStyleManager::LoadOrCreateTextureMappingAsset()
 
 		// Don't save the asset yet to prevent crashing the editor on startup
 	}
+
+	RebuildClassIndex();
 }
 
 void UTextureStyleManager::SaveTextureMappingAsset()
@@ -494,19 +781,20 @@ void UTextureStyleManager::SaveTextureMappingAsset()
 
 void UTextureStyleManager::OnLevelActorAdded(AActor* Actor)
 {
-	UE_LOG(LogEasySynth, Log, TEXT("%s: Adding actor '%s'"), *FString(__FUNCTION__), *Actor->GetName())
+	UE_LOG(LogEasySynth, Verbose, TEXT("%s: Adding actor '%s'"), *FString(__FUNCTION__), *Actor->GetName())
 
-	// Preemptively assign the undefined semantic class to the new actor
-	// In the case of the semantic mode being selected, assigned class will be immediately displayed
-	const bool bForceDisplaySemanticClass = false;
-	const bool bDelayAddingDescriptors = true;
-	SetSemanticClassToActor(Actor, UndefinedSemanticClassName, bForceDisplaySemanticClass, bDelayAddingDescriptors);
+	// Actors spawned or pasted together are only buffered here and labeled in a single pass,
+	// instead of updating the asset and restarting the timer for each of them
+	DelayActorBuffer.Add({ Actor, FApp::GetCurrentTime() });
+	ScheduleDelayActorBuffer(ActorAddDelaySeconds());
 }
 
 void UTextureStyleManager::OnLevelActorDeleted(AActor* Actor)
 {
 	UE_LOG(LogEasySynth, Log, TEXT("%s: Removing actor '%s'"), *FString(__FUNCTION__), *Actor->GetName())
-	TextureMappingAsset->ActorClassPairs.Remove(Actor->GetActorGuid());
+	UnassignActorClass(Actor->GetActorGuid());
+	LevelActorCache.Remove(Actor->GetActorGuid());
+	TextureMappingAsset->ActorInstanceIds.Remove(Actor->GetActorGuid());
 	TextureBackupManager->RemoveActor(Actor);
 }
 
@@ -520,43 +808,128 @@ void UTextureStyleManager::OnEditorClose()
 	FEditorFileUtils::SaveLevel(Level);
 }
 
-void UTextureStyleManager::SetSemanticClassToActor(
-	AActor* Actor,
-	const FString& ClassName,
-	const bool bForceDisplaySemanticClass,
-	const bool bDelayAddingDescriptors)
+void UTextureStyleManager::AssignActorClass(const FGuid& ActorGuid, const int32 ClassKey)
 {
 	// Remove class if already assigned
-	TextureMappingAsset->ActorClassPairs.Remove(Actor->GetActorGuid());
+	UnassignActorClass(ActorGuid);
 
 	// Set the new class
-	TextureMappingAsset->ActorClassPairs.Add(Actor->GetActorGuid(), ClassName);
-
-	// Immediately display the change when in the semantic mode
-	if (CurrentTextureStyle == ETextureStyle::SEMANTIC)
-	{
-		if (bDelayAddingDescriptors)
-		{
-			// Adding with a delay is requested, add the actor to the delay buffer, start the timer,
-			// stop the current execution and the callback will handle the rest
-			DelayActorBuffer.Add(Actor);
-			const float DelaySeconds = 0.2f;
-			const bool bLoop = false;
-			GEditor->GetEditorWorldContext().World()->GetTimerManager().SetTimer(
-				DelayActorTimerHandle,
-				this,
-				&UTextureStyleManager::ProcessDelayActorBuffer,
-				DelaySeconds,
-				bLoop);
-			return;
+	TextureMappingAsset->ActorClassKeys.Add(ActorGuid, ClassKey);
+	ClassActorGuids.FindOrAdd(ClassKey).Add(ActorGuid);
+}
+
+void UTextureStyleManager::UnassignActorClass(const FGuid& ActorGuid)
+{
+	int32 ClassKey;
+	if (TextureMappingAsset->ActorClassKeys.RemoveAndCopyValue(ActorGuid, ClassKey))
+	{
+		if (TSet<FGuid>* ActorGuids = ClassActorGuids.Find(ClassKey))
+		{
+			ActorGuids->Remove(ActorGuid);
+		}
+	}
+}
+
+void UTextureStyleManager::RebuildClassIndex()
+{
+	ClassNamesByKey.Reset();
+	ClassKeysByColor.Reset();
+	for (const TPair<FString, FSemanticClass>& Element : TextureMappingAsset->SemanticClasses)
+	{
+		ClassNamesByKey.Add(Element.Value.Key, Element.Key);
+		ClassKeysByColor.Add(Element.Value.Color, Element.Value.Key);
+	}
+
+	ClassActorGuids.Reset();
+	for (const TPair<FGuid, int32>& Element : TextureMappingAsset->ActorClassKeys)
+	{
+		ClassActorGuids.FindOrAdd(Element.Value).Add(Element.Key);
+	}
+}
+
+FSemanticClass* UTextureStyleManager::FindSemanticClass(const int32 ClassKey)
+{
+	const FString* ClassName = ClassNamesByKey.Find(ClassKey);
+	return ClassName != nullptr ? TextureMappingAsset->SemanticClasses.Find(*ClassName) : nullptr;
+}
+
+TArray<AActor*> UTextureStyleManager::ClassActors(const int32 ClassKey)
+{
+	TArray<AActor*> Actors;
+	const TSet<FGuid>* ActorGuids = ClassActorGuids.Find(ClassKey);
+	if (ActorGuids == nullptr)
+	{
+		return Actors;
+	}
+
+	// Bindings may refer to actors of other levels, so the level is scanned at most once
+	bool bCacheRebuilt = false;
+	for (const FGuid& ActorGuid : *ActorGuids)
+	{
+		const TWeakObjectPtr<AActor>* CachedActor = LevelActorCache.Find(ActorGuid);
+		if ((CachedActor == nullptr || !CachedActor->IsValid()) && !bCacheRebuilt)
+		{
+			RebuildLevelActorCache();
+			bCacheRebuilt = true;
+			CachedActor = LevelActorCache.Find(ActorGuid);
 		}
+		if (CachedActor != nullptr && CachedActor->IsValid())
+		{
+			Actors.Add(CachedActor->Get());
+		}
+	}
+	return Actors;
+}
+
+void UTextureStyleManager::RebuildLevelActorCache()
+{
+	LevelActorCache.Reset();
+	for (TActorIterator<AActor> ItActor(GEditor->GetEditorWorldContext().World()); ItActor; ++ItActor)
+	{
+		LevelActorCache.Add(ItActor->GetActorGuid(), *ItActor);
 	}
+}
 
-	// No delay is requested, checkout the semantic color
-	if (bForceDisplaySemanticClass || CurrentTextureStyle == ETextureStyle::SEMANTIC)
+const FString& UTextureStyleManager::RuleClassName(const AActor* Actor) const
+{
+	// Materials are matched against the original ones, as semantic or instance colors may be displayed
+	const FString* ClassName = SemanticRulesAsset != nullptr ?
+		SemanticRulesAsset->MatchingClassName(
+			Actor,
+			[this](const AActor* MatchedActor, TArray<const UMaterialInterface*>& OutMaterials)
+			{
+				TextureBackupManager->OriginalActorMaterials(MatchedActor, OutMaterials);
+			}) :
+		nullptr;
+	// Classes removed since the rules were compiled fall back to the undefined class
+	return ClassName != nullptr && TextureMappingAsset->SemanticClasses.Contains(*ClassName) ?
+		*ClassName : UndefinedSemanticClassName;
+}
+
+void UTextureStyleManager::SetSemanticClassToActor(
+	AActor* Actor,
+	const FString& ClassName,
+	const bool bForceDisplaySemanticClass)
+{
+	const FSemanticClass* SemanticClass = TextureMappingAsset->SemanticClasses.Find(ClassName);
+	if (SemanticClass == nullptr)
+	{
+		UE_LOG(LogEasySynth, Warning, TEXT("%s: Semantic class '%s' not found"), *FString(__FUNCTION__), *ClassName)
+		return;
+	}
+
+	AssignActorClass(Actor->GetActorGuid(), SemanticClass->Key);
+	LevelActorCache.Add(Actor->GetActorGuid(), Actor);
+
+	// Immediately display the change when in the semantic or instance mode
+	if (bForceDisplaySemanticClass)
 	{
 		CheckoutActorTexture(Actor, ETextureStyle::SEMANTIC);
 	}
+	else if (CurrentTextureStyle != ETextureStyle::COLOR)
+	{
+		CheckoutActorTexture(Actor, CurrentTextureStyle);
+	}
 
 	// No need to save the TextureMappingAsset for every actor, the caller will do it
 }
@@ -565,7 +938,8 @@ void UTextureStyleManager::CheckoutActorTexture(AActor* Actor, const ETextureSty
 {
 	// Check if the actor has a semantic class assigned
 	const FGuid& ActorGuid = Actor->GetActorGuid();
-	if (!TextureMappingAsset->ActorClassPairs.Contains(ActorGuid))
+	const int32* ClassKey = TextureMappingAsset->ActorClassKeys.Find(ActorGuid);
+	if (ClassKey == nullptr)
 	{
 		if (NewTextureStyle == ETextureStyle::SEMANTIC)
 		{
@@ -573,17 +947,22 @@ void UTextureStyleManager::CheckoutActorTexture(AActor* Actor, const ETextureSty
 			// This method will be recalled by the following method
 			const bool bForceDisplaySemanticClass = true;
 			SetSemanticClassToActor(Actor, UndefinedSemanticClassName, bForceDisplaySemanticClass);
+			return;
 		}
-		return;
+		if (NewTextureStyle != ETextureStyle::INSTANCE)
+		{
+			return;
+		}
+		// Instance colors do not depend on the class, but actors with replaced materials need one to be restored
+		AssignActorClass(ActorGuid, TextureMappingAsset->SemanticClasses[UndefinedSemanticClassName].Key);
+		ClassKey = TextureMappingAsset->ActorClassKeys.Find(ActorGuid);
 	}
 
-	// Get the name of the semantic class assigned to the actor
-	const FString& ClassName = TextureMappingAsset->ActorClassPairs[ActorGuid];
-
-	// Make sure the semantic class name is valid
-	if (!TextureMappingAsset->SemanticClasses.Contains(ClassName))
+	// Get the semantic class assigned to the actor and make sure it is valid
+	FSemanticClass* SemanticClass = FindSemanticClass(*ClassKey);
+	if (SemanticClass == nullptr)
 	{
-		UE_LOG(LogEasySynth, Error, TEXT("%s: Uknown class name '%s'"), *FString(__FUNCTION__), *ClassName)
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Uknown class key %d"), *FString(__FUNCTION__), *ClassKey)
 		return;
 	}
 
@@ -603,28 +982,89 @@ void UTextureStyleManager::CheckoutActorTexture(AActor* Actor, const ETextureSty
 	UMaterialInstanceConstant* Material = nullptr;
 	if (NewTextureStyle == ETextureStyle::SEMANTIC)
 	{
-		Material = GetSemanticClassMaterial(TextureMappingAsset->SemanticClasses[ClassName]);
+		Material = GetSemanticClassMaterial(*SemanticClass);
+	}
+	else if (NewTextureStyle == ETextureStyle::INSTANCE)
+	{
+		Material = GetInstanceMaterial();
 	}
 	TextureBackupManager->AddAndPaint(Actor, bDoAdd, bDoPaint, Material);
+
+	// Instance colors are stored per component, while the material is shared
+	if (NewTextureStyle == ETextureStyle::INSTANCE || CurrentTextureStyle == ETextureStyle::INSTANCE)
+	{
+		SetActorInstanceColor(Actor, NewTextureStyle == ETextureStyle::INSTANCE);
+	}
 }
 
 void UTextureStyleManager::ProcessDelayActorBuffer()
 {
-	bool bAnyActorProcessed = false;
-	for (AActor* Actor : DelayActorBuffer)
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Actors are buffered in the order they were added, so the ones that waited long enough come first
+	const double DelaySeconds = ActorAddDelaySeconds();
+	const double CurrentTime = FApp::GetCurrentTime();
+	int32 NumReady = 0;
+	while (NumReady < DelayActorBuffer.Num() &&
+		DelayActorBuffer[NumReady].AddedTime + DelaySeconds <= CurrentTime + KINDA_SMALL_NUMBER)
+	{
+		NumReady++;
+	}
+
+	int32 NumProcessed = 0;
+	for (int32 Index = 0; Index < NumReady; Index++)
 	{
+		AActor* Actor = DelayActorBuffer[Index].Actor.Get();
 		if (IsValid(Actor))
 		{
-			// Must not call with bDelayAddingDescriptors = true, to avoid infinite recursion
-			SetSemanticClassToActor(Actor, UndefinedSemanticClassName);
-			bAnyActorProcessed = true;
+			// Rules are matched now, as labels and folders of just spawned actors may have changed since
+			SetSemanticClassToActor(Actor, RuleClassName(Actor));
+			NumProcessed++;
 		}
 	}
-	DelayActorBuffer.Empty();
-	if (bAnyActorProcessed)
+	const bool bAllowShrinking = false;
+	DelayActorBuffer.RemoveAt(0, NumReady, bAllowShrinking);
+
+	if (NumProcessed > 0)
 	{
 		SaveTextureMappingAsset();
+		UE_LOG(LogEasySynth, Log, TEXT("%s: Set semantic classes to %d added actors in %.2f ms"),
+			*FString(__FUNCTION__), NumProcessed, (FPlatformTime::Seconds() - StartTime) * 1000.0)
+	}
+
+	// Actors added after the timer was started wait for the rest of their delay
+	if (DelayActorBuffer.Num() > 0)
+	{
+		ScheduleDelayActorBuffer(DelayActorBuffer[0].AddedTime + DelaySeconds - CurrentTime);
+	}
+	else
+	{
+		DelayActorBuffer.Empty();
+	}
+}
+
+void UTextureStyleManager::ScheduleDelayActorBuffer(const float DelaySeconds)
+{
+	FTimerManager& TimerManager = GEditor->GetEditorWorldContext().World()->GetTimerManager();
+	if (TimerManager.IsTimerActive(DelayActorTimerHandle))
+	{
+		return;
 	}
+
+	// Timers with non-positive delays are cleared, so the shortest delay fires on the next tick
+	const bool bLoop = false;
+	TimerManager.SetTimer(
+		DelayActorTimerHandle,
+		this,
+		&UTextureStyleManager::ProcessDelayActorBuffer,
+		FMath::Max(DelaySeconds, KINDA_SMALL_NUMBER),
+		bLoop);
+}
+
+float UTextureStyleManager::ActorAddDelaySeconds() const
+{
+	// Original textures are not touched, so classes can be set on the next tick
+	return CurrentTextureStyle == ETextureStyle::COLOR ? 0.0f : SemanticActorAddDelaySeconds;
 }
 
 UMaterialInstanceConstant* UTextureStyleManager::GetSemanticClassMaterial(FSemanticClass& SemanticClass)
@@ -660,3 +1100,98 @@ UMaterialInstanceConstant* UTextureStyleManager::GetSemanticClassMaterial(FSeman
 
 	return SemanticClass.PlainColorMaterialInstance;
 }
+
+int32 UTextureStyleManager::InstanceId(AActor* Actor)
+{
+	const FGuid& ActorGuid = Actor->GetActorGuid();
+	if (const int32* Id = TextureMappingAsset->ActorInstanceIds.Find(ActorGuid))
+	{
+		return *Id;
+	}
+
+	if (TextureMappingAsset->NextInstanceId > MaxEncodableInstanceId)
+	{
+		UE_LOG(LogEasySynth, Error, TEXT("%s: Out of instance ids, actor '%s' will not be distinguishable"),
+			*FString(__FUNCTION__), *Actor->GetName())
+		return 0;
+	}
+
+	// No need to save the TextureMappingAsset for every actor, the caller will do it
+	const int32 Id = TextureMappingAsset->NextInstanceId++;
+	TextureMappingAsset->ActorInstanceIds.Add(ActorGuid, Id);
+	return Id;
+}
+
+void UTextureStyleManager::SetActorInstanceColor(AActor* Actor, const bool bShowInstanceId)
+{
+	// The 24-bit id is split into 8-bit color channels, converted the same way as semantic class colors
+	const int32 Id = bShowInstanceId ? InstanceId(Actor) : 0;
+	const FLinearColor IdColor(FColor(
+		static_cast<uint8>(Id >> 16),
+		static_cast<uint8>(Id >> 8),
+		static_cast<uint8>(Id)));
+
+	TArray<UPrimitiveComponent*> PrimitiveComponents;
+	Actor->GetComponents<UPrimitiveComponent>(PrimitiveComponents);
+	for (UPrimitiveComponent* PrimitiveComponent : PrimitiveComponents)
+	{
+		if (bShowInstanceId)
+		{
+			PrimitiveComponent->SetCustomPrimitiveDataVector3(0, FVector(IdColor.R, IdColor.G, IdColor.B));
+		}
+		else
+		{
+			// Custom primitive data set at runtime is transient, restore the values the component was saved with
+			const TArray<float>& DefaultData = PrimitiveComponent->GetDefaultCustomPrimitiveData().Data;
+			for (int32 i = 0; i < 3; i++)
+			{
+				PrimitiveComponent->SetCustomPrimitiveDataFloat(i, DefaultData.IsValidIndex(i) ? DefaultData[i] : 0.0f);
+			}
+		}
+	}
+}
+
+UMaterialInstanceConstant* UTextureStyleManager::GetInstanceMaterial()
+{
+	if (InstanceMaterialInstance == nullptr)
+	{
+		// Make the color parameter read from the custom primitive data of each component
+		InstanceColorMaterial = DuplicateObject<UMaterial>(PlainColorMaterial, nullptr);
+		for (UMaterialExpression* Expression : InstanceColorMaterial->GetExpressions())
+		{
+			UMaterialExpressionVectorParameter* VectorParameter = Cast<UMaterialExpressionVectorParameter>(Expression);
+			if (VectorParameter != nullptr && VectorParameter->ParameterName == *SemanticColorParameter)
+			{
+				VectorParameter->bUseCustomPrimitiveData = true;
+				VectorParameter->PrimitiveDataIndex = 0;
+			}
+		}
+		InstanceColorMaterial->PostEditChange();
+
+		UMaterialInstanceConstantFactoryNew* Factory = NewObject<UMaterialInstanceConstantFactoryNew>();
+		Factory->InitialParent = InstanceColorMaterial;
+
+		const FString PackageFileName(TEXT("M_InstanceIds"));
+		const FString PackagePath =
+			FPathUtils::ProjectPluginContentDir() / FString(TEXT("ConstMaterials")) / PackageFileName;
+		UPackage* Package = CreatePackage(*PackagePath);
+		InstanceMaterialInstance = Cast<UMaterialInstanceConstant>(Factory->FactoryCreateNew(
+			UMaterialInstanceConstant::StaticClass(),
+			Package,
+			*PackageFileName,
+			RF_Public | RF_Transient,
+			NULL,
+			GWarn));
+
+		if (InstanceMaterialInstance == nullptr)
+		{
+			UE_LOG(LogEasySynth, Error, TEXT("%s: Could not create the instance material instance"),
+				*FString(__FUNCTION__))
+			check(InstanceMaterialInstance)
+		}
+	}
+
+	return InstanceMaterialInstance;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -7,10 +7,12 @@
 #include "Widgets/Docking/SDockTab.h"
 #include "Widgets/Input/SDirectoryPicker.h"
 #include "Widgets/Input/SSpinBox.h"
+#include "Widgets/Layout/SBox.h"
 #include "Widgets/Layout/SScrollBox.h"
 #include "Widgets/Layout/SSeparator.h"
 #include "Widgets/Text/STextBlock.h"
 
+#include "TextureStyles/SemanticRulesAsset.h"
 #include "Widgets/WidgetStateAsset.h"
 
 
@@ -77,6 +79,7 @@ TSharedRef<SDockTab> FWidgetManager::OnSpawnPluginTab(const FSpawnTabArgs& Spawn
 	TargetCheckBoxNames.Add(FRendererTargetOptions::NORMAL_IMAGE, LOCTEXT("NormalImagesCheckBoxText", "Normal images"));
 	TargetCheckBoxNames.Add(FRendererTargetOptions::OPTICAL_FLOW_IMAGE, LOCTEXT("OpticalFlowImagesCheckBoxText", "Optical flow images"));
 	TargetCheckBoxNames.Add(FRendererTargetOptions::SEMANTIC_IMAGE, LOCTEXT("SemanticImagesCheckBoxText", "Semantic images"));
+	TargetCheckBoxNames.Add(FRendererTargetOptions::INSTANCE_IMAGE, LOCTEXT("InstanceImagesCheckBoxText", "Instance images"));
 	for (auto Element : TargetCheckBoxNames)
 	{
 		const FRendererTargetOptions::TargetType TargetType = Element.Key;
@@ -112,6 +115,230 @@ TSharedRef<SDockTab> FWidgetManager::OnSpawnPluginTab(const FSpawnTabArgs& Spawn
 			];
 	}
 
+	// Options of the selected output formats
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SHorizontalBox)
+			+SHorizontalBox::Slot()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("ExrTileSizeText", "EXR tile size, 0 for scanlines"))
+			]
+			+SHorizontalBox::Slot()
+			[
+				SNew(SSpinBox<int32>)
+				.MinValue(0)
+				.MaxValue(1024)
+				.Value_Raw(&SequenceRendererTargets, &FRendererTargetOptions::ExrTileSize)
+				.OnValueChanged_Raw(&SequenceRendererTargets, &FRendererTargetOptions::SetExrTileSize)
+			]
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("ExrMipLevelsCheckBoxText", "EXR mip levels of tiled files"),
+				&FRendererTargetOptions::ExrMipLevels,
+				&FRendererTargetOptions::SetExrMipLevels)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("CombineExrTargetsCheckBoxText", "Combine EXR targets"),
+				&FRendererTargetOptions::CombineExrTargets,
+				&FRendererTargetOptions::SetCombineExrTargets)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("EmbedFrameMetadataCheckBoxText", "Embed frame metadata"),
+				&FRendererTargetOptions::EmbedFrameMetadata,
+				&FRendererTargetOptions::SetEmbedFrameMetadata)
+		];
+
+	// Options of the semantic target
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("SemanticClassIdsCheckBoxText", "Semantic class id images"),
+				&FRendererTargetOptions::SemanticClassIds,
+				&FRendererTargetOptions::SetSemanticClassIds)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("SnapSemanticColorsCheckBoxText", "Snap semantic colors"),
+				&FRendererTargetOptions::SnapSemanticColors,
+				&FRendererTargetOptions::SetSnapSemanticColors)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("ExportMaskAnnotationsCheckBoxText", "Export mask annotations"),
+				&FRendererTargetOptions::ExportMaskAnnotations,
+				&FRendererTargetOptions::SetExportMaskAnnotations)
+		];
+
+	// Options of the camera outputs
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("ExportBoundingBoxesCheckBoxText", "Export bounding boxes"),
+				&FRendererTargetOptions::ExportBoundingBoxes,
+				&FRendererTargetOptions::SetExportBoundingBoxes)
+		];
+
+	// Outputs derived from depth images
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("OpticalFlowFromDepthCheckBoxText", "Optical flow from depth"),
+				&FRendererTargetOptions::OpticalFlowFromDepth,
+				&FRendererTargetOptions::SetOpticalFlowFromDepth)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SBox)
+			.IsEnabled_Raw(this, &FWidgetManager::GetIsOcclusionMasksEnabled)
+			[
+				OptionCheckBox(
+					LOCTEXT("ExportOcclusionMasksCheckBoxText", "Export occlusion masks"),
+					&FRendererTargetOptions::ExportOcclusionMasks,
+					&FRendererTargetOptions::SetExportOcclusionMasks)
+			]
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("ExportPointCloudsCheckBoxText", "Export point clouds"),
+				&FRendererTargetOptions::ExportPointClouds,
+				&FRendererTargetOptions::SetExportPointClouds)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("PointCloudsAsNpyCheckBoxText", "Point clouds as npy"),
+				&FRendererTargetOptions::PointCloudsAsNpy,
+				&FRendererTargetOptions::SetPointCloudsAsNpy)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("MergeRigPointCloudsCheckBoxText", "Merge rig point clouds"),
+				&FRendererTargetOptions::MergeRigPointClouds,
+				&FRendererTargetOptions::SetMergeRigPointClouds)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			OptionCheckBox(
+				LOCTEXT("ExportLidarCheckBoxText", "Export LiDAR sweeps"),
+				&FRendererTargetOptions::ExportLidar,
+				&FRendererTargetOptions::SetExportLidar)
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SHorizontalBox)
+			+SHorizontalBox::Slot()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("LidarChannelsText", "LiDAR channels"))
+			]
+			+SHorizontalBox::Slot()
+			[
+				SNew(SSpinBox<int32>)
+				.MinValue(1)
+				.MaxValue(256)
+				.Value_Raw(&SequenceRendererTargets, &FRendererTargetOptions::LidarChannels)
+				.OnValueChanged_Raw(&SequenceRendererTargets, &FRendererTargetOptions::SetLidarChannels)
+			]
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SHorizontalBox)
+			+SHorizontalBox::Slot()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("LidarUpperFovDegreesText", "LiDAR upper FOV degrees"))
+			]
+			+SHorizontalBox::Slot()
+			[
+				SNew(SSpinBox<float>)
+				.MinValue(-90.0f)
+				.MaxValue(90.0f)
+				.Value_Raw(&SequenceRendererTargets, &FRendererTargetOptions::LidarUpperFovDegrees)
+				.OnValueChanged_Raw(&SequenceRendererTargets, &FRendererTargetOptions::SetLidarUpperFovDegrees)
+			]
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SHorizontalBox)
+			+SHorizontalBox::Slot()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("LidarLowerFovDegreesText", "LiDAR lower FOV degrees"))
+			]
+			+SHorizontalBox::Slot()
+			[
+				SNew(SSpinBox<float>)
+				.MinValue(-90.0f)
+				.MaxValue(90.0f)
+				.Value_Raw(&SequenceRendererTargets, &FRendererTargetOptions::LidarLowerFovDegrees)
+				.OnValueChanged_Raw(&SequenceRendererTargets, &FRendererTargetOptions::SetLidarLowerFovDegrees)
+			]
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SHorizontalBox)
+			+SHorizontalBox::Slot()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("LidarAzimuthResolutionDegreesText", "LiDAR azimuth resolution degrees"))
+			]
+			+SHorizontalBox::Slot()
+			[
+				SNew(SSpinBox<float>)
+				.MinValue(0.01f)
+				.MaxValue(10.0f)
+				.Value_Raw(&SequenceRendererTargets, &FRendererTargetOptions::LidarAzimuthResolutionDegrees)
+				.OnValueChanged_Raw(&SequenceRendererTargets, &FRendererTargetOptions::SetLidarAzimuthResolutionDegrees)
+			]
+		];
+	TargetsScrollBoxes->AddSlot()
+		.Padding(2)
+		[
+			SNew(SHorizontalBox)
+			+SHorizontalBox::Slot()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("LidarMaxRangeMetersText", "LiDAR max range meters"))
+			]
+			+SHorizontalBox::Slot()
+			[
+				SNew(SSpinBox<float>)
+				.MinValue(1.0f)
+				.MaxValue(1000.0f)
+				.Value_Raw(&SequenceRendererTargets, &FRendererTargetOptions::LidarMaxRangeMeters)
+				.OnValueChanged_Raw(&SequenceRendererTargets, &FRendererTargetOptions::SetLidarMaxRangeMeters)
+			]
+		];
+
 	// Generate the UI
 	return SNew(SDockTab)
 		.TabRole(ETabRole::NomadTab)
@@ -145,6 +372,17 @@ TSharedRef<SDockTab> FWidgetManager::OnSpawnPluginTab(const FSpawnTabArgs& Spawn
 					.Text(LOCTEXT("PickSemanticByTagsButtonText", "Pick semantic by tags"))
 				]
 			]
+			+SScrollBox::Slot()
+			.Padding(2)
+			[
+				SNew(SButton)
+				.OnClicked_Raw(this, &FWidgetManager::OnPickLevelSemanticByTagsClicked)
+				.Content()
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("PickLevelSemanticByTagsButtonText", "Pick semantic by tags in the whole level"))
+				]
+			]
 			+ SScrollBox::Slot()
 			.Padding(2)
 			[
@@ -169,6 +407,28 @@ TSharedRef<SDockTab> FWidgetManager::OnSpawnPluginTab(const FSpawnTabArgs& Spawn
 			]
 			+SScrollBox::Slot()
 			.Padding(2)
+			[
+				SNew(SObjectPropertyEntryBox)
+					.AllowedClass(USemanticRulesAsset::StaticClass())
+					.ObjectPath_Raw(this, &FWidgetManager::GetSemanticRulesPath)
+					.OnObjectChanged_Raw(this, &FWidgetManager::OnSemanticRulesSelected)
+					.AllowClear(true)
+					.DisplayUseSelected(true)
+					.DisplayBrowse(true)
+			]
+			+SScrollBox::Slot()
+			.Padding(2)
+			[
+				SNew(SButton)
+				.OnClicked_Raw(this, &FWidgetManager::OnApplySemanticRulesClicked)
+				.Content()
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("ApplySemanticRulesButtonText", "Apply semantic rules"))
+				]
+			]
+			+SScrollBox::Slot()
+			.Padding(2)
 			[
 				SAssignNew(SemanticClassComboBox, SComboBox<TSharedPtr<FString>>)
 				.OptionsSource(&SemanticClassNames)
@@ -199,6 +459,39 @@ TSharedRef<SDockTab> FWidgetManager::OnSpawnPluginTab(const FSpawnTabArgs& Spawn
 					.Text(LOCTEXT("PickMeshTextureStyleComboBoxText", "Pick a mesh texture style"))
 				]
 			]
+			+SScrollBox::Slot()
+			.Padding(0, 2, 0, 2)
+			[
+				SNew(SSeparator)
+			]
+			+SScrollBox::Slot()
+			.Padding(2)
+			[
+				SNew(SObjectPropertyEntryBox)
+					.AllowedClass(ULevelSequence::StaticClass())
+					.ObjectPath_Raw(this, &FWidgetManager::GetSequencerPath)
+					.OnObjectChanged_Raw(this, &FWidgetManager::OnSequencerSelected)
+					.AllowClear(true)
+					.DisplayUseSelected(true)
+					.DisplayBrowse(true)
+			]
+			+SScrollBox::Slot()
+			.Padding(2)
+			[
+				TargetsScrollBoxes
+			]
+			+SScrollBox::Slot()
+			.Padding(2)
+			[
+				SNew(SButton)
+				.IsEnabled_Raw(this, &FWidgetManager::GetIsRenderImagesEnabled)
+				.OnClicked_Raw(this, &FWidgetManager::OnRenderImagesClicked)
+				.Content()
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("RenderImagesButtonText", "Render Images"))
+				]
+			]
 		];
 }
 
@@ -255,6 +548,15 @@ FString FWidgetManager::GetDataTablePath() const
 	return "";
 }
 
+FString FWidgetManager::GetSemanticRulesPath() const
+{
+	if (SemanticRulesAssetData.IsValid())
+	{
+		return SemanticRulesAssetData.ObjectPath.ToString();
+	}
+	return "";
+}
+
 ECheckBoxState FWidgetManager::RenderTargetsCheckedState(const FRendererTargetOptions::TargetType TargetType) const
 {
 	const bool bChecked = SequenceRendererTargets.TargetSelected(TargetType);
@@ -316,6 +618,38 @@ FText FWidgetManager::SelectedOutputFormat(const FRendererTargetOptions::TargetT
 	}
 }
 
+ECheckBoxState FWidgetManager::OptionCheckedState(bool (FRendererTargetOptions::*OptionGetter)() const) const
+{
+	const bool bChecked = (SequenceRendererTargets.*OptionGetter)();
+	return bChecked ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
+void FWidgetManager::OnOptionChanged(
+	ECheckBoxState NewState,
+	void (FRendererTargetOptions::*OptionSetter)(const bool))
+{
+	(SequenceRendererTargets.*OptionSetter)(NewState == ECheckBoxState::Checked);
+}
+
+TSharedRef<SWidget> FWidgetManager::OptionCheckBox(
+	const FText& CheckBoxText,
+	bool (FRendererTargetOptions::*OptionGetter)() const,
+	void (FRendererTargetOptions::*OptionSetter)(const bool))
+{
+	return SNew(SCheckBox)
+		.IsChecked_Raw(this, &FWidgetManager::OptionCheckedState, OptionGetter)
+		.OnCheckStateChanged_Raw(this, &FWidgetManager::OnOptionChanged, OptionSetter)
+		[
+			SNew(STextBlock)
+			.Text(CheckBoxText)
+		];
+}
+
+bool FWidgetManager::GetIsOcclusionMasksEnabled() const
+{
+	return SequenceRendererTargets.DerivedOpticalFlowOutput();
+}
+
 bool FWidgetManager::GetIsRenderImagesEnabled() const
 {
 	return
@@ -334,6 +668,16 @@ FReply FWidgetManager::OnPickSemanticByTagsClicked()
 	return FReply::Handled();
 }
 
+FReply FWidgetManager::OnPickLevelSemanticByTagsClicked()
+{
+	UE_LOG(LogEasySynth, Log, TEXT("%s: pick level tags button clicked"), *FString(__FUNCTION__))
+	const bool bWholeLevel = true;
+	TextureStyleManager->ApplySemanticClassToTagedActors(bWholeLevel);
+	SemanticClassComboBox->ClearSelection();
+
+	return FReply::Handled();
+}
+
 FReply FWidgetManager::OnPickSemanticByDataTableClicked()
 {
 	UE_LOG(LogEasySynth, Log, TEXT("%s: pick data table button clicked"), *FString(__FUNCTION__))
@@ -347,16 +691,25 @@ FReply FWidgetManager::OnPickSemanticByDataTableClicked()
 		TArray<FMeshSemanticTableRowBase*> MeshSemanticTableRows;
 		CurrDataTable->GetAllRows(ContextString, MeshSemanticTableRows);
 
-		for (const FMeshSemanticTableRowBase* MeshSemanticRow : MeshSemanticTableRows)
-		{
-			TextureStyleManager->ApplySemanticClassToDataTableActors(*MeshSemanticRow);
-		}
+		TextureStyleManager->ApplySemanticClassToDataTableActors(MeshSemanticTableRows);
 	}
 	SemanticClassComboBox->ClearSelection();
 
 	return FReply::Handled();
 }
 
+FReply FWidgetManager::OnApplySemanticRulesClicked()
+{
+	UE_LOG(LogEasySynth, Log, TEXT("%s: apply semantic rules button clicked"), *FString(__FUNCTION__))
+	TextureStyleManager->ApplySemanticRules(Cast<USemanticRulesAsset>(SemanticRulesAssetData.GetAsset()));
+	SemanticClassComboBox->ClearSelection();
+
+	// Save the applied rules, so that they keep labeling new actors after an editor restart
+	SaveWidgetOptionStates();
+
+	return FReply::Handled();
+}
+
 
 
 FReply FWidgetManager::OnRenderImagesClicked()
@@ -436,12 +789,15 @@ void FWidgetManager::LoadWidgetOptionStates()
 
 		// Initialize the widget members using loaded options
 		LevelSequenceAssetData = FAssetData(WidgetStateAsset->LevelSequenceAssetPath.TryLoad());
+		SemanticRulesAssetData = FAssetData(WidgetStateAsset->SemanticRulesAssetPath.TryLoad());
+		TextureStyleManager->SetSemanticRules(Cast<USemanticRulesAsset>(SemanticRulesAssetData.GetAsset()));
 		SequenceRendererTargets.SetExportCameraPoses(WidgetStateAsset->bCameraPosesSelected);
 		SequenceRendererTargets.SetSelectedTarget(FRendererTargetOptions::COLOR_IMAGE, WidgetStateAsset->bColorImagesSelected);
 		SequenceRendererTargets.SetSelectedTarget(FRendererTargetOptions::DEPTH_IMAGE, WidgetStateAsset->bDepthImagesSelected);
 		SequenceRendererTargets.SetSelectedTarget(FRendererTargetOptions::NORMAL_IMAGE, WidgetStateAsset->bNormalImagesSelected);
 		SequenceRendererTargets.SetSelectedTarget(FRendererTargetOptions::OPTICAL_FLOW_IMAGE, WidgetStateAsset->bOpticalFlowImagesSelected);
 		SequenceRendererTargets.SetSelectedTarget(FRendererTargetOptions::SEMANTIC_IMAGE, WidgetStateAsset->bSemanticImagesSelected);
+		SequenceRendererTargets.SetSelectedTarget(FRendererTargetOptions::INSTANCE_IMAGE, WidgetStateAsset->bInstanceImagesSelected);
 		SequenceRendererTargets.SetOutputFormat(
 			FRendererTargetOptions::COLOR_IMAGE,
 			static_cast<EImageFormat>(WidgetStateAsset->bColorImagesOutputFormat));
@@ -457,9 +813,31 @@ void FWidgetManager::LoadWidgetOptionStates()
 		SequenceRendererTargets.SetOutputFormat(
 			FRendererTargetOptions::SEMANTIC_IMAGE,
 			static_cast<EImageFormat>(WidgetStateAsset->bSemanticImagesOutputFormat));
+		SequenceRendererTargets.SetOutputFormat(
+			FRendererTargetOptions::INSTANCE_IMAGE,
+			static_cast<EImageFormat>(WidgetStateAsset->bInstanceImagesOutputFormat));
 		OutputImageResolution = WidgetStateAsset->OutputImageResolution;
 		SequenceRendererTargets.SetDepthRangeMeters(WidgetStateAsset->DepthRange);
 		SequenceRendererTargets.SetOpticalFlowScale(WidgetStateAsset->OpticalFlowScale);
+		SequenceRendererTargets.SetExrTileSize(WidgetStateAsset->ExrTileSize);
+		SequenceRendererTargets.SetExrMipLevels(WidgetStateAsset->bExrMipLevels);
+		SequenceRendererTargets.SetCombineExrTargets(WidgetStateAsset->bCombineExrTargets);
+		SequenceRendererTargets.SetEmbedFrameMetadata(WidgetStateAsset->bEmbedFrameMetadata);
+		SequenceRendererTargets.SetSemanticClassIds(WidgetStateAsset->bSemanticClassIds);
+		SequenceRendererTargets.SetSnapSemanticColors(WidgetStateAsset->bSnapSemanticColors);
+		SequenceRendererTargets.SetExportMaskAnnotations(WidgetStateAsset->bExportMaskAnnotations);
+		SequenceRendererTargets.SetExportBoundingBoxes(WidgetStateAsset->bExportBoundingBoxes);
+		SequenceRendererTargets.SetOpticalFlowFromDepth(WidgetStateAsset->bOpticalFlowFromDepth);
+		SequenceRendererTargets.SetExportOcclusionMasks(WidgetStateAsset->bExportOcclusionMasks);
+		SequenceRendererTargets.SetExportPointClouds(WidgetStateAsset->bExportPointClouds);
+		SequenceRendererTargets.SetPointCloudsAsNpy(WidgetStateAsset->bPointCloudsAsNpy);
+		SequenceRendererTargets.SetMergeRigPointClouds(WidgetStateAsset->bMergeRigPointClouds);
+		SequenceRendererTargets.SetExportLidar(WidgetStateAsset->bExportLidar);
+		SequenceRendererTargets.SetLidarChannels(WidgetStateAsset->LidarChannels);
+		SequenceRendererTargets.SetLidarUpperFovDegrees(WidgetStateAsset->LidarUpperFovDegrees);
+		SequenceRendererTargets.SetLidarLowerFovDegrees(WidgetStateAsset->LidarLowerFovDegrees);
+		SequenceRendererTargets.SetLidarAzimuthResolutionDegrees(WidgetStateAsset->LidarAzimuthResolutionDegrees);
+		SequenceRendererTargets.SetLidarMaxRangeMeters(WidgetStateAsset->LidarMaxRangeMeters);
 		OutputDirectory = WidgetStateAsset->OutputDirectory;
 	}
 }
@@ -491,12 +869,14 @@ void FWidgetManager::SaveWidgetOptionStates()
 
 	// Update asset values
 	WidgetStateAsset->LevelSequenceAssetPath = LevelSequenceAssetData.ToSoftObjectPath();
+	WidgetStateAsset->SemanticRulesAssetPath = FSoftObjectPath(TextureStyleManager->SemanticRules());
 	WidgetStateAsset->bCameraPosesSelected = SequenceRendererTargets.ExportCameraPoses();
 	WidgetStateAsset->bColorImagesSelected = SequenceRendererTargets.TargetSelected(FRendererTargetOptions::COLOR_IMAGE);
 	WidgetStateAsset->bDepthImagesSelected = SequenceRendererTargets.TargetSelected(FRendererTargetOptions::DEPTH_IMAGE);
 	WidgetStateAsset->bNormalImagesSelected = SequenceRendererTargets.TargetSelected(FRendererTargetOptions::NORMAL_IMAGE);
 	WidgetStateAsset->bOpticalFlowImagesSelected = SequenceRendererTargets.TargetSelected(FRendererTargetOptions::OPTICAL_FLOW_IMAGE);
 	WidgetStateAsset->bSemanticImagesSelected = SequenceRendererTargets.TargetSelected(FRendererTargetOptions::SEMANTIC_IMAGE);
+	WidgetStateAsset->bInstanceImagesSelected = SequenceRendererTargets.TargetSelected(FRendererTargetOptions::INSTANCE_IMAGE);
 	WidgetStateAsset->bColorImagesOutputFormat = static_cast<int8>(
 		SequenceRendererTargets.OutputFormat(FRendererTargetOptions::COLOR_IMAGE));
 	WidgetStateAsset->bDepthImagesOutputFormat = static_cast<int8>(
@@ -507,9 +887,30 @@ void FWidgetManager::SaveWidgetOptionStates()
 		SequenceRendererTargets.OutputFormat(FRendererTargetOptions::OPTICAL_FLOW_IMAGE));
 	WidgetStateAsset->bSemanticImagesOutputFormat = static_cast<int8>(
 		SequenceRendererTargets.OutputFormat(FRendererTargetOptions::SEMANTIC_IMAGE));
+	WidgetStateAsset->bInstanceImagesOutputFormat = static_cast<int8>(
+		SequenceRendererTargets.OutputFormat(FRendererTargetOptions::INSTANCE_IMAGE));
 	WidgetStateAsset->OutputImageResolution = OutputImageResolution;
 	WidgetStateAsset->DepthRange = SequenceRendererTargets.DepthRangeMeters();
 	WidgetStateAsset->OpticalFlowScale = SequenceRendererTargets.OpticalFlowScale();
+	WidgetStateAsset->ExrTileSize = SequenceRendererTargets.ExrTileSize();
+	WidgetStateAsset->bExrMipLevels = SequenceRendererTargets.ExrMipLevels();
+	WidgetStateAsset->bCombineExrTargets = SequenceRendererTargets.CombineExrTargets();
+	WidgetStateAsset->bEmbedFrameMetadata = SequenceRendererTargets.EmbedFrameMetadata();
+	WidgetStateAsset->bSemanticClassIds = SequenceRendererTargets.SemanticClassIds();
+	WidgetStateAsset->bSnapSemanticColors = SequenceRendererTargets.SnapSemanticColors();
+	WidgetStateAsset->bExportMaskAnnotations = SequenceRendererTargets.ExportMaskAnnotations();
+	WidgetStateAsset->bExportBoundingBoxes = SequenceRendererTargets.ExportBoundingBoxes();
+	WidgetStateAsset->bOpticalFlowFromDepth = SequenceRendererTargets.OpticalFlowFromDepth();
+	WidgetStateAsset->bExportOcclusionMasks = SequenceRendererTargets.ExportOcclusionMasks();
+	WidgetStateAsset->bExportPointClouds = SequenceRendererTargets.ExportPointClouds();
+	WidgetStateAsset->bPointCloudsAsNpy = SequenceRendererTargets.PointCloudsAsNpy();
+	WidgetStateAsset->bMergeRigPointClouds = SequenceRendererTargets.MergeRigPointClouds();
+	WidgetStateAsset->bExportLidar = SequenceRendererTargets.ExportLidar();
+	WidgetStateAsset->LidarChannels = SequenceRendererTargets.LidarChannels();
+	WidgetStateAsset->LidarUpperFovDegrees = SequenceRendererTargets.LidarUpperFovDegrees();
+	WidgetStateAsset->LidarLowerFovDegrees = SequenceRendererTargets.LidarLowerFovDegrees();
+	WidgetStateAsset->LidarAzimuthResolutionDegrees = SequenceRendererTargets.LidarAzimuthResolutionDegrees();
+	WidgetStateAsset->LidarMaxRangeMeters = SequenceRendererTargets.LidarMaxRangeMeters();
 	WidgetStateAsset->OutputDirectory = OutputDirectory;
 
 	// Save the asset
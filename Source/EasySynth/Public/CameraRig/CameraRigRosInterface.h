@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 
+#include "CameraRig/CameraRigData.h"
+
 #include "CameraRigRosInterface.generated.h"
 
 class UCameraComponent;
@@ -71,6 +73,9 @@ public:
 		TArray<UCameraComponent*> RigCameras,
 		const FIntPoint& SensorSize);
 
+	/** Calculates intrinsics and the relative transform of a rig camera */
+	static FCameraRigData::FCameraData GetCameraData(UCameraComponent* Camera, const FIntPoint& SensorSize);
+
 private:
 	/** Adds lines describing a single camera to the output array */
 	void AddCamera(
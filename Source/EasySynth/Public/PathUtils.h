@@ -116,6 +116,36 @@ public:
 		return Directory / SemanticClassesFileName;
 	}
 
+	/** Full path to the semantic class ids CSV file */
+	static FString SemanticClassIdsFilePath(const FString& Directory)
+	{
+		return Directory / SemanticClassIdsFileName;
+	}
+
+	/** Full path to the semantic unmatched pixels CSV file */
+	static FString SemanticUnmatchedPixelsFilePath(const FString& Directory)
+	{
+		return Directory / SemanticUnmatchedPixelsFileName;
+	}
+
+	/** Full path to the mask annotations JSON lines file */
+	static FString MaskAnnotationsFilePath(const FString& Directory)
+	{
+		return Directory / MaskAnnotationsFileName;
+	}
+
+	/** Full path to the instance ids CSV file */
+	static FString InstanceIdsFilePath(const FString& Directory)
+	{
+		return Directory / InstanceIdsFileName;
+	}
+
+	/** Full path to the optical flow validation CSV output file */
+	static FString FlowValidationFilePath(const FString& Directory)
+	{
+		return Directory / FlowValidationFileName;
+	}
+
 	/** Gets original camera name from the received camera component */
 	static FString GetCameraName(UCameraComponent* CameraComponent)
 	{
@@ -135,6 +165,36 @@ public:
 		return RigCameraDir(Directory, CameraComponent) / CameraPosesFileName;
 	}
 
+	/** Full path to the camera bounding boxes output file */
+	static FString BoundingBoxesFilePath(const FString& Directory, UCameraComponent* CameraComponent)
+	{
+		return RigCameraDir(Directory, CameraComponent) / BoundingBoxesFileName;
+	}
+
+	/** Path to the backward optical flow images of the specific rig camera */
+	static FString BackwardOpticalFlowDir(const FString& Directory, UCameraComponent* CameraComponent)
+	{
+		return RigCameraDir(Directory, CameraComponent) / BackwardOpticalFlowDirName;
+	}
+
+	/** Path to the optical flow occlusion masks of the specific rig camera */
+	static FString OcclusionMaskDir(const FString& Directory, UCameraComponent* CameraComponent)
+	{
+		return RigCameraDir(Directory, CameraComponent) / OcclusionMaskDirName;
+	}
+
+	/** Path to the point clouds of the specific rig camera */
+	static FString PointCloudDir(const FString& Directory, UCameraComponent* CameraComponent)
+	{
+		return RigCameraDir(Directory, CameraComponent) / PointCloudDirName;
+	}
+
+	/** Path to the partial LiDAR sweeps of the specific rig camera */
+	static FString LidarDir(const FString& Directory, UCameraComponent* CameraComponent)
+	{
+		return RigCameraDir(Directory, CameraComponent) / LidarDirName;
+	}
+
 	/** Full path to the camera rig poses output file */
 	static FString CameraRigPosesFilePath(const FString& Directory)
 	{
@@ -150,6 +210,36 @@ public:
 	/** Clean name of the semantic classes CSV output file */
 	static const FString SemanticClassesFileName;
 
+	/** Clean name of the semantic class ids CSV output file */
+	static const FString SemanticClassIdsFileName;
+
+	/** Clean name of the semantic unmatched pixels CSV output file */
+	static const FString SemanticUnmatchedPixelsFileName;
+
+	/** Clean name of the mask annotations JSON lines output file */
+	static const FString MaskAnnotationsFileName;
+
+	/** Clean name of the instance ids CSV output file */
+	static const FString InstanceIdsFileName;
+
+	/** Clean name of the optical flow validation CSV output file */
+	static const FString FlowValidationFileName;
+
 	/** Clean name of the camera poses output file */
 	static const FString CameraPosesFileName;
+
+	/** Clean name of the bounding boxes output file */
+	static const FString BoundingBoxesFileName;
+
+	/** Clean name of the backward optical flow images directory */
+	static const FString BackwardOpticalFlowDirName;
+
+	/** Clean name of the optical flow occlusion masks directory */
+	static const FString OcclusionMaskDirName;
+
+	/** Clean name of the point clouds directory */
+	static const FString PointCloudDirName;
+
+	/** Clean name of the simulated LiDAR sweeps directory */
+	static const FString LidarDirName;
 };
@@ -0,0 +1,77 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UCameraComponent;
+class UTextureStyleManager;
+
+
+/**
+ * Class which instance is used to export per-frame 3D and projected 2D bounding boxes
+ * of semantically labeled actors into a binary file.
+ * An object of this class should be discarded when its job is done
+ *
+ * File layout, all values little endian:
+ * - header: "ESBB", uint32 version, uint32 actor count, uint32 frame count, float fx, fy, cx, cy
+ * - per actor: uint32 class id, uint32 instance id, 16 byte actor GUID,
+ *   world oriented box when the rendering starts as float center xyz, half extent xyz and rotation quaternion xyzw
+ * - per frame: uint32 visible actor count, followed by a record per visible actor:
+ *   uint32 actor index, float 2D box min u, min v, max u, max v, float nearest depth,
+ *   camera space oriented box as float center xyz and rotation quaternion xyzw, uint8 truncated flag
+ *
+ * Boxes of actors animated by the sequence follow the actor transform of each frame,
+ * while half extents are measured when the rendering starts
+*/
+class FBoundingBoxExporter
+{
+public:
+	/** Collects the oriented component bounds of all actors with an assigned semantic class */
+	void CollectActors(UTextureStyleManager* TextureStyleManager);
+
+	/**
+	 * Projects boxes for each camera pose and saves them to a file inside the camera directory,
+	 * actors with per frame transforms are moved accordingly, while the others keep their current transforms
+	*/
+	bool ExportBoundingBoxes(
+		const TArray<FTransform>& CameraTransforms,
+		const TMap<AActor*, TArray<FTransform>>& ActorTransforms,
+		const FVector4& CameraIntrinsics,
+		const FIntPoint& OutputResolution,
+		const FString& FilePath);
+
+private:
+	/** Number of corners of a box */
+	static constexpr int32 NumCorners = 8;
+
+	/** Corners closer to the camera than this are considered behind it, box edges are clipped at this depth */
+	static constexpr float NearPlane = 1.0f;
+
+	/** Collected actors */
+	TArray<AActor*> Actors;
+
+	/** Box of each actor in its local space */
+	TArray<FBox> LocalBoxes;
+
+	/** Class id of each actor */
+	TArray<uint32> ClassIds;
+
+	/** Instance id of each actor, 0 if not assigned */
+	TArray<uint32> InstanceIds;
+
+	/** GUID of each actor */
+	TArray<FGuid> ActorGuids;
+
+	/** World oriented box of each actor */
+	TArray<FTransform> BoxTransforms;
+
+	/** Half extents of each actor box */
+	TArray<FVector3f> BoxExtents;
+
+	/** World space corner coordinates, with corners of the actor i stored at indices [8 * i, 8 * i + 8) */
+	TArray<float> CornersX;
+	TArray<float> CornersY;
+	TArray<float> CornersZ;
+};
@@ -6,8 +6,10 @@
 
 #include "SequencerWrapper.h"
 
+class AActor;
 class UCameraComponent;
 class ULevelSequence;
+class UMovieScene3DTransformTrack;
 
 
 /**
@@ -27,10 +29,37 @@ public:
 		const FString& OutputDir,
 		UCameraComponent* CameraComponent);
 
+	/**
+	 * Extract camera poses from the sequence without saving them,
+	 * to extract rig poses, pass nullptr for the CameraComponent
+	 */
+	bool ExtractCameraPoses(ULevelSequence* LevelSequence, UCameraComponent* CameraComponent);
+
+	/** Extracted camera pose transforms, one per frame */
+	const TArray<FTransform>& GetCameraTransforms() const { return CameraTransforms; }
+
+	/** Extracted frame timestamps */
+	const TArray<double>& GetTimestamps() const { return Timestamps; }
+
+	/** Sets whether transforms of actors animated by the sequence should be extracted together with camera poses */
+	void SetExtractActorTransforms(const bool bValue) { bExtractActorTransforms = bValue; }
+
+	/** Extracted transforms of actors animated by the sequence, one per frame, empty unless requested */
+	const TMap<AActor*, TArray<FTransform>>& GetActorTransforms() const { return ActorTransforms; }
+
 private:
 	/** Extract camera transforms using the sequencer wrapper */
 	bool ExtractCameraTransforms(const bool bAccumulateCameraOffset);
 
+	/** Extract transforms of actors bound to transform tracks, at the same ticks as the camera poses */
+	bool ExtractActorTransforms();
+
+	/** Evaluates the transform track at the tick */
+	static bool InterrogateTransforms(
+		UMovieScene3DTransformTrack* TransformTrack,
+		const FFrameNumber TickNumber,
+		TArray<FTransform>& OutTransforms);
+
 	/** Saves the extracted camera poses to a file */
 	bool SavePosesToCSV(const FString& FilePath);
 
@@ -45,4 +74,13 @@ private:
 
 	/** Frame timestamps */
 	TArray<double> Timestamps;
+
+	/** Sequence tick of each frame */
+	TArray<FFrameNumber> FrameTicks;
+
+	/** Whether actor transforms should be extracted */
+	bool bExtractActorTransforms = false;
+
+	/** Extracted actor transforms */
+	TMap<AActor*, TArray<FTransform>> ActorTransforms;
 };
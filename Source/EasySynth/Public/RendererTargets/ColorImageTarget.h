@@ -19,8 +19,11 @@ public:
 		FRendererTarget(TextureStyleManager, ImageFormat)
 	{}
 
+	/** Returns the name of the target, known without creating the target */
+	static FString StaticName() { return TEXT("ColorImage"); }
+
 	/** Returns the name of the target */
-	virtual FString Name() const { return TEXT("ColorImage"); }
+	virtual FString Name() const { return StaticName(); }
 
 	/** Prepares the sequence for rendering the target */
 	bool PrepareSequence(ULevelSequence* LevelSequence) override;
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCameraComponent;
+
+
+/**
+ * Class that formats per-frame camera information embedded into output images,
+ * so that each frame can be consumed without joining it with the camera poses and rig files
+*/
+class FFrameMetadata
+{
+public:
+	/**
+	 * Formats the camera pose and timestamp of a single frame, together with camera intrinsics,
+	 * as key/value pairs named the same as the camera poses file columns (tx, ..., qw, t) and fx, fy, cx, cy
+	*/
+	static TArray<TPair<FString, FString>> FrameValues(
+		const FTransform& CameraPose,
+		const double Timestamp,
+		const FVector4& CameraIntrinsics);
+
+	/** Picks frame values out of string attributes read from an image, such as an EXR header, in the usual order */
+	static TArray<TPair<FString, FString>> FrameValuesFromAttributes(
+		const TMap<FString, FStringFormatArg>& Attributes);
+
+	/** Returns camera intrinsics packed as (fx, fy, cx, cy) */
+	static FVector4 CameraIntrinsics(UCameraComponent* Camera, const FIntPoint& SensorSize);
+
+	/**
+	 * Inserts frame metadata as tEXt chunks into all PNG images inside the directory,
+	 * images are matched with frames in the order of their file names, so there has to be an image for each frame
+	 * Only reads the provided values, so it can run on a worker thread
+	*/
+	static bool AddToPngFiles(
+		const FString& ImageDir,
+		const TArray<FTransform>& CameraPoses,
+		const TArray<double>& Timestamps,
+		const FVector4& CameraIntrinsics);
+
+	/** Inserts tEXt chunks into the PNG file data right after the header chunk */
+	static bool InsertPngTextChunks(TArray64<uint8>& FileData, const TArray<TPair<FString, FString>>& Values);
+};
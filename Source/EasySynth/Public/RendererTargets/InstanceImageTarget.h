@@ -0,0 +1,40 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "RendererTargets/RendererTarget.h"
+
+class UTextureStyleManager;
+
+
+/**
+ * Class responsible for updating the world properties before
+ * the instance image target rendering and restoring them after the rendering
+*/
+class FInstanceImageTarget : public FRendererTarget
+{
+public:
+	explicit FInstanceImageTarget(UTextureStyleManager* TextureStyleManager, const EImageFormat ImageFormat) :
+		FRendererTarget(TextureStyleManager, ImageFormat)
+	{}
+
+	/** Returns the name of the target, known without creating the target */
+	static FString StaticName() { return TEXT("InstanceImage"); }
+
+	/** Returns the name of the target */
+	virtual FString Name() const { return StaticName(); }
+
+	/** Instance colors are shown as they are, the same way as semantic colors */
+	FString PostProcessMaterialName() const override { return TEXT("SemanticImage"); }
+
+	/** Returns the instance id output setting, as instance images are always written as id images */
+	UClass* CustomOutputSettingClass() const override;
+
+	/** Prepares the sequence for rendering the target */
+	bool PrepareSequence(ULevelSequence* LevelSequence) override;
+
+	/** Reverts changes made to the sequence by the PrepareSequence */
+	bool FinalizeSequence(ULevelSequence* LevelSequence) override;
+};
@@ -24,8 +24,11 @@ public:
 			OpticalFlowScale(OpticalFlowScale)
 	{}
 
+	/** Returns the name of the target, known without creating the target */
+	static FString StaticName() { return TEXT("OpticalFlowImage"); }
+
 	/** Returns the name of the target */
-	virtual FString Name() const { return TEXT("OpticalFlowImage"); }
+	virtual FString Name() const { return StaticName(); }
 
 	/** Prepares the sequence for rendering the target */
 	bool PrepareSequence(ULevelSequence* LevelSequence) override;
@@ -35,6 +35,15 @@ public:
 	/** Reverts changes made to the sequence by the PrepareSequence */
 	virtual bool FinalizeSequence(ULevelSequence* LevelSequence) = 0;
 
+	/**
+	 * Returns the movie pipeline output setting class that replaces the output of the selected image format,
+	 * or nullptr if the target is written in the selected image format
+	*/
+	virtual UClass* CustomOutputSettingClass() const { return nullptr; }
+
+	/** Returns the name of the post process material asset used by the target */
+	virtual FString PostProcessMaterialName() const { return Name(); }
+
 	/** Output image format selected for this target */
 	const EImageFormat ImageFormat;
 
@@ -49,7 +58,7 @@ protected:
 	inline UMaterial* LoadPostProcessMaterial() const
 	{
 		return DuplicateObject<UMaterial>(
-			LoadObject<UMaterial>(nullptr, *FPathUtils::PostProcessMaterialPath(Name())), nullptr);
+			LoadObject<UMaterial>(nullptr, *FPathUtils::PostProcessMaterialPath(PostProcessMaterialName())), nullptr);
 	}
 
 	/** Handle for managing texture style in the level */
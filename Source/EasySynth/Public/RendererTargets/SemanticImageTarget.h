@@ -16,16 +16,30 @@ class UTextureStyleManager;
 class FSemanticImageTarget : public FRendererTarget
 {
 public:
-	explicit FSemanticImageTarget(UTextureStyleManager* TextureStyleManager, const EImageFormat ImageFormat) :
-		FRendererTarget(TextureStyleManager, ImageFormat)
+	explicit FSemanticImageTarget(
+		UTextureStyleManager* TextureStyleManager,
+		const EImageFormat ImageFormat,
+		const bool bUseClassOutput) :
+		FRendererTarget(TextureStyleManager, ImageFormat),
+		bUseClassOutput(bUseClassOutput)
 	{}
 
+	/** Returns the name of the target, known without creating the target */
+	static FString StaticName() { return TEXT("SemanticImage"); }
+
 	/** Returns the name of the target */
-	virtual FString Name() const { return TEXT("SemanticImage"); }
+	virtual FString Name() const { return StaticName(); }
+
+	/** Returns the semantic class output setting if class ids or snapped class colors are written */
+	UClass* CustomOutputSettingClass() const override;
 
 	/** Prepares the sequence for rendering the target */
 	bool PrepareSequence(ULevelSequence* LevelSequence) override;
 
 	/** Reverts changes made to the sequence by the PrepareSequence */
 	bool FinalizeSequence(ULevelSequence* LevelSequence) override;
+
+private:
+	/** Whether images are written by the semantic class output instead of the selected image format output */
+	const bool bUseClassOutput;
 };
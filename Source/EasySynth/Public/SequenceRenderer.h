@@ -4,9 +4,12 @@
 
 #include "CoreMinimal.h"
 
+#include "Async/Future.h"
+
 #include "RendererTargets/RendererTarget.h"
 #include "RendererTargets/ColorImageTarget.h"
 #include "RendererTargets/DepthImageTarget.h"
+#include "RendererTargets/InstanceImageTarget.h"
 #include "RendererTargets/NormalImageTarget.h"
 #include "RendererTargets/OpticalFlowImageTarget.h"
 #include "RendererTargets/SemanticImageTarget.h"
@@ -14,6 +17,7 @@
 
 #include "SequenceRenderer.generated.h"
 
+class FLidarSimulator;
 class ULevelSequence;
 class UMoviePipelineExecutorBase;
 class UMoviePipelinePrimaryConfig;
@@ -27,7 +31,7 @@ class FRendererTargetOptions
 {
 public:
 	/** The enum containing all supported rendering targets */
-	enum TargetType { COLOR_IMAGE, DEPTH_IMAGE, NORMAL_IMAGE, OPTICAL_FLOW_IMAGE, SEMANTIC_IMAGE, COUNT };
+	enum TargetType { COLOR_IMAGE, DEPTH_IMAGE, NORMAL_IMAGE, OPTICAL_FLOW_IMAGE, SEMANTIC_IMAGE, INSTANCE_IMAGE, COUNT };
 
 	FRendererTargetOptions();
 
@@ -64,15 +68,150 @@ public:
 	/** OpticalFlowScaleValue setter */
 	float OpticalFlowScale() const { return OpticalFlowScaleValue; }
 
+	/** ExrTileSizeValue setter, zero selects scanline EXR files */
+	void SetExrTileSize(const int32 ExrTileSize) { ExrTileSizeValue = ExrTileSize; }
+
+	/** ExrTileSizeValue getter */
+	int32 ExrTileSize() const { return ExrTileSizeValue; }
+
+	/** Updates should tiled EXR files contain mip levels */
+	void SetExrMipLevels(const bool bValue) { bExrMipLevels = bValue; }
+
+	/** Return should tiled EXR files contain mip levels */
+	bool ExrMipLevels() const { return bExrMipLevels; }
+
+	/** Updates should EXR targets be combined into a single file per frame */
+	void SetCombineExrTargets(const bool bValue) { bCombineExrTargets = bValue; }
+
+	/** Return should EXR targets be combined into a single file per frame */
+	bool CombineExrTargets() const { return bCombineExrTargets; }
+
+	/** Updates should camera poses and intrinsics be embedded into each image */
+	void SetEmbedFrameMetadata(const bool bValue) { bEmbedFrameMetadata = bValue; }
+
+	/** Return should camera poses and intrinsics be embedded into each image */
+	bool EmbedFrameMetadata() const { return bEmbedFrameMetadata; }
+
+	/** Updates should semantic images contain class ids instead of class colors */
+	void SetSemanticClassIds(const bool bValue) { bSemanticClassIds = bValue; }
+
+	/** Return should semantic images contain class ids instead of class colors */
+	bool SemanticClassIds() const { return bSemanticClassIds; }
+
+	/** Updates should semantic image pixels be snapped to the nearest class color */
+	void SetSnapSemanticColors(const bool bValue) { bSnapSemanticColors = bValue; }
+
+	/** Return should semantic image pixels be snapped to the nearest class color */
+	bool SnapSemanticColors() const { return bSnapSemanticColors; }
+
+	/** Updates should per-id bounding boxes and RLE masks be exported for semantic and instance images */
+	void SetExportMaskAnnotations(const bool bValue) { bExportMaskAnnotations = bValue; }
+
+	/** Return should per-id bounding boxes and RLE masks be exported for semantic and instance images */
+	bool ExportMaskAnnotations() const { return bExportMaskAnnotations; }
+
+	/** Updates should per-frame 3D and 2D bounding boxes of labeled actors be exported */
+	void SetExportBoundingBoxes(const bool bValue) { bExportBoundingBoxes = bValue; }
+
+	/** Return should per-frame 3D and 2D bounding boxes of labeled actors be exported */
+	bool ExportBoundingBoxes() const { return bExportBoundingBoxes; }
+
+	/** Updates should optical flow be derived from depth images and camera poses instead of being rendered */
+	void SetOpticalFlowFromDepth(const bool bValue) { bOpticalFlowFromDepth = bValue; }
+
+	/** Return should optical flow be derived from depth images and camera poses instead of being rendered */
+	bool OpticalFlowFromDepth() const { return bOpticalFlowFromDepth; }
+
+	/** Updates should backward optical flow and occlusion masks be generated with derived optical flow */
+	void SetExportOcclusionMasks(const bool bValue) { bExportOcclusionMasks = bValue; }
+
+	/** Return should backward optical flow and occlusion masks be generated with derived optical flow */
+	bool ExportOcclusionMasks() const { return bExportOcclusionMasks; }
+
+	/** Updates should depth images be back-projected into world space point clouds */
+	void SetExportPointClouds(const bool bValue) { bExportPointClouds = bValue; }
+
+	/** Return should depth images be back-projected into world space point clouds */
+	bool ExportPointClouds() const { return bExportPointClouds; }
+
+	/** Updates should point clouds be written as .npy arrays instead of binary PLY files */
+	void SetPointCloudsAsNpy(const bool bValue) { bPointCloudsAsNpy = bValue; }
+
+	/** Return should point clouds be written as .npy arrays instead of binary PLY files */
+	bool PointCloudsAsNpy() const { return bPointCloudsAsNpy; }
+
+	/** Updates should point clouds of all rig cameras also be merged into one point cloud per frame */
+	void SetMergeRigPointClouds(const bool bValue) { bMergeRigPointClouds = bValue; }
+
+	/** Return should point clouds of all rig cameras also be merged into one point cloud per frame */
+	bool MergeRigPointClouds() const { return bMergeRigPointClouds; }
+
+	/** Updates should depth images of the rig cameras be resampled into simulated LiDAR sweeps */
+	void SetExportLidar(const bool bValue) { bExportLidar = bValue; }
+
+	/** Return should depth images of the rig cameras be resampled into simulated LiDAR sweeps */
+	bool ExportLidar() const { return bExportLidar; }
+
+	/** LidarChannelsValue setter */
+	void SetLidarChannels(const int32 LidarChannels) { LidarChannelsValue = LidarChannels; }
+
+	/** LidarChannelsValue getter */
+	int32 LidarChannels() const { return LidarChannelsValue; }
+
+	/** LidarUpperFovDegreesValue setter */
+	void SetLidarUpperFovDegrees(const float LidarUpperFovDegrees) { LidarUpperFovDegreesValue = LidarUpperFovDegrees; }
+
+	/** LidarUpperFovDegreesValue getter */
+	float LidarUpperFovDegrees() const { return LidarUpperFovDegreesValue; }
+
+	/** LidarLowerFovDegreesValue setter */
+	void SetLidarLowerFovDegrees(const float LidarLowerFovDegrees) { LidarLowerFovDegreesValue = LidarLowerFovDegrees; }
+
+	/** LidarLowerFovDegreesValue getter */
+	float LidarLowerFovDegrees() const { return LidarLowerFovDegreesValue; }
+
+	/** LidarAzimuthResolutionDegreesValue setter */
+	void SetLidarAzimuthResolutionDegrees(const float LidarAzimuthResolutionDegrees)
+	{
+		LidarAzimuthResolutionDegreesValue = LidarAzimuthResolutionDegrees;
+	}
+
+	/** LidarAzimuthResolutionDegreesValue getter */
+	float LidarAzimuthResolutionDegrees() const { return LidarAzimuthResolutionDegreesValue; }
+
+	/** LidarMaxRangeMetersValue setter */
+	void SetLidarMaxRangeMeters(const float LidarMaxRangeMeters) { LidarMaxRangeMetersValue = LidarMaxRangeMeters; }
+
+	/** LidarMaxRangeMetersValue getter */
+	float LidarMaxRangeMeters() const { return LidarMaxRangeMetersValue; }
+
+	/** Checks if LiDAR sweeps are simulated, which requires EXR depth images and a valid beam pattern */
+	bool LidarOutput() const;
+
+	/** Checks if point clouds are exported, which requires EXR depth images to be rendered */
+	bool PointCloudOutput() const;
+
+	/** Checks if optical flow images are derived from depth, which requires EXR depth images to be rendered */
+	bool DerivedOpticalFlowOutput() const;
+
+	/** Checks if semantic images are written by the semantic class output */
+	bool SemanticClassOutput() const { return bSemanticClassIds || bSnapSemanticColors || bExportMaskAnnotations; }
+
+	/** Checks if targets will be combined, which requires all selected targets to be written as EXR */
+	bool CombinedExrOutput() const;
+
 	/** Populate provided queue with selected renderer targets */
 	void GetSelectedTargets(
 		UTextureStyleManager* TextureStyleManager,
 		TQueue<TSharedPtr<FRendererTarget>>& OutTargetsQueue) const;
 
-private:
 	/** Get the renderer target object from the target type id */
 	TSharedPtr<FRendererTarget> RendererTarget(const int TargetType, UTextureStyleManager* TextureStyleManager) const;
 
+	/** Get the renderer target name from the target type id, without creating the target */
+	static FString TargetName(const int TargetType);
+
+private:
 	/** Is the default color image rendering requested */
 	TArray<bool> SelectedTargets;
 
@@ -94,6 +233,66 @@ private:
 	*/
 	float OpticalFlowScaleValue;
 
+	/**
+	 * Tile size used when writing EXR files, zero writes scanline files
+	 * Tiled files allow loaders to decode only the needed image regions
+	*/
+	int32 ExrTileSizeValue;
+
+	/** Whether tiled EXR files also contain mip levels */
+	bool bExrMipLevels;
+
+	/** Whether all targets are written as layers of a single EXR file per frame */
+	bool bCombineExrTargets;
+
+	/** Whether EXR headers and PNG text chunks contain the frame camera pose and intrinsics */
+	bool bEmbedFrameMetadata;
+
+	/** Whether semantic images are written as single channel class id images */
+	bool bSemanticClassIds;
+
+	/** Whether semantic image pixels that match no class, such as blended edges, take the nearest class color */
+	bool bSnapSemanticColors;
+
+	/** Whether semantic and instance image writers also compute per-id boxes and masks of each frame */
+	bool bExportMaskAnnotations;
+
+	/** Whether bounding boxes of labeled actors are computed from their bounds for each frame */
+	bool bExportBoundingBoxes;
+
+	/** Whether optical flow of static scenes is computed from rendered depth, skipping the optical flow render pass */
+	bool bOpticalFlowFromDepth;
+
+	/** Whether derived optical flow also comes with backward flow and forward-backward consistency masks */
+	bool bExportOcclusionMasks;
+
+	/** Whether each depth frame is back-projected into a world space point cloud */
+	bool bExportPointClouds;
+
+	/** Whether point clouds are written as .npy arrays instead of binary PLY files */
+	bool bPointCloudsAsNpy;
+
+	/** Whether point clouds of all rig cameras are also merged into a single sweep per frame */
+	bool bMergeRigPointClouds;
+
+	/** Whether a spinning LiDAR at the rig origin is simulated by resampling the rig depth images */
+	bool bExportLidar;
+
+	/** Number of simulated LiDAR rings */
+	int32 LidarChannelsValue;
+
+	/** Elevation of the highest simulated LiDAR ring */
+	float LidarUpperFovDegreesValue;
+
+	/** Elevation of the lowest simulated LiDAR ring */
+	float LidarLowerFovDegreesValue;
+
+	/** Angle between consecutive simulated LiDAR firings */
+	float LidarAzimuthResolutionDegreesValue;
+
+	/** Range beyond which simulated LiDAR beams produce no returns */
+	float LidarMaxRangeMetersValue;
+
 	/** Default value for the depth range */
 	static const float DefaultDepthRangeMetersValue;
 
@@ -149,6 +348,30 @@ private:
 	/** Runs the rendering of the currently selected target */
 	void StartRendering();
 
+	/** Starts deriving optical flow from the just rendered depth target on worker threads */
+	void StartDepthOpticalFlow();
+
+	/** Starts back-projecting the just rendered depth target into point clouds on worker threads */
+	void StartDepthPointCloud();
+
+	/** Starts resampling the just rendered depth target into partial LiDAR sweeps on worker threads */
+	void StartLidarSampling();
+
+	/** Combines partial LiDAR sweeps of all rig cameras once all of them are rendered */
+	bool FinalizeLidarSweeps();
+
+	/**
+	 * Waits for outputs derived from the current camera targets,
+	 * then starts combining its per target outputs on worker threads if requested
+	*/
+	bool FinalizeCameraOutputs();
+
+	/** Waits for the running EXR target merge, returns false if it failed */
+	bool WaitForExrMerge();
+
+	/** Waits for the frame metadata to be added to all PNG targets of the camera, returns false if any failed */
+	bool WaitForPngMetadata();
+
 	/** Clears the existing job queue and adds a fresh job */
 	bool PrepareJobQueue(UMoviePipelineQueueSubsystem* MoviePipelineQueueSubsystem);
 
@@ -198,6 +421,39 @@ private:
 	/** Target currently being rendered */
 	TSharedPtr<FRendererTarget> CurrentTarget;
 
+	/** Names of the targets already rendered by the current camera */
+	TArray<FString> RenderedTargetNames;
+
+	/** Current camera poses for each frame, kept if they are embedded into images */
+	TArray<FTransform> CameraFramePoses;
+
+	/** Frame timestamps, kept if they are embedded into images */
+	TArray<double> CameraFrameTimestamps;
+
+	/** Current camera intrinsics packed as (fx, fy, cx, cy) */
+	FVector4 CameraIntrinsics;
+
+	/** Current camera poses for each frame, kept if outputs are derived from depth */
+	TArray<FTransform> DepthFramePoses;
+
+	/** Optical flow generation running on worker threads, while the remaining targets are rendered */
+	TFuture<bool> DepthOpticalFlowTask;
+
+	/** Point cloud generation running on worker threads, while the remaining targets are rendered */
+	TFuture<bool> DepthPointCloudTask;
+
+	/** Beam lookup tables of the simulated LiDAR, built once for the whole rig */
+	TSharedPtr<const FLidarSimulator> LidarSimulator;
+
+	/** LiDAR resampling running on worker threads, while the remaining targets are rendered */
+	TFuture<bool> LidarSamplingTask;
+
+	/** Merging of the previous camera EXR targets running on worker threads, while the next camera is rendered */
+	TFuture<bool> ExrMergeTask;
+
+	/** Adding of the frame metadata to rendered PNG targets running on worker threads, one task per target */
+	TArray<TFuture<bool>> PngMetadataTasks;
+
 	/** Output image resolution */
 	FIntPoint OutputResolution;
 
@@ -0,0 +1,115 @@
+// Copyright (c) 2022 YDrive Inc. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Engine/DataAsset.h"
+#include "Internationalization/Regex.h"
+#include "Templates/Function.h"
+
+#include "SemanticRulesAsset.generated.h"
+
+class UMaterialInterface;
+
+
+/**
+ * Rule that assigns a semantic class to actors matching all of its non-empty criteria,
+ * a rule without criteria matches any actor
+*/
+USTRUCT(BlueprintType)
+struct FSemanticLabelingRule
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The semantic class assigned to matching actors */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule")
+	FString ClassName;
+
+	/** Rules with higher priorities win, rules with equal priorities are resolved by their order */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule")
+	int32 Priority = 0;
+
+	/** Actors have to be of this class or its subclasses */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule Criteria")
+	TSubclassOf<AActor> ActorClass;
+
+	/** Wildcard the path of one of the actor static meshes has to match, such as /Game/City/Meshes/SM_Car* */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule Criteria")
+	FString MeshPathGlob;
+
+	/** Wildcard the name of one of the actor materials has to match */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule Criteria")
+	FString MaterialName;
+
+	/** Regular expression the actor label has to contain a match of */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule Criteria")
+	FString ActorLabelRegex;
+
+	/** Outliner folder the actor has to be inside of, including its subfolders */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rule Criteria")
+	FString FolderPath;
+};
+
+
+/** An asset containing rules for automatic semantic labeling of level actors */
+UCLASS()
+class EASYSYNTH_API USemanticRulesAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Labeling rules */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rules")
+	TArray<FSemanticLabelingRule> Rules;
+
+	/**
+	 * Prepares the rules for matching, has to be called on the game thread after the rules are modified
+	 * Rules naming classes outside of the provided ones are skipped, the rest are ordered by priority
+	*/
+	void CompileRules(const TArray<FString>& ClassNames);
+
+	/**
+	 * Returns the class name of the highest priority rule the actor matches, or null if there is none
+	 * Material names are matched against the materials provided by ActorMaterials, which should be the original
+	 * ones of the actor, as displayed materials are replaced while semantic or instance colors are shown.
+	 * Only reads the actor, so it can be called from multiple threads once the rules are compiled
+	*/
+	const FString* MatchingClassName(
+		const AActor* Actor,
+		TFunctionRef<void(const AActor*, TArray<const UMaterialInterface*>&)> ActorMaterials) const;
+
+#if WITH_EDITOR
+	/** Compiles the rules again after they are edited, using the class names of the last compilation */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	/** Rule prepared for matching */
+	struct FCompiledRule
+	{
+		/** The matched rule */
+		const FSemanticLabelingRule* Rule;
+
+		/** Compiled actor label regular expression, if set */
+		TSharedPtr<FRegexPattern> ActorLabelPattern;
+
+		/** Folder path with a trailing slash, if set */
+		FString FolderPrefix;
+	};
+
+	/** Checks if the actor matches all criteria of the rule, actor materials are only requested if needed */
+	static bool Matches(
+		const FCompiledRule& CompiledRule,
+		const AActor* Actor,
+		TFunctionRef<const TArray<const UMaterialInterface*>&()> ActorMaterials);
+
+	/** Rules ordered by descending priority */
+	TArray<FCompiledRule> CompiledRules;
+
+	/** Class names the rules were last compiled with */
+	TArray<FString> CompiledClassNames;
+
+	/** Whether the rules have been compiled */
+	bool bRulesCompiled = false;
+};
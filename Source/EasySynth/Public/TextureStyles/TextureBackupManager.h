@@ -4,57 +4,22 @@
 
 #include "CoreMinimal.h"
 
+#include "Templates/Function.h"
+#include "UObject/ObjectKey.h"
+
 #include "TextureBackupManager.generated.h"
 
 class ALandscapeProxy;
+class ULandscapeComponent;
 class UMaterialInstanceConstant;
 class UMaterialInterface;
 
 
-/** Structure wrapping TArray of static mesh component materials */
-USTRUCT()
-struct FOriginalComponentDescriptor
-{
-	GENERATED_USTRUCT_BODY()
-
-	/** The array of material interfaces */
-	UPROPERTY()
-	TArray<UMaterialInterface*> MaterialInterfaces;
-
-	/** Wrap TArray Add method */
-	void Add(UMaterialInterface* MaterialInterface) { MaterialInterfaces.Add(MaterialInterface); }
-
-	/** Wrap TArray Num method */
-	int Num() const { return MaterialInterfaces.Num(); }
-
-	/** Wrap TArray [] operator */
-	UMaterialInterface* operator[](int i) { return MaterialInterfaces[i]; }
-};
-
-
-/** Structure wrapping TMap of static mesh components to their original materials */
-USTRUCT()
-struct FOriginalActorDescriptor
-{
-	GENERATED_USTRUCT_BODY()
-
-	/** The map of component descriptors */
-	UPROPERTY()
-	TMap<UPrimitiveComponent*, FOriginalComponentDescriptor> CompDescriptors;
-
-	/** Wrap TMap Add method */
-	void Add(UPrimitiveComponent* Component) { CompDescriptors.Add(Component); }
-
-	/** Wrap TMap Contains method */
-	bool Contains(UPrimitiveComponent* Component) const { return CompDescriptors.Contains(Component); }
-
-	/** Wrap TMap [] operator */
-	FOriginalComponentDescriptor& operator[](UPrimitiveComponent* Component) { return CompDescriptors[Component]; }
-};
-
 /**
  * Class that keeps backup of actors' original materials while semantic ones are displayed,
  * also handles material swapping
+ * Backups are kept in flat arrays, where each actor owns a contiguous range of components
+ * and each component owns a contiguous range of materials
  */
 UCLASS()
 class UTextureBackupManager : public UObject
@@ -74,12 +39,34 @@ public:
 		const bool bDoPaint,
 		UMaterialInstanceConstant* Material = nullptr);
 
+	/**
+	 * Starts queueing AddAndPaint calls of default actors until EndPaintBatch is called,
+	 * so that their original materials are gathered in parallel and each component is painted once
+	 * Queued actors are not considered backed up before the batch ends
+	*/
+	void BeginPaintBatch();
+
+	/** Backs up and paints all actors queued since BeginPaintBatch */
+	void EndPaintBatch();
+
 	/** Checks whether the actor exists inside any of the caches */
 	bool ContainsActor(AActor* Actor);
 
 	/** Removes the actor from its cache if it exists */
 	void RemoveActor(AActor* Actor);
 
+	/**
+	 * Collects the original materials of the actor, which are the current ones if the actor is not backed up
+	 * Only reads the backups, so it can be called from multiple threads while no actors are painted
+	*/
+	void OriginalActorMaterials(const AActor* Actor, TArray<const UMaterialInterface*>& OutMaterials) const;
+
+	/** Returns the memory used by the backups in bytes */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Reports cached landscape material instances, so that they are kept only while their state is cached */
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 private:
 	/** Sub-method of the AddAndPaint that handles landscape actors */
 	void AddLandscapeActor(
@@ -88,6 +75,18 @@ private:
 		const bool bDoPaint,
 		UMaterialInstanceConstant* Material);
 
+	/**
+	 * Sets the landscape material, reusing cached component material instances of the material when possible,
+	 * as rebuilding them after a landscape material change can take seconds per proxy
+	*/
+	void SetLandscapeMaterial(ALandscapeProxy* LandscapeProxy, UMaterialInterface* Material);
+
+	/** Caches the current component material instances of the landscape under its current material */
+	void CacheLandscapeMaterialState(ALandscapeProxy* LandscapeProxy, UMaterialInterface* Material);
+
+	/** Restores cached component material instances, returns false if they are missing or out of date */
+	bool RestoreLandscapeMaterialState(ALandscapeProxy* LandscapeProxy, UMaterialInterface* Material);
+
 	/** Sub-method of the AddAndPaint that handles default static mesh actors */
 	void AddDefaultActor(
 		AActor* Actor,
@@ -95,16 +94,112 @@ private:
 		const bool bDoPaint,
 		UMaterialInstanceConstant* Material);
 
-	/**
-	 * Storage of the original actor materials while semantics are displayed
-	 * Mimics the behavior of the structure defined as
-	 * TMap<AActor*, TMap<UPrimitiveComponent*, TArray<UMaterialInterface*>>>
-	 * which throws the UE specific compile error "Nested containers are not supported."
-	*/
+	/** Primitive components of an actor together with their original materials */
+	struct FActorMaterials
+	{
+		/** Actor primitive components */
+		TArray<UPrimitiveComponent*> Components;
+
+		/** Number of materials of each component */
+		TArray<int32> NumMaterials;
+
+		/** Materials of all components in order */
+		TArray<UMaterialInterface*> Materials;
+	};
+
+	/** AddAndPaint call of a default actor queued during a paint batch */
+	struct FPaintRequest
+	{
+		/** The actor to paint */
+		AActor* Actor;
+
+		/** Whether the original actor materials should be backed up */
+		bool bDoAdd;
+
+		/** Whether the actor should be painted */
+		bool bDoPaint;
+
+		/** The material to paint, original materials are restored if null */
+		UMaterialInstanceConstant* Material;
+	};
+
+	/** Collects the original actor materials, only reads the actor so it can be called from multiple threads */
+	static void GatherActorMaterials(AActor* Actor, FActorMaterials& OutActorMaterials);
+
+	/** Appends the gathered original actor materials to the backup arrays */
+	void BackupActor(AActor* Actor, const FActorMaterials& ActorMaterials);
+
+	/** Paints the backed up actor components, or restores and releases their original materials */
+	void PaintActor(AActor* Actor, const bool bDoPaint, UMaterialInstanceConstant* Material);
+
+	/** Sets materials of all component slots, recreating the component render state at most once */
+	static void SetComponentMaterials(
+		UPrimitiveComponent* PrimitiveComponent,
+		const int32 NumMaterials,
+		TFunctionRef<UMaterialInterface*(const int32)> SlotMaterial);
+
+	/** Removes the actor backup range, compacting the backup arrays once most of them are unused */
+	void ReleaseActor(AActor* Actor);
+
+	/** Moves all used backup ranges to the beginning of the backup arrays */
+	void CompactBackups();
+
+	/** Range of backed up components owned by an actor */
+	struct FActorBackupRange
+	{
+		/** Index of the first actor component inside the component arrays */
+		int32 FirstComponent;
+
+		/** Number of actor components */
+		int32 NumComponents;
+	};
+
+	/** Backup ranges of actors whose original materials are stored */
+	TMap<TObjectKey<AActor>, FActorBackupRange> ActorBackupRanges;
+
+	/** Backed up primitive components */
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> BackupComponents;
+
+	/** Index of the first material of each backed up component inside the material array */
+	TArray<int32> ComponentFirstMaterials;
+
+	/** Number of materials of each backed up component */
+	TArray<int32> ComponentNumMaterials;
+
+	/** Original materials of all backed up components, referenced so that they are not garbage collected */
 	UPROPERTY()
-	TMap<AActor*, FOriginalActorDescriptor> OriginalActorDescriptors;
+	TArray<UMaterialInterface*> BackupMaterials;
+
+	/** Number of components inside the component arrays that belong to released actors */
+	int32 NumReleasedComponents = 0;
+
+	/** Default actor paint requests queued during a paint batch */
+	TArray<FPaintRequest> PaintBatch;
+
+	/** Whether default actor paint requests are being queued */
+	bool bBatchingPaints = false;
 
 	/** Storage of the original landscape materials while semantics are displayed */
 	UPROPERTY()
 	TMap<ALandscapeProxy*, UMaterialInstanceConstant*> LandscapeActorDescriptors;
+
+	/** Material instances of all landscape proxy components generated for a single landscape material */
+	struct FLandscapeMaterialState
+	{
+		/** Proxy components in order, used to detect changes of the proxy */
+		TArray<TWeakObjectPtr<ULandscapeComponent>> Components;
+
+		/** Material instances of each component */
+		TArray<TArray<TObjectPtr<UMaterialInstanceConstant>>> MaterialInstances;
+
+		/** Material instance index used by each LOD of each component */
+		TArray<TArray<int8>> LODIndexToMaterialIndex;
+	};
+
+	/**
+	 * Cached landscape component material instances by the landscape proxy and its material,
+	 * referenced through AddReferencedObjects so that they are not garbage collected
+	*/
+	TMap<TPair<TObjectKey<ALandscapeProxy>, TObjectKey<UMaterialInterface>>, FLandscapeMaterialState>
+		LandscapeMaterialStates;
 };
@@ -23,6 +23,13 @@ struct FSemanticClass
 	UPROPERTY(EditAnywhere, Category = "Semantic Class Properties", meta = (IgnoreForMemberInitializationTest))
 	FColor Color;
 
+	/**
+	 * Persistent key actors refer to the class by, stays the same when the class is renamed
+	 * Keys are never reused and also serve as the class ids of rendered outputs
+	*/
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Class Properties")
+	int32 Key = 0;
+
 	/** Reference to the plain color material instance */
 	UPROPERTY(EditAnywhere, Category = "Semantic Class Material")
 	UMaterialInstanceConstant* PlainColorMaterialInstance;
@@ -40,7 +47,42 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Semantic Classes")
 	TMap<FString, FSemanticClass> SemanticClasses;
 
-	/** Actor to semantic class name bindings */
+	/** Actor to semantic class key bindings */
+	UPROPERTY(EditAnywhere, Category = "Actor Data")
+	TMap<FGuid, int32> ActorClassKeys;
+
+	/** The key that will be assigned to the next semantic class */
+	UPROPERTY(EditAnywhere, Category = "Semantic Classes")
+	int32 NextClassKey = 1;
+
+	/** Actor to instance id bindings, ids start from 1 and are never reused */
 	UPROPERTY(EditAnywhere, Category = "Actor Data")
-	TMap<FGuid, FString> ActorClassPairs;
+	TMap<FGuid, int32> ActorInstanceIds;
+
+	/** The instance id that will be assigned to the next actor */
+	UPROPERTY(EditAnywhere, Category = "Actor Data")
+	int32 NextInstanceId = 1;
+
+	/** Migrates actor bindings of assets saved before semantic classes had keys */
+	virtual void PostLoad() override;
+
+	/**
+	 * Returns semantic classes ordered by their ids, which are their keys
+	 * Ids are not affected by adding, removing or renaming other classes, so they can have gaps
+	*/
+	TArray<const FSemanticClass*> ClassesById() const
+	{
+		TArray<const FSemanticClass*> Classes;
+		for (const TPair<FString, FSemanticClass>& Element : SemanticClasses)
+		{
+			Classes.Add(&Element.Value);
+		}
+		Classes.Sort([](const FSemanticClass& A, const FSemanticClass& B) { return A.Key < B.Key; });
+		return Classes;
+	}
+
+private:
+	/** Actor to semantic class name bindings of older assets, only loaded to be migrated */
+	UPROPERTY()
+	TMap<FGuid, FString> ActorClassPairs_DEPRECATED;
 };
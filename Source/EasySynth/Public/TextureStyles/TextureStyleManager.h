@@ -11,6 +11,7 @@ class UMaterial;
 
 struct FSemanticClass;
 class UMaterialInstanceConstant;
+class USemanticRulesAsset;
 class UTextureBackupManager;
 class UTextureMappingAsset;
 
@@ -29,12 +30,27 @@ struct EASYSYNTH_API FMeshSemanticTableRowBase : public FTableRowBase
 };
 
 
+/** Actor with an assigned semantic class, together with its class and instance ids */
+struct FLabeledActor
+{
+	/** The labeled actor */
+	AActor* Actor;
+
+	/** Id of the actor class, which is the persistent class key */
+	uint32 ClassId;
+
+	/** Id of the actor instance, 0 if not assigned yet */
+	uint32 InstanceId;
+};
+
+
 /** Enum representing mesh texture styles */
 UENUM()
 enum class ETextureStyle : uint8
 {
 	COLOR = 0 UMETA(DisplayName = "COLOR"),
 	SEMANTIC = 1 UMETA(DisplayName = "SEMANTIC"),
+	INSTANCE = 2 UMETA(DisplayName = "INSTANCE"),
 };
 
 
@@ -59,6 +75,12 @@ public:
 		const FColor& ClassColor,
 		const bool bSaveTextureMappingAsset = true);
 
+	/**
+	 * Replaces all semantic classes except for the default one with the given name and color pairs,
+	 * nothing is modified if any of the classes is empty or collides with another one
+	*/
+	bool ImportSemanticClasses(const TArray<TPair<FString, FColor>>& Classes);
+
 	/** Gets the class color if it exists */
 	FColor ClassColor(const FString& ClassName);
 
@@ -80,14 +102,39 @@ public:
 	/** Returns array of const pointers to semantic classes */
 	TArray<const FSemanticClass*> SemanticClasses() const;
 
+	/** Returns semantic class ids in ascending order, together with the class colors */
+	void SemanticClassIdColors(TArray<int32>& OutClassIds, TArray<FColor>& OutClassColors) const;
+
+	/** Returns all level actors that have a semantic class assigned */
+	TArray<FLabeledActor> LabeledActors() const;
+
 	/** Applies desired class to all selected actors */
 	void ApplySemanticClassToSelectedActors(const FString& ClassName);
 
-	/** Applies desired class to all selected actors */
-	void ApplySemanticClassToDataTableActors(const FMeshSemanticTableRowBase& DataTableRow);
+	/**
+	 * Applies classes of the data table rows to all level actors with matching static meshes,
+	 * the level is traversed once for the whole table
+	*/
+	void ApplySemanticClassToDataTableActors(const TArray<FMeshSemanticTableRowBase*>& DataTableRows);
 
-	/** Applies desired class to all selected actors */
-	void ApplySemanticClassToTagedActors();
+	/**
+	 * Applies classes named by actor tags to all level actors with these tags,
+	 * using the tags of the first selected actor, or all class names if the whole level is labeled.
+	 * Actors with multiple class tags take the class of the last one in their own tag order
+	*/
+	void ApplySemanticClassToTagedActors(const bool bWholeLevel = false);
+
+	/**
+	 * Applies classes of the highest priority matching rules to all level actors in a single parallel pass,
+	 * the rules are kept to label actors added to the level later on
+	*/
+	void ApplySemanticRules(USemanticRulesAsset* RulesAsset);
+
+	/** Keeps the rules to label actors added to the level later on, without relabeling the existing ones */
+	void SetSemanticRules(USemanticRulesAsset* RulesAsset);
+
+	/** Get the last applied semantic rules asset */
+	USemanticRulesAsset* SemanticRules() const { return SemanticRulesAsset; }
 
 	/** Update mesh materials to show requested texture styles */
 	void CheckoutTextureStyle(const ETextureStyle NewTextureStyle);
@@ -104,6 +151,12 @@ public:
 	/** Export current semantic classes to a CSV file */
 	bool ExportSemanticClasses(const FString& OutputDir);
 
+	/** Assigns instance ids to all level actors and exports them together with actor GUIDs and classes */
+	bool ExportInstanceIds(const FString& OutputDir);
+
+	/** Returns the largest assigned instance id */
+	int32 MaxInstanceId() const;
+
 private:
 	/** Load or create texture mapping asset on startup */
 	void LoadOrCreateTextureMappingAsset();
@@ -120,22 +173,84 @@ private:
 	/** Handles editor closing, making sure original mesh colors are selected */
 	void OnEditorClose();
 
+	/**
+	 * Adds a class without checking for collisions, saving the asset or broadcasting the change
+	 * A new key is assigned unless an existing one is reused
+	*/
+	void AddSemanticClass(const FString& ClassName, const FColor& ClassColor, const int32 ClassKey = 0);
+
+	/** Removes an existing class without saving the asset or broadcasting the change */
+	void RemoveSemanticClassUnchecked(const FString& ClassName);
+
+	/** Binds the actor to the class inside the texture mapping asset and the class actor index */
+	void AssignActorClass(const FGuid& ActorGuid, const int32 ClassKey);
+
+	/** Removes the actor class binding from the texture mapping asset and the class actor index */
+	void UnassignActorClass(const FGuid& ActorGuid);
+
+	/** Rebuilds class names by key and the class actor index from the texture mapping asset */
+	void RebuildClassIndex();
+
+	/** Returns the semantic class with the key, or null if it does not exist */
+	FSemanticClass* FindSemanticClass(const int32 ClassKey);
+
+	/** Returns level actors that have the class assigned, without scanning the level unless needed */
+	TArray<AActor*> ClassActors(const int32 ClassKey);
+
+	/** Refreshes the actor cache with all actors of the current level */
+	void RebuildLevelActorCache();
+
+	/** Returns the class of the highest priority semantic rule the actor matches, or the undefined class */
+	const FString& RuleClassName(const AActor* Actor) const;
+
 	/** Sets a semantic class to the actor */
 	void SetSemanticClassToActor(
 		AActor* Actor,
 		const FString& ClassName,
-		const bool bForceDisplaySemanticClass = false,
-		const bool bDelayAddingDescriptors = false);
+		const bool bForceDisplaySemanticClass = false);
 
 	/** Set active actor texture style to original or semantic color */
 	void CheckoutActorTexture(AActor* Actor, const ETextureStyle NewTextureStyle);
 
-	/** Adds semantic classes to actors in the delay actor buffer after a delay */
+	/**
+	 * Sets semantic classes to buffered actors that waited long enough in a single pass, saving the asset once,
+	 * and reschedules itself for the rest
+	*/
 	void ProcessDelayActorBuffer();
 
+	/** Starts the delay actor buffer timer, unless it is already running */
+	void ScheduleDelayActorBuffer(const float DelaySeconds);
+
+	/** Returns how long just added actors wait before their classes are set */
+	float ActorAddDelaySeconds() const;
+
 	/** Generates the semantic class material if needed and returns it */
 	UMaterialInstanceConstant* GetSemanticClassMaterial(FSemanticClass& SemanticClass);
 
+	/** Returns the actor instance id, assigning a new one if the actor does not have it */
+	int32 InstanceId(AActor* Actor);
+
+	/**
+	 * Sets the actor instance id color to the custom primitive data of its components,
+	 * or restores the default custom primitive data
+	*/
+	void SetActorInstanceColor(AActor* Actor, const bool bShowInstanceId);
+
+	/** Generates the instance material shared by all actors if needed and returns it */
+	UMaterialInstanceConstant* GetInstanceMaterial();
+
+	/** Semantic class names by their keys, kept in sync with the texture mapping asset classes */
+	TMap<int32, FString> ClassNamesByKey;
+
+	/** Semantic class keys by their colors, used to detect color collisions */
+	TMap<FColor, int32> ClassKeysByColor;
+
+	/** Guids of actors bound to each semantic class key, kept in sync with the texture mapping asset bindings */
+	TMap<int32, TSet<FGuid>> ClassActorGuids;
+
+	/** Level actors by their guids, filled as actors are seen and refreshed when a guid cannot be resolved */
+	TMap<FGuid, TWeakObjectPtr<AActor>> LevelActorCache;
+
 	/** Semantic classes updated event dispatcher */
 	FSemanticClassesUpdatedEvent SemanticClassesUpdatedEvent;
 
@@ -143,10 +258,25 @@ private:
 	UPROPERTY()
 	UTextureMappingAsset* TextureMappingAsset;
 
+	/** Rules of the last applied semantic rules asset, used to label newly added actors */
+	UPROPERTY()
+	USemanticRulesAsset* SemanticRulesAsset;
+
 	/** Plain color material used for semantic mesh coloring */
 	UPROPERTY()
 	UMaterial* PlainColorMaterial;
 
+	/**
+	 * Plain color material that reads the color from the custom primitive data,
+	 * so that all actors share a single material instance while showing their own instance id colors
+	*/
+	UPROPERTY()
+	UMaterial* InstanceColorMaterial;
+
+	/** Instance of the instance color material applied to all actors */
+	UPROPERTY()
+	UMaterialInstanceConstant* InstanceMaterialInstance;
+
 	/** Currently selected texture style */
 	ETextureStyle CurrentTextureStyle;
 
@@ -154,12 +284,21 @@ private:
 	UPROPERTY()
 	UTextureBackupManager* TextureBackupManager;
 
+	/** Actor added to the level, waiting for its semantic class to be set */
+	struct FDelayedActor
+	{
+		/** The added actor, which may be deleted before it is processed */
+		TWeakObjectPtr<AActor> Actor;
+
+		/** Application time of the frame the actor was added in */
+		double AddedTime;
+	};
+
 	/**
-	 * Buffer used to store actors that need to have the semantic class set with a delay
-	 * This is needed when immediately setting the undefined class to just spawned actor
+	 * Buffer used to store just added actors in the order they were added, so that actors spawned together
+	 * are labeled in a single pass, and just spawned actors are not immediately repainted in the semantic mode
 	*/
-	UPROPERTY()
-	TArray<AActor*> DelayActorBuffer;
+	TArray<FDelayedActor> DelayActorBuffer;
 
 	/** The handle for the timer that managers DelayActorBuffer */
 	FTimerHandle DelayActorTimerHandle;
@@ -172,4 +311,10 @@ private:
 
 	/** The name of the Undefined semantic class */
 	static const FString UndefinedSemanticClassName;
+
+	/** Largest instance id that can be encoded into an 8-bit RGB color */
+	static const int32 MaxEncodableInstanceId;
+
+	/** Delay before just added actors are repainted when the semantic or instance mode is selected */
+	static const float SemanticActorAddDelaySeconds;
 };
@@ -38,8 +38,14 @@ private:
 	/** Handles render images button click */
 	FReply OnPickSemanticByTagsClicked();
 
+	/** Handles labeling all level actors whose tags name semantic classes */
+	FReply OnPickLevelSemanticByTagsClicked();
+
 	FReply OnPickSemanticByDataTableClicked();
 
+	/** Handles labeling all level actors using the selected semantic rules asset */
+	FReply OnApplySemanticRulesClicked();
+
 	/** Callback function handling the choosing of the semantic class inside the combo box */
 	void OnSemanticClassComboBoxSelectionChanged(TSharedPtr<FString> StringItem, ESelectInfo::Type SelectInfo);
 
@@ -51,11 +57,17 @@ private:
 
 	void OnDataTableSelected(const FAssetData& AssetData) { DataTableAssetData = AssetData; }
 
+	/** Callback function handling the update of the selected semantic rules asset */
+	void OnSemanticRulesSelected(const FAssetData& AssetData) { SemanticRulesAssetData = AssetData; }
+
 	/** Callback function providing the path to the selected sequencer asset */
 	FString GetSequencerPath() const;
 
 	FString GetDataTablePath() const;
 
+	/** Callback function providing the path to the selected semantic rules asset */
+	FString GetSemanticRulesPath() const;
+
 	/** Checks whether renderer target check box should be checked */
 	ECheckBoxState RenderTargetsCheckedState(const FRendererTargetOptions::TargetType TargetType) const;
 
@@ -71,9 +83,24 @@ private:
 	/** Returns the selected output format of the target */
 	FText SelectedOutputFormat(const FRendererTargetOptions::TargetType TargetType) const;
 
+	/** Checks whether the rendering option check box should be checked */
+	ECheckBoxState OptionCheckedState(bool (FRendererTargetOptions::*OptionGetter)() const) const;
+
+	/** Rendering option checkbox handling */
+	void OnOptionChanged(ECheckBoxState NewState, void (FRendererTargetOptions::*OptionSetter)(const bool));
+
+	/** Creates a check box that toggles a rendering option */
+	TSharedRef<SWidget> OptionCheckBox(
+		const FText& CheckBoxText,
+		bool (FRendererTargetOptions::*OptionGetter)() const,
+		void (FRendererTargetOptions::*OptionSetter)(const bool));
+
 	/** Callback function handling the update of the output directory */
 	void OnOutputDirectoryChanged(const FString& Directory) { OutputDirectory = Directory; }
 
+	/** Checks if occlusion masks can be exported, as they are only generated with the derived optical flow */
+	bool GetIsOcclusionMasksEnabled() const;
+
 	/** Checks if render images button should be enabled */
 	bool GetIsRenderImagesEnabled() const;
 
@@ -122,6 +149,9 @@ private:
 
 	FAssetData DataTableAssetData;
 
+	/** Currently selected semantic rules asset data */
+	FAssetData SemanticRulesAssetData;
+
 	/** Widget's copy of the chosen renderer targets set */
 	FRendererTargetOptions SequenceRendererTargets;
 
@@ -23,6 +23,10 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Level Sequence")
 	FSoftObjectPath LevelSequenceAssetPath;
 
+	/** Last applied semantic rules asset, kept to label newly added actors */
+	UPROPERTY(EditAnywhere, Category = "Semantic Rules")
+	FSoftObjectPath SemanticRulesAssetPath;
+
 	/** Whether camera poses are selected */
 	UPROPERTY(EditAnywhere, Category = "Rendering Targets")
 	bool bCameraPosesSelected;
@@ -67,6 +71,14 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Rendering Targets")
 	int8 bSemanticImagesOutputFormat;
 
+	/** Whether instance images are selected */
+	UPROPERTY(EditAnywhere, Category = "Rendering Targets")
+	bool bInstanceImagesSelected;
+
+	/** Output format for instance images */
+	UPROPERTY(EditAnywhere, Category = "Rendering Targets")
+	int8 bInstanceImagesOutputFormat;
+
 	/** Selected depth threashold range */
 	UPROPERTY(EditAnywhere, Category = "Additional parameters")
 	float DepthRange;
@@ -75,6 +87,82 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Additional parameters")
 	float OpticalFlowScale;
 
+	/** Selected EXR tile size, zero for scanline files */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	int32 ExrTileSize;
+
+	/** Whether tiled EXR files contain mip levels */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bExrMipLevels;
+
+	/** Whether EXR targets are combined into a single file per frame */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bCombineExrTargets;
+
+	/** Whether camera poses and intrinsics are embedded into images */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bEmbedFrameMetadata;
+
+	/** Whether semantic images contain class ids instead of class colors */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bSemanticClassIds;
+
+	/** Whether semantic image pixels are snapped to the nearest class color */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bSnapSemanticColors;
+
+	/** Whether per-id bounding boxes and masks are exported for semantic and instance images */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bExportMaskAnnotations;
+
+	/** Whether per-frame bounding boxes of labeled actors are exported */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bExportBoundingBoxes;
+
+	/** Whether optical flow is derived from depth images instead of being rendered */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bOpticalFlowFromDepth;
+
+	/** Whether backward optical flow and occlusion masks are generated with derived optical flow */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bExportOcclusionMasks;
+
+	/** Whether depth images are back-projected into point clouds */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bExportPointClouds;
+
+	/** Whether point clouds are written as .npy arrays instead of PLY files */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bPointCloudsAsNpy;
+
+	/** Whether point clouds of all rig cameras are merged into one per frame */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bMergeRigPointClouds;
+
+	/** Whether a spinning LiDAR is simulated from the rig depth images */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	bool bExportLidar;
+
+	/** Number of simulated LiDAR rings */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	int32 LidarChannels = 32;
+
+	/** Elevation of the highest simulated LiDAR ring in degrees */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	float LidarUpperFovDegrees = 15.0f;
+
+	/** Elevation of the lowest simulated LiDAR ring in degrees */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	float LidarLowerFovDegrees = -25.0f;
+
+	/** Angle between consecutive simulated LiDAR firings in degrees */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	float LidarAzimuthResolutionDegrees = 0.2f;
+
+	/** Range of the simulated LiDAR in meters */
+	UPROPERTY(EditAnywhere, Category = "Additional parameters")
+	float LidarMaxRangeMeters = 100.0f;
+
 	/** Selected output image resolution */
 	UPROPERTY(EditAnywhere, Category = "Additional parameters")
 	FIntPoint OutputImageResolution;